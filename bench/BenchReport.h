@@ -0,0 +1,212 @@
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ColorConvert.h"
+#include "CpuTopology.h"
+
+/**
+ * @class BenchReport
+ * @brief 收集一组基准测试的结果，在标准输出打印文本，并可以写成 JSON 文件用于跟踪性能趋势
+ *
+ * 命令行中的 `--json <path>` 指定 JSON 文件路径，其余参数按顺序作为位置参数，通过 arg() 读取。
+ * JSON 的格式为：
+ *
+ *     {"suite": "rgb2yuv", "timestamp": 1700000000, "cpus": 8, "simd": "avx2",
+ *      "results": [{"name": "rgb2yuv", "params": {"size": "1920x1080", "threads": 4},
+ *                   "metrics": {"fps": 812.5}}]}
+ */
+class BenchReport
+{
+public:
+    /**
+     * @brief 一条测试结果，params 描述测试条件，metrics 为测量值
+     */
+    struct Result
+    {
+        explicit Result(const std::string &name) : name(name) {}
+
+        Result &param(const std::string &key, const std::string &value)
+        {
+            params.emplace_back(key, quote(value));
+            return *this;
+        }
+
+        Result &param(const std::string &key, const char *value)
+        {
+            return param(key, std::string(value));
+        }
+
+        Result &param(const std::string &key, int64_t value)
+        {
+            params.emplace_back(key, std::to_string((long long)value));
+            return *this;
+        }
+
+        Result &param(const std::string &key, int value)
+        {
+            return param(key, (int64_t)value);
+        }
+
+        Result &metric(const std::string &key, double value)
+        {
+            metrics.emplace_back(key, value);
+            return *this;
+        }
+
+        std::string name;
+        std::vector<std::pair<std::string, std::string>> params; // 值已经是 JSON 文本
+        std::vector<std::pair<std::string, double>> metrics;
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * @param suite 测试集名称
+     * @param argc main 的参数个数
+     * @param argv main 的参数
+     */
+    BenchReport(const std::string &suite, int argc, char *argv[]) : suite(suite)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            if (0 == strcmp(argv[i], "--json") && i + 1 < argc)
+                json_path = argv[++i];
+            else
+                args.push_back(argv[i]);
+        }
+    }
+
+    /**
+     * @brief 读取第 index 个位置参数，不存在时返回默认值
+     */
+    int arg(size_t index, int default_value) const
+    {
+        return index < args.size() ? atoi(args[index].c_str()) : default_value;
+    }
+
+    /**
+     * @brief 读取第 index 个位置参数的原始字符串，不存在时返回默认值
+     */
+    std::string argString(size_t index, const std::string &default_value = std::string()) const
+    {
+        return index < args.size() ? args[index] : default_value;
+    }
+
+    /**
+     * @brief 记录一条结果，同时以 key=value 的形式打印到标准输出
+     */
+    void add(const Result &result)
+    {
+        std::cout << result.name;
+        for (auto &p : result.params)
+            std::cout << " " << p.first << "=" << unquote(p.second);
+        for (auto &m : result.metrics)
+            std::cout << " " << m.first << "=" << m.second;
+        std::cout << std::endl;
+        results.push_back(result);
+    }
+
+    /**
+     * @brief 生成 JSON 文本
+     */
+    std::string toJson() const
+    {
+        std::string out = "{\"suite\": " + quote(suite) +
+                          ", \"timestamp\": " + std::to_string((long long)time(NULL)) +
+                          ", \"cpus\": " + std::to_string(CpuTopology::get().usable_cpus) +
+                          ", \"simd\": " + quote(ColorConvert::getSimdLevelName(ColorConvert::detectSimdLevel())) +
+                          ", \"results\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &r = results[i];
+            out += i ? ",\n  " : "\n  ";
+            out += "{\"name\": " + quote(r.name) + ", \"params\": {";
+            for (size_t j = 0; j < r.params.size(); ++j)
+                out += (j ? ", " : "") + quote(r.params[j].first) + ": " + r.params[j].second;
+            out += "}, \"metrics\": {";
+            for (size_t j = 0; j < r.metrics.size(); ++j)
+                out += (j ? ", " : "") + quote(r.metrics[j].first) + ": " + number(r.metrics[j].second);
+            out += "}}";
+        }
+        out += "\n]}\n";
+        return out;
+    }
+
+    /**
+     * @brief 指定了 --json 时写入 JSON 文件
+     *
+     * @return bool 未指定路径或写入成功时返回 true
+     */
+    bool finish() const
+    {
+        if (json_path.empty())
+            return true;
+        FILE *fp = fopen(json_path.c_str(), "w");
+        if (fp == NULL)
+        {
+            std::cerr << "open " << json_path << " failed" << std::endl;
+            return false;
+        }
+        std::string text = toJson();
+        bool ok = fwrite(text.data(), 1, text.size(), fp) == text.size();
+        ok = 0 == fclose(fp) && ok;
+        if (!ok)
+            std::cerr << "write " << json_path << " failed" << std::endl;
+        return ok;
+    }
+
+private:
+    static std::string quote(const std::string &value)
+    {
+        std::string out = "\"";
+        for (char c : value)
+        {
+            if ('"' == c || '\\' == c)
+                out += '\\';
+            if ((unsigned char)c < 0x20)
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+                continue;
+            }
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    static std::string unquote(const std::string &value)
+    {
+        if (value.size() >= 2 && '"' == value.front())
+            return value.substr(1, value.size() - 2);
+        return value;
+    }
+
+    // JSON 不能表示 NaN 和无穷大
+    static std::string number(double value)
+    {
+        if (!std::isfinite(value))
+            return "null";
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.9g", value);
+        return buf;
+    }
+
+    std::string suite;
+    std::string json_path;
+    std::vector<std::string> args;
+    std::vector<Result> results;
+};
+
+#endif // BENCHREPORT_H
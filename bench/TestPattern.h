@@ -0,0 +1,76 @@
+#ifndef TESTPATTERN_H
+#define TESTPATTERN_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 生成合成测试画面，基准测试不依赖任何媒体文件即可离线运行
+ *
+ * 画面类似 lavfi 的 testsrc：上半部分是彩条，下半部分是渐变，另有一个随帧序号移动的方块，
+ * 相邻帧之间有运动，编码器的耗时和码率比静止画面或随机噪声更接近真实视频。
+ */
+namespace TestPattern
+{
+
+/**
+ * @brief 生成第 index 帧 RGB24 画面
+ *
+ * @param rgb 输出缓冲区，至少 width * height * 3 字节
+ * @param width 宽度
+ * @param height 高度
+ * @param index 帧序号，决定方块的位置和渐变的相位
+ */
+inline void fillRgb24(uint8_t *rgb, int width, int height, int index)
+{
+    static const uint8_t bars[8][3] = {{255, 255, 255}, {255, 255, 0}, {0, 255, 255}, {0, 255, 0},
+                                       {255, 0, 255}, {255, 0, 0}, {0, 0, 255}, {0, 0, 0}};
+    const int box = height / 6 > 0 ? height / 6 : 1;
+    const int box_x = (index * 8) % (width > box ? width - box : 1);
+    const int box_y = height / 2 + (index * 3) % (height / 2 > box ? height / 2 - box : 1);
+    for (int y = 0; y < height; ++y)
+    {
+        uint8_t *row = rgb + (size_t)y * width * 3;
+        for (int x = 0; x < width; ++x)
+        {
+            uint8_t *p = row + (size_t)x * 3;
+            if (x >= box_x && x < box_x + box && y >= box_y && y < box_y + box)
+            {
+                p[0] = 255;
+                p[1] = (uint8_t)(index * 5);
+                p[2] = 32;
+            }
+            else if (y < height / 2)
+            {
+                const uint8_t *c = bars[x * 8 / width];
+                p[0] = c[0];
+                p[1] = c[1];
+                p[2] = c[2];
+            }
+            else
+            {
+                p[0] = (uint8_t)((x + index * 4) * 255 / (width + 1));
+                p[1] = (uint8_t)(y * 255 / height);
+                p[2] = (uint8_t)((x + y + index * 2) & 0xff);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 生成 count 帧连续的 RGB24 画面，测试中循环使用
+ */
+inline std::vector<std::vector<uint8_t>> makeRgb24Frames(int width, int height, int count)
+{
+    std::vector<std::vector<uint8_t>> frames(count > 0 ? count : 1);
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        frames[i].resize((size_t)width * height * 3);
+        fillRgb24(frames[i].data(), width, height, (int)i);
+    }
+    return frames;
+}
+
+} // namespace TestPattern
+
+#endif // TESTPATTERN_H
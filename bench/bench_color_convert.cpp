@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "BenchReport.h"
+#include "ColorConvert.h"
+
+extern "C"
+{
+#include <libswscale/swscale.h>
+}
+
+using namespace ColorConvert;
+
+/**
+ * @brief 紧密排列的 YUV420P 图像
+ */
+struct Yuv420Image
+{
+    Yuv420Image(int width, int height)
+        : width(width), height(height), chroma_width((width + 1) / 2), chroma_height((height + 1) / 2),
+          data((size_t)width * height + (size_t)chroma_width * chroma_height * 2, 0)
+    {
+        planes[0] = data.data();
+        planes[1] = planes[0] + (size_t)width * height;
+        planes[2] = planes[1] + (size_t)chroma_width * chroma_height;
+        strides[0] = width;
+        strides[1] = chroma_width;
+        strides[2] = chroma_width;
+    }
+
+    int width, height, chroma_width, chroma_height;
+    std::vector<uint8_t> data;
+    uint8_t *planes[3];
+    int strides[3];
+};
+
+static std::vector<uint8_t> make_noise_rgb(int width, int height)
+{
+    std::vector<uint8_t> rgb((size_t)width * height * 3);
+    srand(width * 131 + height);
+    for (auto &c : rgb)
+        c = (uint8_t)rand();
+    return rgb;
+}
+
+// 平滑的渐变图像，接近真实画面，用于和 swscale 比较
+static std::vector<uint8_t> make_gradient_rgb(int width, int height)
+{
+    std::vector<uint8_t> rgb((size_t)width * height * 3);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            uint8_t *p = &rgb[((size_t)y * width + x) * 3];
+            p[0] = (uint8_t)(x * 255 / width);
+            p[1] = (uint8_t)(y * 255 / height);
+            p[2] = (uint8_t)((x + y) * 127 / (width + height) + 64);
+        }
+    }
+    return rgb;
+}
+
+static bool sws_convert(const std::vector<uint8_t> &rgb, Yuv420Image &out, SwsContext *sc)
+{
+    const uint8_t *src[1] = {rgb.data()};
+    int stride[1] = {out.width * 3};
+    return sws_scale(sc, src, stride, 0, out.height, out.planes, out.strides) > 0;
+}
+
+static int max_diff(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    int diff = 0;
+    for (size_t i = 0; i < n; ++i)
+        diff = std::max(diff, std::abs((int)a[i] - (int)b[i]));
+    return diff;
+}
+
+/**
+ * @brief 校验各指令集实现与标量实现逐字节一致，包括奇数宽高和不足一个向量宽度的尺寸
+ */
+static bool validate_simd()
+{
+    const int sizes[][2] = {{1920, 1080}, {1919, 1081}, {130, 7}, {64, 2}, {37, 5}, {3, 3}, {1, 1}};
+    bool ok = true;
+    for (auto &size : sizes)
+    {
+        const int width = size[0], height = size[1];
+        std::vector<uint8_t> rgb = make_noise_rgb(width, height);
+        Yuv420Image ref(width, height);
+        rgb24ToYuv420p(SIMD_NONE, rgb.data(), width * 3, ref.planes, ref.strides, width, height);
+        for (int level = SIMD_SSE41; level <= SIMD_NEON; ++level)
+        {
+            Yuv420Image out(width, height);
+            memset(out.data.data(), 0xAA, out.data.size());
+            if (!rgb24ToYuv420p((SimdLevel)level, rgb.data(), width * 3, out.planes, out.strides, width, height))
+                continue;
+            bool same = out.data == ref.data;
+            ok = ok && same;
+            std::cout << "validate size=" << width << "x" << height
+                      << " simd=" << getSimdLevelName((SimdLevel)level)
+                      << " bit_exact=" << (same ? "yes" : "NO") << std::endl;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief 校验整数倍缩小转换的各指令集实现与标量实现逐字节一致
+ */
+static bool validate_downscale()
+{
+    const int sizes[][2] = {{960, 540}, {959, 541}, {65, 7}, {33, 2}, {17, 3}, {1, 1}};
+    const int factors[] = {2, 4};
+    bool ok = true;
+    for (int factor : factors)
+    {
+        for (auto &size : sizes)
+        {
+            const int width = size[0], height = size[1];
+            std::vector<uint8_t> rgb = make_noise_rgb(width * factor, height * factor);
+            const int rgb_stride = width * factor * 3;
+            Yuv420Image ref(width, height);
+            rgb24DownscaleToYuv420p(SIMD_NONE, factor, rgb.data(), rgb_stride, ref.planes, ref.strides, width, height);
+            for (int level = SIMD_SSE41; level <= SIMD_NEON; ++level)
+            {
+                Yuv420Image out(width, height);
+                memset(out.data.data(), 0xAA, out.data.size());
+                if (!rgb24DownscaleToYuv420p((SimdLevel)level, factor, rgb.data(), rgb_stride, out.planes, out.strides, width, height))
+                    continue;
+                bool same = out.data == ref.data;
+                ok = ok && same;
+                std::cout << "validate_downscale factor=" << factor
+                          << " size=" << width << "x" << height
+                          << " simd=" << getSimdLevelName((SimdLevel)level)
+                          << " bit_exact=" << (same ? "yes" : "NO") << std::endl;
+            }
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief 与 swscale（SWS_BICUBIC）比较
+ *
+ * 平滑图像上 Y、U、V 的误差都不超过 1。随机噪声图像的色度误差更大，
+ * 因为本内核用 2x2 均值下采样色度，而 swscale 在垂直方向使用多抽头滤波，只作为参考输出。
+ * 由于这一差异，XMediaEncode 默认不使用本内核（useSimdConvert 为 false）。
+ */
+static bool validate_against_sws(int width, int height)
+{
+    SwsContext *sc = sws_getContext(width, height, AV_PIX_FMT_RGB24, width, height, AV_PIX_FMT_YUV420P,
+                                    SWS_BICUBIC, 0, 0, 0);
+    if (!sc)
+    {
+        std::cerr << "sws_getContext failed" << std::endl;
+        return false;
+    }
+    bool ok = true;
+    const char *names[] = {"gradient", "noise"};
+    for (int i = 0; i < 2; ++i)
+    {
+        std::vector<uint8_t> rgb = 0 == i ? make_gradient_rgb(width, height) : make_noise_rgb(width, height);
+        Yuv420Image ref(width, height), out(width, height);
+        sws_convert(rgb, ref, sc);
+        rgb24ToYuv420p(rgb.data(), width * 3, out.planes, out.strides, width, height);
+        const size_t luma_size = (size_t)width * height;
+        int luma_diff = max_diff(ref.data.data(), out.data.data(), luma_size);
+        int chroma_diff = max_diff(ref.data.data() + luma_size, out.data.data() + luma_size, ref.data.size() - luma_size);
+        std::cout << "compare_sws image=" << names[i]
+                  << " size=" << width << "x" << height
+                  << " max_luma_diff=" << luma_diff
+                  << " max_chroma_diff=" << chroma_diff << std::endl;
+        if (0 == i)
+            ok = luma_diff <= 1 && chroma_diff <= 1;
+        else
+            ok = ok && luma_diff <= 1;
+    }
+    sws_freeContext(sc);
+    return ok;
+}
+
+template <typename Fn>
+static double measure_fps(int frame_count, Fn fn)
+{
+    // 预热一帧
+    fn();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < frame_count; ++i)
+        fn();
+    auto end = std::chrono::steady_clock::now();
+    return frame_count / std::chrono::duration<double>(end - begin).count();
+}
+
+static void bench_size(BenchReport &report, int width, int height, int frame_count)
+{
+    std::vector<uint8_t> rgb = make_gradient_rgb(width, height);
+    Yuv420Image out(width, height);
+
+    SwsContext *sc = sws_getContext(width, height, AV_PIX_FMT_RGB24, width, height, AV_PIX_FMT_YUV420P,
+                                    SWS_BICUBIC, 0, 0, 0);
+    double sws_fps = measure_fps(frame_count, [&]() { sws_convert(rgb, out, sc); });
+    sws_freeContext(sc);
+    const std::string size = std::to_string(width) + "x" + std::to_string(height);
+    report.add(BenchReport::Result("convert").param("size", size).param("impl", "sws_bicubic").metric("fps", sws_fps));
+
+    for (int level = SIMD_NONE; level <= SIMD_NEON; ++level)
+    {
+        if (!isSupported((SimdLevel)level))
+            continue;
+        double fps = measure_fps(frame_count, [&]() {
+            rgb24ToYuv420p((SimdLevel)level, rgb.data(), width * 3, out.planes, out.strides, width, height);
+        });
+        report.add(BenchReport::Result("convert")
+                       .param("size", size)
+                       .param("impl", getSimdLevelName((SimdLevel)level))
+                       .metric("fps", fps)
+                       .metric("speedup_vs_sws", fps / sws_fps));
+    }
+}
+
+/**
+ * @brief 比较融合的整数倍缩小转换与 swscale 的缩放转换
+ *
+ * 两者的滤波器不同（盒式 / 双三次），输出只在平滑区域接近，这里只比较速度。
+ */
+static void bench_downscale(BenchReport &report, int src_width, int src_height, int factor, int frame_count)
+{
+    const int width = src_width / factor, height = src_height / factor;
+    std::vector<uint8_t> rgb = make_gradient_rgb(src_width, src_height);
+    Yuv420Image out(width, height);
+
+    SwsContext *sc = sws_getContext(src_width, src_height, AV_PIX_FMT_RGB24, width, height, AV_PIX_FMT_YUV420P,
+                                    SWS_BICUBIC, 0, 0, 0);
+    const uint8_t *src[1] = {rgb.data()};
+    int stride[1] = {src_width * 3};
+    double sws_fps = measure_fps(frame_count, [&]() { sws_scale(sc, src, stride, 0, src_height, out.planes, out.strides); });
+    sws_freeContext(sc);
+    const std::string src_size = std::to_string(src_width) + "x" + std::to_string(src_height);
+    report.add(BenchReport::Result("downscale")
+                   .param("src", src_size)
+                   .param("factor", factor)
+                   .param("impl", "sws_bicubic")
+                   .metric("fps", sws_fps));
+
+    for (int level = SIMD_NONE; level <= SIMD_NEON; ++level)
+    {
+        if (!isSupported((SimdLevel)level))
+            continue;
+        double fps = measure_fps(frame_count, [&]() {
+            rgb24DownscaleToYuv420p((SimdLevel)level, factor, rgb.data(), src_width * 3, out.planes, out.strides, width, height);
+        });
+        report.add(BenchReport::Result("downscale")
+                       .param("src", src_size)
+                       .param("factor", factor)
+                       .param("impl", std::string("fused_") + getSimdLevelName((SimdLevel)level))
+                       .metric("fps", fps)
+                       .metric("speedup_vs_sws", fps / sws_fps));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    BenchReport report("color_convert", argc, argv);
+    int frame_count = report.arg(0, 200);
+    std::cout << "detected simd=" << getSimdLevelName(detectSimdLevel()) << std::endl;
+
+    bool ok = validate_simd();
+    ok = validate_downscale() && ok;
+    ok = validate_against_sws(1280, 720) && ok;
+    if (!ok)
+    {
+        std::cerr << "validation failed" << std::endl;
+        return 1;
+    }
+
+    const int sizes[][2] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+    for (auto &size : sizes)
+        bench_size(report, size[0], size[1], frame_count);
+    for (auto &size : sizes)
+    {
+        bench_downscale(report, size[0], size[1], 2, frame_count);
+        bench_downscale(report, size[0], size[1], 4, frame_count);
+    }
+    return report.finish() ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BenchReport.h"
+#include "TestPattern.h"
+#include "XMediaEncode.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * @brief 测量不同预设下 encodeVideo 的吞吐量、单帧耗时和码率
+ *
+ * 输入为合成的测试画面，每帧先用 rgb2yuv 转换，只统计 encodeVideo 的耗时，
+ * 最后冲刷编码器，码率包含冲刷出的数据包。选中硬件编码器时预设不生效，结果中的 codec 会标明实际使用的编码器。
+ */
+static void bench_preset(BenchReport &report, int width, int height, const char *preset, int frame_count)
+{
+    std::unique_ptr<XMediaEncode> xe(XMediaEncode::create());
+    xe->inWidth = xe->outWidth = width;
+    xe->inHeight = xe->outHeight = height;
+    xe->preset = preset;
+    if (!xe->initScale() || !xe->initVideoCodec())
+    {
+        std::cerr << "init encoder failed: " << xe->getLastError() << std::endl;
+        return;
+    }
+
+    auto frames = TestPattern::makeRgb24Frames(width, height, xe->fps);
+    std::vector<double> frame_ms;
+    frame_ms.reserve(frame_count);
+    std::vector<AVPacket *> packets;
+    int64_t total_bytes = 0;
+    int64_t packet_count = 0;
+    auto drain = [&]() {
+        for (AVPacket *pkt : packets)
+        {
+            total_bytes += pkt->size;
+            ++packet_count;
+            av_packet_free(&pkt);
+        }
+        packets.clear();
+    };
+
+    for (int i = 0; i < frame_count; ++i)
+    {
+        AVFrame *yuv = xe->rgb2yuv((char *)frames[i % frames.size()].data());
+        auto begin = std::chrono::steady_clock::now();
+        bool ok = yuv && xe->encodeVideo(yuv, (int64_t)i * 1000000 / xe->fps, packets);
+        auto end = std::chrono::steady_clock::now();
+        if (!ok)
+        {
+            std::cerr << "encodeVideo failed: " << xe->getLastError() << std::endl;
+            drain();
+            return;
+        }
+        frame_ms.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+        drain();
+    }
+    auto flush_begin = std::chrono::steady_clock::now();
+    xe->flushVideo(packets);
+    double flush_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - flush_begin).count();
+    drain();
+
+    double total_ms = flush_ms;
+    for (double ms : frame_ms)
+        total_ms += ms;
+    std::sort(frame_ms.begin(), frame_ms.end());
+    const char *codec_name = xe->vc && xe->vc->codec ? xe->vc->codec->name : "unknown";
+    double duration_s = (double)frame_count / xe->fps;
+    report.add(BenchReport::Result("encode")
+                   .param("size", std::to_string(width) + "x" + std::to_string(height))
+                   .param("preset", preset)
+                   .param("codec", codec_name)
+                   .param("frames", frame_count)
+                   .metric("fps", frame_count * 1000.0 / total_ms)
+                   .metric("frame_p50_ms", frame_ms[frame_ms.size() / 2])
+                   .metric("frame_p99_ms", frame_ms[frame_ms.size() * 99 / 100])
+                   .metric("packets", (double)packet_count)
+                   .metric("bitrate_kbps", total_bytes * 8 / duration_s / 1000));
+    xe->close();
+}
+
+int main(int argc, char *argv[])
+{
+    BenchReport report("encode", argc, argv);
+    int frame_count = std::max(1, report.arg(0, 100));
+    const int sizes[][2] = {{1280, 720}, {1920, 1080}};
+    const char *presets[] = {"ultrafast", "superfast", "veryfast", "faster", "medium"};
+    for (auto &size : sizes)
+    {
+        for (const char *preset : presets)
+            bench_preset(report, size[0], size[1], preset, frame_count);
+    }
+    return report.finish() ? 0 : 1;
+}
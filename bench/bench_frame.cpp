@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "BenchReport.h"
+#include "FrameBufferPool.h"
+#include "FramePtrWrapper.h"
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+// 防止编译器把被测操作当作无用代码消除
+static volatile int64_t g_sink = 0;
+
+template <typename Fn>
+static double measure_ns(int iterations, Fn fn)
+{
+    fn(0);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        fn(i);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+
+/**
+ * @brief 测量打包数据（单块缓冲区）的分配、拷贝和移动开销
+ *
+ * 拷贝和移动都只操作引用计数，耗时应与帧大小无关；分配的耗时随帧大小增长，
+ * 使用缓冲池可以省去大帧的 malloc 和缺页开销。
+ */
+static void bench_packed(BenchReport &report, const char *label, int byte_size, int iterations)
+{
+    std::vector<uint8_t> src((size_t)byte_size, 0x5a);
+    FrameBufferPool pool(byte_size, 4);
+    auto add = [&](const char *op, double ns) {
+        report.add(BenchReport::Result("frame").param("size", label).param("bytes", byte_size).param("op", op)
+                       .metric("ns_per_op", ns));
+    };
+
+    add("alloc_copy", measure_ns(iterations, [&](int i) {
+        FramePtrWrapper frame(src.data(), byte_size, i);
+        g_sink += frame.getTimestamp();
+    }));
+    add("pool_alloc_copy", measure_ns(iterations, [&](int i) {
+        FramePtrWrapper frame(pool, src.data(), byte_size, i);
+        g_sink += frame.getTimestamp();
+    }));
+    add("pool_alloc", measure_ns(iterations, [&](int i) {
+        FramePtrWrapper frame(pool, i);
+        g_sink += frame.getTimestamp();
+    }));
+
+    FramePtrWrapper frame(pool, src.data(), byte_size, 0);
+    add("copy", measure_ns(iterations, [&](int) {
+        FramePtrWrapper copy(frame);
+        g_sink += copy.getTimestamp();
+    }));
+    add("move", measure_ns(iterations, [&](int) {
+        FramePtrWrapper moved(std::move(frame));
+        frame = std::move(moved);
+        g_sink += frame.getTimestamp();
+    }));
+    // 共享的缓冲区需要深拷贝一份才能修改
+    add("copy_make_writable", measure_ns(iterations, [&](int) {
+        FramePtrWrapper copy(frame);
+        copy.makeWritable();
+        g_sink += copy.getTimestamp();
+    }));
+}
+
+/**
+ * @brief 测量引用原生 AVFrame 的开销，只增加各平面缓冲区的引用计数
+ */
+static void bench_native(BenchReport &report, const char *label, int width, int height, int iterations)
+{
+    AVFrame *src = av_frame_alloc();
+    if (src)
+    {
+        src->format = AV_PIX_FMT_YUV420P;
+        src->width = width;
+        src->height = height;
+    }
+    if (!src || av_frame_get_buffer(src, 0) < 0)
+    {
+        std::cerr << "av_frame_get_buffer failed" << std::endl;
+        av_frame_free(&src);
+        return;
+    }
+    double ns = measure_ns(iterations, [&](int i) {
+        FramePtrWrapper frame((const AVFrame *)src, (int64_t)i);
+        g_sink += frame.getTimestamp();
+    });
+    report.add(BenchReport::Result("frame").param("size", label).param("format", "yuv420p").param("op", "wrap_avframe")
+                   .metric("ns_per_op", ns));
+    av_frame_free(&src);
+}
+
+int main(int argc, char *argv[])
+{
+    BenchReport report("frame", argc, argv);
+    int iterations = report.arg(0, 1000000);
+    // 大帧的分配和深拷贝慢几个数量级，相应减少次数
+    int large_iterations = std::max(100, iterations / 1000);
+    bench_packed(report, "64B", 64, iterations);
+    bench_packed(report, "1920x1080_rgb24", 1920 * 1080 * 3, large_iterations);
+    bench_native(report, "1920x1080", 1920, 1080, iterations);
+    return report.finish() ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BenchReport.h"
+#include "TestPattern.h"
+#include "XMediaEncode.h"
+#include "XRtmp.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * @brief 预先编码好的一组数据包，封装测试中循环发送，排除编码本身的耗时
+ */
+struct EncodedClip
+{
+    std::unique_ptr<XMediaEncode> encoder;
+    std::vector<AVPacket *> packets;
+    int64_t duration = 0; ///< 整段的时长，单位与编码器时间基准相同（微秒）
+
+    ~EncodedClip()
+    {
+        for (AVPacket *pkt : packets)
+            av_packet_free(&pkt);
+    }
+};
+
+static bool encode_clip(EncodedClip &clip, int width, int height, int frame_count)
+{
+    clip.encoder.reset(XMediaEncode::create());
+    XMediaEncode *xe = clip.encoder.get();
+    xe->inWidth = xe->outWidth = width;
+    xe->inHeight = xe->outHeight = height;
+    xe->preset = "ultrafast";
+    if (!xe->initScale() || !xe->initVideoCodec())
+    {
+        std::cerr << "init encoder failed: " << xe->getLastError() << std::endl;
+        return false;
+    }
+    auto frames = TestPattern::makeRgb24Frames(width, height, frame_count);
+    for (int i = 0; i < frame_count; ++i)
+    {
+        AVFrame *yuv = xe->rgb2yuv((char *)frames[i].data());
+        if (!yuv || !xe->encodeVideo(yuv, (int64_t)i * 1000000 / xe->fps, clip.packets))
+        {
+            std::cerr << "encodeVideo failed: " << xe->getLastError() << std::endl;
+            return false;
+        }
+    }
+    xe->flushVideo(clip.packets);
+    clip.duration = (int64_t)frame_count * 1000000 / xe->fps;
+    return !clip.packets.empty();
+}
+
+/**
+ * @brief 测量 sendFrame 写入本地文件的开销
+ *
+ * 同步模式下 sendFrame 直接写文件，异步模式下只入队，由写入线程写文件。
+ * send_ns_per_packet 是调用方看到的 sendFrame 耗时，total 包含 close() 写完队列和封装尾的时间。
+ */
+static void bench_output(BenchReport &report, const EncodedClip &clip, const std::string &path, bool async,
+                         int packet_count)
+{
+    std::unique_ptr<XRtmp> xr(XRtmp::create());
+    int stream_index = -1;
+    if (!xr->init(path.c_str()) || -1 == (stream_index = xr->addStream(clip.encoder->vc)) || !xr->sendHead() ||
+        (async && !xr->startAsync(8 * 1024 * 1024, XRtmp::BlockProducer)))
+    {
+        std::cerr << path << " muxer error: " << xr->getLastError() << std::endl;
+        return;
+    }
+
+    AVPacket *pkt = av_packet_alloc();
+    int64_t total_bytes = 0;
+    int sent = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < packet_count; ++i)
+    {
+        const AVPacket *src = clip.packets[i % clip.packets.size()];
+        // 循环发送时平移时间戳，保证输出的时间戳单调递增
+        const int64_t offset = (int64_t)(i / clip.packets.size()) * clip.duration;
+        if (av_packet_ref(pkt, src) < 0)
+            break;
+        pkt->pts = src->pts + offset;
+        pkt->dts = src->dts + offset;
+        total_bytes += pkt->size;
+        if (xr->sendFrame(pkt, stream_index))
+            ++sent;
+    }
+    auto send_end = std::chrono::steady_clock::now();
+    XRtmp::WriterStats stats = xr->getWriterStats();
+    xr->close();
+    auto end = std::chrono::steady_clock::now();
+    av_packet_free(&pkt);
+    remove(path.c_str());
+
+    double send_ns = std::chrono::duration<double, std::nano>(send_end - begin).count();
+    double total_s = std::chrono::duration<double>(end - begin).count();
+    BenchReport::Result result("mux");
+    result.param("format", path.substr(path.rfind('.') + 1))
+        .param("mode", async ? "async" : "sync")
+        .param("packets", packet_count)
+        .metric("sent", sent)
+        .metric("send_ns_per_packet", send_ns / std::max(1, packet_count))
+        .metric("total_ns_per_packet", total_s * 1e9 / std::max(1, packet_count))
+        .metric("mb_per_s", total_bytes / total_s / (1024 * 1024));
+    if (async)
+        result.metric("producer_stall_ms", stats.producer_stall_us / 1000.0);
+    report.add(result);
+}
+
+int main(int argc, char *argv[])
+{
+    BenchReport report("mux", argc, argv);
+    int packet_count = std::max(1, report.arg(0, 20000));
+    EncodedClip clip;
+    if (!encode_clip(clip, 1280, 720, 50))
+        return 1;
+    const char *formats[] = {"flv", "mp4", "ts"};
+    for (const char *format : formats)
+    {
+        const std::string path = std::string("bench_mux_output.") + format;
+        bench_output(report, clip, path, false, packet_count);
+        bench_output(report, clip, path, true, packet_count);
+    }
+    return report.finish() ? 0 : 1;
+}
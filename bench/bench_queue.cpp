@@ -0,0 +1,86 @@
+#include <chrono>
+#include <iostream>
+
+#include "BenchReport.h"
+#include "ThreadProvider.h"
+
+/**
+ * @brief 队列微基准测试使用的生产者
+ *
+ * 线程中连续推入 frame_count 个来自缓冲池的小帧，队列满时等待消费者，保证不丢帧，
+ * 从而只测量队列本身的入队、出队和唤醒开销。
+ */
+class BenchQueueProvider : public ThreadProvider
+{
+public:
+    BenchQueueProvider(QueueBackend backend, int queue_len, int frame_count, int frame_bytes)
+        : frame_count(frame_count)
+    {
+        setQueueBackend(backend);
+        setMaxQueueLength(queue_len);
+        frame_pool.reset(frame_bytes, queue_len + POOL_SLACK);
+    }
+
+    void run()
+    {
+        for (int i = 0; i < frame_count && !is_exit; ++i)
+        {
+            FramePtrWrapper frame(frame_pool, i);
+            if (!waitForSpace(max_queue_len - 1))
+                break;
+            push(std::move(frame));
+        }
+    }
+
+private:
+    int frame_count = 0;
+};
+
+static double bench_backend(ThreadProvider::QueueBackend backend, int queue_len, int frame_count, int frame_bytes)
+{
+    BenchQueueProvider provider(backend, queue_len, frame_count, frame_bytes);
+    auto begin = std::chrono::steady_clock::now();
+    provider.start();
+    int received = 0;
+    int64_t last_ts = -1;
+    FramePtrWrapper frame;
+    while (received < frame_count)
+    {
+        if (!provider.pop(frame))
+        {
+            provider.waitForData(100);
+            continue;
+        }
+        if (frame.getTimestamp() != last_ts + 1)
+            std::cerr << "out of order frame: " << frame.getTimestamp() << std::endl;
+        last_ts = frame.getTimestamp();
+        ++received;
+    }
+    auto end = std::chrono::steady_clock::now();
+    provider.stop();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / frame_count;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchReport report("queue", argc, argv);
+    int frame_count = report.arg(0, 1000000);
+    const int queue_lens[] = {4, 100, 1024};
+    for (int queue_len : queue_lens)
+    {
+        double list_ns = bench_backend(ThreadProvider::ListQueue, queue_len, frame_count, 64);
+        double ring_ns = bench_backend(ThreadProvider::RingQueue, queue_len, frame_count, 64);
+        report.add(BenchReport::Result("push_pop")
+                       .param("backend", "list_mutex")
+                       .param("queue_len", queue_len)
+                       .param("frames", frame_count)
+                       .metric("ns_per_frame", list_ns));
+        report.add(BenchReport::Result("push_pop")
+                       .param("backend", "spsc_ring")
+                       .param("queue_len", queue_len)
+                       .param("frames", frame_count)
+                       .metric("ns_per_frame", ring_ns)
+                       .metric("speedup_vs_list", list_ns / ring_ns));
+    }
+    return report.finish() ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "BenchReport.h"
+#include "TestPattern.h"
+#include "XMediaEncode.h"
+
+/**
+ * @brief 测量 rgb2yuv 在不同线程数下的吞吐量
+ *
+ * 使用合成的测试画面，线程数大于 1 时按输出行带并行转换。
+ */
+static double bench_rgb2yuv(int width, int height, int threads, int frame_count)
+{
+    XMediaEncode *xe = XMediaEncode::getInstance(0);
+    xe->close();
+    xe->inWidth = xe->outWidth = width;
+    xe->inHeight = xe->outHeight = height;
+    xe->scaleThreads = threads;
+    if (!xe->initScale())
+    {
+        std::cerr << "initScale failed: " << xe->getLastError() << std::endl;
+        return 0;
+    }
+
+    auto frames = TestPattern::makeRgb24Frames(width, height, 4);
+
+    // 预热一帧，排除首次分配的开销
+    xe->rgb2yuv((char *)frames[0].data());
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < frame_count; ++i)
+    {
+        if (!xe->rgb2yuv((char *)frames[i % frames.size()].data()))
+        {
+            std::cerr << "rgb2yuv failed" << std::endl;
+            return 0;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    xe->close();
+    return frame_count / std::chrono::duration<double>(end - begin).count();
+}
+
+int main(int argc, char *argv[])
+{
+    BenchReport report("rgb2yuv", argc, argv);
+    int frame_count = report.arg(0, 100);
+    const int sizes[][2] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+    const int thread_counts[] = {1, 2, 4, 8};
+    for (auto &size : sizes)
+    {
+        double base_fps = 0;
+        for (int threads : thread_counts)
+        {
+            double fps = bench_rgb2yuv(size[0], size[1], threads, frame_count);
+            if (1 == threads)
+                base_fps = fps;
+            report.add(BenchReport::Result("rgb2yuv")
+                           .param("size", std::to_string(size[0]) + "x" + std::to_string(size[1]))
+                           .param("threads", threads)
+                           .metric("fps", fps)
+                           .metric("speedup", base_fps > 0 ? fps / base_fps : 0));
+        }
+    }
+    return report.finish() ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BenchReport.h"
+#include "TestPattern.h"
+#include "Utils.h"
+#include "FileVideoProvider.h"
+#include "XMediaEncode.h"
+#include "XRtmp.h"
+#include "Pipeline.h"
+#include "PacketPtr.h"
+#include "SegmentTranscoder.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+static const char *FIXTURE_PATH = "bench_transcode_input.mp4";
+static const char *OUTPUT_PATH = "bench_transcode_output.mp4";
+
+/**
+ * @brief 把合成的测试画面编码成 H.264 的 MP4 文件，作为没有指定输入文件时的测试素材
+ */
+static bool make_fixture(const char *path, int width, int height, int frame_count)
+{
+    std::unique_ptr<XMediaEncode> xe(XMediaEncode::create());
+    xe->inWidth = xe->outWidth = width;
+    xe->inHeight = xe->outHeight = height;
+    xe->bitrate = 8000000;
+    xe->preset = "ultrafast";
+    std::unique_ptr<XRtmp> xr(XRtmp::create());
+    int stream_index = -1;
+    if (!xe->initScale() || !xe->initVideoCodec())
+    {
+        std::cerr << "fixture encoder error: " << xe->getLastError() << std::endl;
+        return false;
+    }
+    if (!xr->init(path) || -1 == (stream_index = xr->addStream(xe->vc)) || !xr->sendHead())
+    {
+        std::cerr << "fixture muxer error: " << xr->getLastError() << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> rgb((size_t)width * height * 3);
+    std::vector<AVPacket *> packets;
+    bool ok = true;
+    for (int i = 0; i < frame_count && ok; ++i)
+    {
+        TestPattern::fillRgb24(rgb.data(), width, height, i);
+        AVFrame *yuv = xe->rgb2yuv((char *)rgb.data());
+        ok = yuv && xe->encodeVideo(yuv, (int64_t)i * 1000000 / xe->fps, packets);
+        if (ok && i + 1 == frame_count)
+            ok = xe->flushVideo(packets);
+        for (AVPacket *pkt : packets)
+        {
+            ok = xr->sendFrame(pkt, stream_index) && ok;
+            av_packet_free(&pkt);
+        }
+        packets.clear();
+    }
+    xr->close();
+    xe->close();
+    return ok;
+}
+
+static int64_t file_size(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return in ? (int64_t)in.tellg() : 0;
+}
+
+/**
+ * @brief 把进程的峰值常驻内存重置为当前值，峰值只统计转码过程，不包括生成测试素材（Linux 4.0 及以上）
+ */
+static void reset_peak_rss()
+{
+    FILE *fp = fopen("/proc/self/clear_refs", "w");
+    if (fp == NULL)
+        return;
+    fputs("5", fp);
+    fclose(fp);
+}
+
+/**
+ * @brief 不限速地运行一次完整的转码：FileVideoProvider 解码 → XMediaEncode 编码 → XRtmp 写本地文件
+ *
+ * 流水线的组成与 StreamSession 相同，数据源不经过 FramePacer，解码线程的队列满时阻塞而不丢帧，
+ * 写入线程同样阻塞等待，测量的是整条流水线的最大吞吐量。
+ * 各阶段的 CPU 时间在线程退出时统计，编码器和 swscale 内部工作线程的 CPU 时间无法区分，
+ * 合计为 codec_workers（进程 CPU 时间减去各阶段线程的 CPU 时间）。
+ */
+static bool run_transcode(BenchReport &report, const std::string &input, const std::string &preset, int frame_interval)
+{
+    FileVideoProvider provider(input.c_str());
+    provider.setOutputMode(VideoProvider::NativeFrame);
+    provider.setBackpressurePolicy(ThreadProvider::BlockProducer);
+    provider.setFrameInterval(frame_interval);
+    if (!provider.init())
+    {
+        std::cerr << "open input failed: " << input << std::endl;
+        return false;
+    }
+    provider.setOutputPixelFormat(AV_PIX_FMT_YUV420P);
+
+    std::unique_ptr<XMediaEncode> xe(XMediaEncode::create());
+    xe->fps = provider.getFps();
+    xe->inWidth = xe->outWidth = provider.getWidth();
+    xe->inHeight = xe->outHeight = provider.getHeight();
+    xe->bitrate = 2000000;
+    xe->preset = preset;
+    if (!xe->initScale() || !xe->initVideoCodec())
+    {
+        std::cerr << "encoder error: " << xe->getLastError() << std::endl;
+        return false;
+    }
+    std::unique_ptr<XRtmp> xr(XRtmp::create());
+    int stream_index = -1;
+    if (!xr->init(OUTPUT_PATH) || -1 == (stream_index = xr->addStream(xe->vc)) || !xr->sendHead() ||
+        !xr->startAsync(16 * 1024 * 1024, XRtmp::BlockProducer))
+    {
+        std::cerr << "muxer error: " << xr->getLastError() << std::endl;
+        return false;
+    }
+
+    XMediaEncode *encoder = xe.get();
+    XRtmp *muxer = xr.get();
+    auto frames = std::make_shared<BlockingQueue<FramePtrWrapper>>(4);
+    auto packets = std::make_shared<BlockingQueue<PacketPtr>>(16);
+    Pipeline pipeline;
+    PipelineStage *source_stage = pipeline.addStage(std::unique_ptr<PipelineStage>(new SourceStage<FramePtrWrapper>(
+        "decode", frames,
+        [&provider](std::vector<FramePtrWrapper> &out) -> bool {
+            FramePtrWrapper frame;
+            if (!provider.popDue(frame, nullptr))
+                return false;
+            out.push_back(std::move(frame));
+            return true;
+        })));
+    auto encode = new TransformStage<FramePtrWrapper, PacketPtr>(
+        "encode", frames, packets,
+        [encoder](FramePtrWrapper &frame, std::vector<PacketPtr> &out) -> bool {
+            AVFrame *yuv = encoder->toYuv(frame);
+            std::vector<AVPacket *> encoded;
+            if (!yuv || !encoder->encodeVideo(yuv, frame.getTimestamp(), encoded))
+                return false;
+            for (AVPacket *pkt : encoded)
+                out.emplace_back(pkt);
+            return true;
+        });
+    encode->setFlushFunction([encoder](std::vector<PacketPtr> &out) -> bool {
+        std::vector<AVPacket *> encoded;
+        bool ok = encoder->flushVideo(encoded);
+        for (AVPacket *pkt : encoded)
+            out.emplace_back(pkt);
+        return ok;
+    });
+    PipelineStage *encode_stage = pipeline.addStage(std::unique_ptr<PipelineStage>(encode));
+    PipelineStage *mux_stage = pipeline.addStage(std::unique_ptr<PipelineStage>(new SinkStage<PacketPtr>(
+        "mux", packets,
+        [muxer, stream_index](PacketPtr &pkt) -> bool {
+            return muxer->sendFrame(pkt.get(), stream_index);
+        })));
+
+    reset_peak_rss();
+    const int64_t cpu_begin = Utils::process_cpu_time_us();
+    auto begin = std::chrono::steady_clock::now();
+    provider.start();
+    if (!pipeline.start())
+    {
+        std::cerr << "pipeline start error" << std::endl;
+        provider.stop();
+        return false;
+    }
+    pipeline.wait();
+    provider.stop();
+    xr->close();
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    const int64_t process_cpu_us = Utils::process_cpu_time_us() - cpu_begin;
+
+    ThreadProvider::QueueStats queue_stats = provider.getQueueStats();
+    VideoProvider::DecodeStats decode_stats = provider.getDecodeStats();
+    XRtmp::WriterStats writer_stats = xr->getWriterStats();
+    PipelineStage::Stats source_stats = source_stage->getStats();
+    PipelineStage::Stats encode_stats = encode_stage->getStats();
+    PipelineStage::Stats mux_stats = mux_stage->getStats();
+    const int64_t stage_cpu_us = queue_stats.producer_cpu_us + source_stats.cpu_time_us + encode_stats.cpu_time_us +
+                                 mux_stats.cpu_time_us + writer_stats.writer_cpu_us;
+    const int64_t encoded_frames = encode_stats.processed;
+    const double duration_s = xe->fps > 0 ? (double)encoded_frames / xe->fps : 0;
+    const int64_t output_bytes = file_size(OUTPUT_PATH);
+    remove(OUTPUT_PATH);
+    xe->close();
+
+    report.add(BenchReport::Result("transcode")
+                   .param("input", input)
+                   .param("size", std::to_string(provider.getWidth()) + "x" + std::to_string(provider.getHeight()))
+                   .param("preset", preset)
+                   .param("frame_interval", frame_interval)
+                   .metric("wall_s", wall_s)
+                   .metric("fps", encoded_frames / wall_s)
+                   .metric("realtime_factor", duration_s / wall_s)
+                   .metric("decoded_frames", (double)decode_stats.decoded_frames)
+                   .metric("skipped_packets", (double)decode_stats.skipped_packets)
+                   .metric("delivered_frames", (double)queue_stats.pushed_frames)
+                   .metric("encoded_frames", (double)encoded_frames)
+                   .metric("dropped_frames", (double)queue_stats.dropped_frames)
+                   .metric("dropped_packets", (double)writer_stats.dropped_packets)
+                   .metric("output_bitrate_kbps", duration_s > 0 ? output_bytes * 8 / duration_s / 1000 : 0)
+                   .metric("cpu_demux_decode_s", queue_stats.producer_cpu_us / 1e6)
+                   .metric("cpu_source_s", source_stats.cpu_time_us / 1e6)
+                   .metric("cpu_encode_s", encode_stats.cpu_time_us / 1e6)
+                   .metric("cpu_mux_s", mux_stats.cpu_time_us / 1e6)
+                   .metric("cpu_writer_s", writer_stats.writer_cpu_us / 1e6)
+                   .metric("cpu_codec_workers_s", (process_cpu_us - stage_cpu_us) / 1e6)
+                   .metric("cpu_total_s", process_cpu_us / 1e6)
+                   .metric("cpu_cores_used", process_cpu_us / 1e6 / wall_s)
+                   .metric("peak_rss_mb", Utils::peak_rss_kb() / 1024.0));
+    return true;
+}
+
+/**
+ * @brief 不解码、不编码，直接把输入的视频数据包转发到输出文件（直通），作为转码的对照
+ */
+static bool run_remux(BenchReport &report, const std::string &input)
+{
+    FileVideoProvider provider(input.c_str());
+    if (!provider.init() || !provider.enablePassthrough())
+    {
+        std::cerr << "open input failed: " << input << std::endl;
+        return false;
+    }
+    std::unique_ptr<XRtmp> xr(XRtmp::create());
+    int stream_index = -1;
+    if (!xr->init(OUTPUT_PATH) || -1 == (stream_index = xr->addStream(provider.getVideoStream())) ||
+        !xr->sendHead() || !xr->startAsync(16 * 1024 * 1024, XRtmp::BlockProducer))
+    {
+        std::cerr << "muxer error: " << xr->getLastError() << std::endl;
+        return false;
+    }
+
+    reset_peak_rss();
+    const int64_t cpu_begin = Utils::process_cpu_time_us();
+    auto begin = std::chrono::steady_clock::now();
+    AVPacket *pkt = av_packet_alloc();
+    int64_t packets = 0;
+    bool ok = pkt != NULL;
+    while (ok && provider.readPacket(pkt, nullptr))
+    {
+        ok = xr->sendFrame(pkt, stream_index);
+        ++packets;
+    }
+    av_packet_free(&pkt);
+    provider.stop();
+    xr->close();
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    const int64_t process_cpu_us = Utils::process_cpu_time_us() - cpu_begin;
+    const double fps = provider.getFps();
+    const double duration_s = fps > 0 ? packets / fps : 0;
+    const int64_t output_bytes = file_size(OUTPUT_PATH);
+    remove(OUTPUT_PATH);
+
+    report.add(BenchReport::Result("remux")
+                   .param("input", input)
+                   .param("size", std::to_string(provider.getWidth()) + "x" + std::to_string(provider.getHeight()))
+                   .metric("wall_s", wall_s)
+                   .metric("fps", packets / wall_s)
+                   .metric("realtime_factor", duration_s / wall_s)
+                   .metric("packets", (double)packets)
+                   .metric("output_bitrate_kbps", duration_s > 0 ? output_bytes * 8 / duration_s / 1000 : 0)
+                   .metric("cpu_total_s", process_cpu_us / 1e6)
+                   .metric("cpu_cores_used", process_cpu_us / 1e6 / wall_s)
+                   .metric("peak_rss_mb", Utils::peak_rss_kb() / 1024.0));
+    return ok;
+}
+
+/**
+ * @brief 分段并行转码整个文件，与 run_transcode 的单路转码对比墙钟时间
+ */
+static bool run_segmented(BenchReport &report, const std::string &input, const std::string &preset, int segments)
+{
+    SegmentTranscoder::Config config;
+    config.input_url = input;
+    config.output_url = OUTPUT_PATH;
+    config.bitrate = 2000000;
+    config.preset = preset;
+    config.segments = segments;
+    // 合成素材只有 30 秒，缩短每段的最短时长
+    config.min_segment_us = 2000000;
+    SegmentTranscoder transcoder(config);
+
+    reset_peak_rss();
+    const int64_t cpu_begin = Utils::process_cpu_time_us();
+    auto begin = std::chrono::steady_clock::now();
+    bool ok = transcoder.run();
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    const int64_t process_cpu_us = Utils::process_cpu_time_us() - cpu_begin;
+    remove(OUTPUT_PATH);
+    if (!ok)
+    {
+        std::cerr << "segment transcode error: " << transcoder.getLastError() << std::endl;
+        return false;
+    }
+
+    int64_t encoded_frames = 0;
+    double slowest_segment_s = 0;
+    for (const SegmentTranscoder::Segment &segment : transcoder.getSegments())
+    {
+        encoded_frames += segment.encoded_frames;
+        slowest_segment_s = std::max(slowest_segment_s, segment.wall_s);
+    }
+    report.add(BenchReport::Result("segmented")
+                   .param("input", input)
+                   .param("preset", preset)
+                   .param("segments", (int)transcoder.getSegments().size())
+                   .metric("wall_s", wall_s)
+                   .metric("fps", encoded_frames / wall_s)
+                   .metric("encoded_frames", (double)encoded_frames)
+                   .metric("slowest_segment_s", slowest_segment_s)
+                   .metric("concat_s", wall_s - slowest_segment_s)
+                   .metric("cpu_total_s", process_cpu_us / 1e6)
+                   .metric("cpu_cores_used", process_cpu_us / 1e6 / wall_s)
+                   .metric("peak_rss_mb", Utils::peak_rss_kb() / 1024.0));
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchReport report("transcode", argc, argv);
+    // 参数为输入文件路径，不指定时生成 30 秒的 720p 合成素材
+    std::string input = report.argString(0);
+    bool use_fixture = input.empty();
+    if (use_fixture)
+    {
+        input = FIXTURE_PATH;
+        if (!make_fixture(FIXTURE_PATH, 1280, 720, 750))
+            return 1;
+    }
+    bool ok = true;
+    // 全帧率下比较编码预设，再用 1/2、1/4 抽帧比较解码端跳帧的效果
+    ok = run_transcode(report, input, "ultrafast", 1) && ok;
+    ok = run_transcode(report, input, "veryfast", 1) && ok;
+    ok = run_transcode(report, input, "ultrafast", 2) && ok;
+    ok = run_transcode(report, input, "ultrafast", 4) && ok;
+    // 直通的 CPU 占用与转码对比
+    ok = run_remux(report, input) && ok;
+    // 分段数按 CPU 数自动选择，墙钟时间与第一项单路转码对比
+    ok = run_segmented(report, input, "ultrafast", 0) && ok;
+    if (use_fixture)
+        remove(FIXTURE_PATH);
+    return report.finish() && ok ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#include "CodecThreads.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace CodecThreads
+{
+
+// 每个任务的参数相互独立，可以交给调度器并行执行
+static int scheduler_execute(AVCodecContext *c, int (*func)(AVCodecContext *c2, void *arg),
+                             void *arg, int *ret, int count, int size)
+{
+    TaskScheduler::instance().parallelFor(count, [&](int i) {
+        int r = func(c, (char *)arg + (size_t)i * size);
+        if (ret)
+            ret[i] = r;
+    });
+    return 0;
+}
+
+int configure(AVCodecContext *ctx, int requested, bool hardware)
+{
+    if (hardware)
+    {
+        ctx->thread_count = 1;
+        return 0;
+    }
+    int granted = TaskScheduler::instance().acquireCodecThreads(requested);
+    ctx->thread_count = granted;
+    // 多于 1 个线程时 libavcodec 会用自己的线程池覆盖 execute；
+    // execute2 的 threadnr 用于索引按 thread_count 分配的线程私有数据，不能并行，保持默认实现
+    if (1 == granted)
+        ctx->execute = scheduler_execute;
+    return granted;
+}
+
+int default_decoder_threads()
+{
+    return std::max(1, TaskScheduler::instance().getCodecThreadBudget() / 4);
+}
+
+void release(int &granted)
+{
+    TaskScheduler::instance().releaseCodecThreads(granted);
+    granted = 0;
+}
+
+} // namespace CodecThreads
@@ -0,0 +1,43 @@
+#ifndef CODECTHREADS_H
+#define CODECTHREADS_H
+
+struct AVCodecContext;
+
+/**
+ * @brief 编解码器的线程配置，使所有会话的编解码线程共享 TaskScheduler 的配额
+ */
+namespace CodecThreads
+{
+
+/**
+ * @brief 为编解码器上下文配置线程数，需要在 avcodec_open2 之前调用
+ *
+ * 硬件编解码器只使用 1 个线程，不占用配额。软件编解码器从共享调度器申请线程配额，线程由 libavcodec
+ * 自己创建，调度器只限制其总数。只分到 1 个线程时安装由调度器执行的 execute 回调，
+ * 按任务分片的编解码器（如多 slice 的 H.264 解码）仍可在调度器的工作线程上并行；
+ * libx264 等外部编码器不使用 execute，只受线程数限制。
+ *
+ * @param ctx 编解码器上下文
+ * @param requested 期望的线程数，小于等于 0 表示使用全部剩余配额
+ * @param hardware 是否为硬件编解码器
+ * @return int 分配的线程配额，关闭编解码器后传给 release()
+ */
+int configure(AVCodecContext *ctx, int requested, bool hardware);
+
+/**
+ * @brief 解码器未指定线程数时的默认值
+ *
+ * 解码的开销远小于编码，默认只取配额总数的 1/4（至少 1 个），大部分配额留给编码器。
+ */
+int default_decoder_threads();
+
+/**
+ * @brief 归还 configure() 分配的线程配额，并把 granted 置为 0
+ *
+ * @param granted configure() 的返回值
+ */
+void release(int &granted);
+
+} // namespace CodecThreads
+
+#endif // CODECTHREADS_H
@@ -0,0 +1,290 @@
+#include "ColorConvert.h"
+#include "ColorConvertKernels.h"
+
+namespace ColorConvert
+{
+
+template <int Factor>
+struct BlockShift;
+template <>
+struct BlockShift<1>
+{
+    enum { value = 0 };
+};
+template <>
+struct BlockShift<2>
+{
+    enum { value = 2 };
+};
+template <>
+struct BlockShift<4>
+{
+    enum { value = 4 };
+};
+
+/**
+ * @brief 按 Factor x Factor 的块缩小并转换两行输出中 [x_begin, width) 范围内的像素，x_begin 为偶数
+ *
+ * 亮度由块内像素之和计算，色度由 2x2 个块之和计算，移位量随块大小增加，只在最后舍入一次。
+ * Factor 为 1 时即为不缩放的转换。top/bottom 为两行输出各自对应的第一行源像素。
+ */
+template <int Factor>
+static void rgb24BlockRowPairScalar(const uint8_t *top, const uint8_t *bottom, int rgb_stride,
+                                    uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+                                    int x_begin, int width)
+{
+    const int luma_shift = 8 + BlockShift<Factor>::value;
+    const int chroma_shift = 10 + BlockShift<Factor>::value;
+    for (int x = x_begin; x < width; x += 2)
+    {
+        // 宽度为奇数时最后一列重复使用
+        const int x1 = x + 1 < width ? x + 1 : x;
+        const uint8_t *blocks[4] = {top + x * Factor * 3, top + x1 * Factor * 3,
+                                    bottom + x * Factor * 3, bottom + x1 * Factor * 3};
+        uint8_t *luma[4] = {y0 + x, y0 + x1, y1 + x, y1 + x1};
+        int r = 0, g = 0, b = 0;
+        for (int k = 0; k < 4; ++k)
+        {
+            int br = 0, bg = 0, bb = 0;
+            const uint8_t *row = blocks[k];
+            for (int j = 0; j < Factor; ++j, row += rgb_stride)
+            {
+                for (int i = 0; i < Factor * 3; i += 3)
+                {
+                    br += row[i];
+                    bg += row[i + 1];
+                    bb += row[i + 2];
+                }
+            }
+            *luma[k] = (uint8_t)(((66 * br + 129 * bg + 25 * bb + (1 << (luma_shift - 1))) >> luma_shift) + 16);
+            r += br;
+            g += bg;
+            b += bb;
+        }
+        u[x / 2] = (uint8_t)(((-38 * r - 74 * g + 112 * b + (1 << (chroma_shift - 1))) >> chroma_shift) + 128);
+        v[x / 2] = (uint8_t)(((112 * r - 94 * g - 18 * b + (1 << (chroma_shift - 1))) >> chroma_shift) + 128);
+    }
+}
+
+// 不缩放时每个块只有一个像素，展开循环
+template <>
+void rgb24BlockRowPairScalar<1>(const uint8_t *rgb0, const uint8_t *rgb1, int,
+                                uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+                                int x_begin, int width)
+{
+    for (int x = x_begin; x < width; x += 2)
+    {
+        const int x1 = x + 1 < width ? x + 1 : x;
+        const uint8_t *p00 = rgb0 + x * 3;
+        const uint8_t *p01 = rgb0 + x1 * 3;
+        const uint8_t *p10 = rgb1 + x * 3;
+        const uint8_t *p11 = rgb1 + x1 * 3;
+        y0[x] = (uint8_t)(((66 * p00[0] + 129 * p00[1] + 25 * p00[2] + 128) >> 8) + 16);
+        y0[x1] = (uint8_t)(((66 * p01[0] + 129 * p01[1] + 25 * p01[2] + 128) >> 8) + 16);
+        y1[x] = (uint8_t)(((66 * p10[0] + 129 * p10[1] + 25 * p10[2] + 128) >> 8) + 16);
+        y1[x1] = (uint8_t)(((66 * p11[0] + 129 * p11[1] + 25 * p11[2] + 128) >> 8) + 16);
+
+        const int r = p00[0] + p01[0] + p10[0] + p11[0];
+        const int g = p00[1] + p01[1] + p10[1] + p11[1];
+        const int b = p00[2] + p01[2] + p10[2] + p11[2];
+        u[x / 2] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 512) >> 10) + 128);
+        v[x / 2] = (uint8_t)(((112 * r - 94 * g - 18 * b + 512) >> 10) + 128);
+    }
+}
+
+static Rgb24Downscale2RowPairFunc getDownscale2RowPairFunc(SimdLevel level)
+{
+    switch (level)
+    {
+#if defined(COLORCONVERT_X86)
+    case SIMD_SSE41:
+        return rgb24Downscale2RowPairSse41;
+    case SIMD_AVX2:
+    case SIMD_AVX512:
+        return rgb24Downscale2RowPairAvx2;
+#endif
+#if defined(COLORCONVERT_NEON)
+    case SIMD_NEON:
+        return rgb24Downscale2RowPairNeon;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+static Rgb24RowPairFunc getRowPairFunc(SimdLevel level)
+{
+    switch (level)
+    {
+#if defined(COLORCONVERT_X86)
+    case SIMD_SSE41:
+        return rgb24RowPairSse41;
+    case SIMD_AVX2:
+        return rgb24RowPairAvx2;
+    case SIMD_AVX512:
+        return rgb24RowPairAvx512;
+#endif
+#if defined(COLORCONVERT_NEON)
+    case SIMD_NEON:
+        return rgb24RowPairNeon;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+bool isSupported(SimdLevel level)
+{
+    switch (level)
+    {
+    case SIMD_NONE:
+        return true;
+#if defined(COLORCONVERT_X86)
+    case SIMD_SSE41:
+        return __builtin_cpu_supports("sse4.1");
+    case SIMD_AVX2:
+        return __builtin_cpu_supports("avx2");
+    case SIMD_AVX512:
+        return __builtin_cpu_supports("avx512bw");
+#endif
+#if defined(COLORCONVERT_NEON)
+    case SIMD_NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+SimdLevel detectSimdLevel()
+{
+    static const SimdLevel level = []() {
+        const SimdLevel candidates[] = {SIMD_AVX512, SIMD_AVX2, SIMD_SSE41, SIMD_NEON};
+        for (SimdLevel candidate : candidates)
+        {
+            if (isSupported(candidate))
+                return candidate;
+        }
+        return SIMD_NONE;
+    }();
+    return level;
+}
+
+const char *getSimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SIMD_NONE:
+        return "scalar";
+    case SIMD_SSE41:
+        return "sse4.1";
+    case SIMD_AVX2:
+        return "avx2";
+    case SIMD_AVX512:
+        return "avx512bw";
+    case SIMD_NEON:
+        return "neon";
+    }
+    return "unknown";
+}
+
+static void convert(Rgb24RowPairFunc row_pair,
+                    const uint8_t *rgb, int rgb_stride,
+                    uint8_t *const dst[], const int dst_stride[],
+                    int width, int height)
+{
+    for (int y = 0; y < height; y += 2)
+    {
+        const uint8_t *rgb0 = rgb + (int64_t)y * rgb_stride;
+        uint8_t *y0 = dst[0] + (int64_t)y * dst_stride[0];
+        // 高度为奇数时最后一行与自身配对
+        const bool has_next = y + 1 < height;
+        const uint8_t *rgb1 = has_next ? rgb0 + rgb_stride : rgb0;
+        uint8_t *y1 = has_next ? y0 + dst_stride[0] : y0;
+        uint8_t *u = dst[1] + (int64_t)(y / 2) * dst_stride[1];
+        uint8_t *v = dst[2] + (int64_t)(y / 2) * dst_stride[2];
+
+        int done = row_pair ? row_pair(rgb0, rgb1, y0, y1, u, v, width) : 0;
+        if (done < width)
+            rgb24BlockRowPairScalar<1>(rgb0, rgb1, rgb_stride, y0, y1, u, v, done, width);
+    }
+}
+
+void rgb24ToYuv420p(const uint8_t *rgb, int rgb_stride,
+                    uint8_t *const dst[], const int dst_stride[],
+                    int width, int height)
+{
+    static const Rgb24RowPairFunc row_pair = getRowPairFunc(detectSimdLevel());
+    convert(row_pair, rgb, rgb_stride, dst, dst_stride, width, height);
+}
+
+bool rgb24ToYuv420p(SimdLevel level,
+                    const uint8_t *rgb, int rgb_stride,
+                    uint8_t *const dst[], const int dst_stride[],
+                    int width, int height)
+{
+    if (!isSupported(level))
+        return false;
+    convert(getRowPairFunc(level), rgb, rgb_stride, dst, dst_stride, width, height);
+    return true;
+}
+
+template <int Factor>
+static void convertDownscaled(Rgb24Downscale2RowPairFunc row_pair,
+                              const uint8_t *rgb, int rgb_stride,
+                              uint8_t *const dst[], const int dst_stride[],
+                              int width, int height)
+{
+    for (int y = 0; y < height; y += 2)
+    {
+        const uint8_t *top = rgb + (int64_t)y * Factor * rgb_stride;
+        uint8_t *y0 = dst[0] + (int64_t)y * dst_stride[0];
+        const bool has_next = y + 1 < height;
+        const uint8_t *bottom = has_next ? top + (int64_t)Factor * rgb_stride : top;
+        uint8_t *y1 = has_next ? y0 + dst_stride[0] : y0;
+        uint8_t *u = dst[1] + (int64_t)(y / 2) * dst_stride[1];
+        uint8_t *v = dst[2] + (int64_t)(y / 2) * dst_stride[2];
+
+        int done = 0;
+        if (row_pair)
+        {
+            const uint8_t *const rows[4] = {top, top + rgb_stride, bottom, bottom + rgb_stride};
+            done = row_pair(rows, y0, y1, u, v, width);
+        }
+        if (done < width)
+            rgb24BlockRowPairScalar<Factor>(top, bottom, rgb_stride, y0, y1, u, v, done, width);
+    }
+}
+
+bool rgb24DownscaleToYuv420p(SimdLevel level, int factor,
+                             const uint8_t *rgb, int rgb_stride,
+                             uint8_t *const dst[], const int dst_stride[],
+                             int width, int height)
+{
+    if (!isSupported(level))
+        return false;
+    switch (factor)
+    {
+    case 1:
+        convert(getRowPairFunc(level), rgb, rgb_stride, dst, dst_stride, width, height);
+        return true;
+    case 2:
+        convertDownscaled<2>(getDownscale2RowPairFunc(level), rgb, rgb_stride, dst, dst_stride, width, height);
+        return true;
+    case 4:
+        convertDownscaled<4>(nullptr, rgb, rgb_stride, dst, dst_stride, width, height);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool rgb24DownscaleToYuv420p(int factor,
+                             const uint8_t *rgb, int rgb_stride,
+                             uint8_t *const dst[], const int dst_stride[],
+                             int width, int height)
+{
+    return rgb24DownscaleToYuv420p(detectSimdLevel(), factor, rgb, rgb_stride, dst, dst_stride, width, height);
+}
+
+} // namespace ColorConvert
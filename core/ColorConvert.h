@@ -0,0 +1,112 @@
+#ifndef COLORCONVERT_H
+#define COLORCONVERT_H
+
+#include <cstdint>
+
+/**
+ * @brief 手写向量化的颜色空间转换，运行时根据 CPU 特性选择实现
+ *
+ * 转换公式为 BT.601 有限范围（与 swscale 默认一致），整数运算：
+ *   Y = ((66R + 129G + 25B + 128) >> 8) + 16
+ *   U = ((-38R - 74G + 112B + 128) >> 8) + 128
+ *   V = ((112R - 94G - 18B + 128) >> 8) + 128
+ * 色度取 2x2 像素 RGB 之和后计算（即先求平均再转换，保留小数精度）。
+ * 各实现之间的结果逐字节一致。
+ */
+namespace ColorConvert
+{
+
+/**
+ * @brief 向量指令集级别
+ */
+enum SimdLevel
+{
+    SIMD_NONE = 0, ///< 标量实现
+    SIMD_SSE41,    ///< x86 SSE4.1
+    SIMD_AVX2,     ///< x86 AVX2
+    SIMD_AVX512,   ///< x86 AVX-512BW
+    SIMD_NEON,     ///< ARM NEON
+};
+
+/**
+ * @brief 获取当前 CPU 支持的最高指令集级别（只检测一次）
+ *
+ * @return SimdLevel 指令集级别
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief 判断当前 CPU 和编译目标是否支持指定的指令集级别
+ *
+ * @param level 指令集级别
+ * @return bool 支持返回 true
+ */
+bool isSupported(SimdLevel level);
+
+/**
+ * @brief 获取指令集级别的名称
+ *
+ * @param level 指令集级别
+ * @return const char* 名称字符串
+ */
+const char *getSimdLevelName(SimdLevel level);
+
+/**
+ * @brief 打包的 RGB24 转换为 YUV420P，尺寸不变
+ *
+ * 宽高为奇数时，最后一列/行的色度只由现有的像素计算。
+ *
+ * @param rgb RGB24 数据
+ * @param rgb_stride RGB24 一行的字节数
+ * @param dst 输出的 Y、U、V 三个平面
+ * @param dst_stride 三个平面一行的字节数
+ * @param width 图像宽度
+ * @param height 图像高度
+ */
+void rgb24ToYuv420p(const uint8_t *rgb, int rgb_stride,
+                    uint8_t *const dst[], const int dst_stride[],
+                    int width, int height);
+
+/**
+ * @brief 使用指定指令集级别的 RGB24 转 YUV420P，用于校验和基准测试
+ *
+ * @return bool 当前 CPU 不支持该级别时返回 false，不做任何转换
+ */
+bool rgb24ToYuv420p(SimdLevel level,
+                    const uint8_t *rgb, int rgb_stride,
+                    uint8_t *const dst[], const int dst_stride[],
+                    int width, int height);
+
+/**
+ * @brief 整数倍缩小并转换为 YUV420P，一次遍历完成
+ *
+ * 每个输出像素取源图像中 factor x factor 个像素的均值（盒式滤波），缩小与颜色空间转换融合在一起，
+ * 每个源像素只读取一次，没有中间缓冲区。factor 为 1 时等价于 rgb24ToYuv420p。
+ *
+ * @param factor 缩小倍数，支持 1、2、4
+ * @param rgb RGB24 数据，尺寸至少为 (width * factor) x (height * factor)
+ * @param rgb_stride RGB24 一行的字节数
+ * @param dst 输出的 Y、U、V 三个平面
+ * @param dst_stride 三个平面一行的字节数
+ * @param width 输出宽度
+ * @param height 输出高度
+ * @return bool 不支持的缩小倍数返回 false
+ */
+bool rgb24DownscaleToYuv420p(int factor,
+                             const uint8_t *rgb, int rgb_stride,
+                             uint8_t *const dst[], const int dst_stride[],
+                             int width, int height);
+
+/**
+ * @brief 使用指定指令集级别的整数倍缩小转换，用于校验和基准测试
+ *
+ * @return bool 当前 CPU 不支持该级别或不支持该缩小倍数时返回 false
+ */
+bool rgb24DownscaleToYuv420p(SimdLevel level, int factor,
+                             const uint8_t *rgb, int rgb_stride,
+                             uint8_t *const dst[], const int dst_stride[],
+                             int width, int height);
+
+} // namespace ColorConvert
+
+#endif // COLORCONVERT_H
@@ -0,0 +1,53 @@
+#ifndef COLORCONVERTKERNELS_H
+#define COLORCONVERTKERNELS_H
+
+#include <cstdint>
+
+/**
+ * @brief ColorConvert 内部使用的各指令集内核
+ *
+ * 每个内核转换相邻的两行像素（rgb0/rgb1 -> y0/y1 以及一行色度），只处理向量宽度整数倍的像素，
+ * 返回已处理的像素个数，剩余的像素由标量代码完成。图像高度为奇数时最后一行以 rgb1 == rgb0、
+ * y1 == y0 调用。
+ *
+ * 2:1 缩小的内核与之类似：rgb[0..1] 为第一行输出对应的两行源像素，rgb[2..3] 为第二行输出对应的两行，
+ * width 为输出宽度，返回已处理的输出像素个数。
+ */
+namespace ColorConvert
+{
+
+typedef int (*Rgb24RowPairFunc)(const uint8_t *rgb0, const uint8_t *rgb1,
+                                uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+                                int width);
+
+typedef int (*Rgb24Downscale2RowPairFunc)(const uint8_t *const rgb[4],
+                                          uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+                                          int width);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define COLORCONVERT_X86 1
+int rgb24RowPairSse41(const uint8_t *rgb0, const uint8_t *rgb1,
+                      uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width);
+int rgb24RowPairAvx2(const uint8_t *rgb0, const uint8_t *rgb1,
+                     uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width);
+int rgb24RowPairAvx512(const uint8_t *rgb0, const uint8_t *rgb1,
+                       uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width);
+int rgb24Downscale2RowPairSse41(const uint8_t *const rgb[4],
+                                uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width);
+int rgb24Downscale2RowPairAvx2(const uint8_t *const rgb[4],
+                               uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width);
+#endif
+
+// NEON 内核尚未在 aarch64 上编译并与标量代码核对结果，默认不参与构建，
+// 验证时用 cmake -DCOLORCONVERT_ENABLE_NEON=ON 开启
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(COLORCONVERT_ENABLE_NEON)
+#define COLORCONVERT_NEON 1
+int rgb24RowPairNeon(const uint8_t *rgb0, const uint8_t *rgb1,
+                     uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width);
+int rgb24Downscale2RowPairNeon(const uint8_t *const rgb[4],
+                               uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width);
+#endif
+
+} // namespace ColorConvert
+
+#endif // COLORCONVERTKERNELS_H
@@ -0,0 +1,134 @@
+#include "ColorConvertKernels.h"
+
+#if defined(COLORCONVERT_NEON)
+
+#include <arm_neon.h>
+
+namespace ColorConvert
+{
+
+static inline uint8x8_t luma8(uint8x8_t r, uint8x8_t g, uint8x8_t b)
+{
+    uint16x8_t sum = vmull_u8(r, vdup_n_u8(66));
+    sum = vmlal_u8(sum, g, vdup_n_u8(129));
+    sum = vmlal_u8(sum, b, vdup_n_u8(25));
+    // vrshrn 带舍入：(sum + 128) >> 8
+    return vadd_u8(vrshrn_n_u16(sum, 8), vdup_n_u8(16));
+}
+
+static inline uint8x16_t luma16(const uint8x16x3_t &p)
+{
+    return vcombine_u8(luma8(vget_low_u8(p.val[0]), vget_low_u8(p.val[1]), vget_low_u8(p.val[2])),
+                       luma8(vget_high_u8(p.val[0]), vget_high_u8(p.val[1]), vget_high_u8(p.val[2])));
+}
+
+template <int Shift>
+static inline int32x4_t weightedSum4(int16x4_t r, int16x4_t g, int16x4_t b, int16_t cr, int16_t cg, int16_t cb)
+{
+    int32x4_t sum = vmull_n_s16(r, cr);
+    sum = vmlal_n_s16(sum, g, cg);
+    sum = vmlal_n_s16(sum, b, cb);
+    // vrshr 带舍入：(sum + (1 << (Shift - 1))) >> Shift
+    return vrshrq_n_s32(sum, Shift);
+}
+
+// 返回 8 个 ((cr*rs + cg*gs + cb*bs + round) >> Shift) + offset
+template <int Shift>
+static inline uint8x8_t weightedSum8(uint16x8_t rs, uint16x8_t gs, uint16x8_t bs,
+                                     int16_t cr, int16_t cg, int16_t cb, int16_t offset)
+{
+    const int16x8_t r = vreinterpretq_s16_u16(rs);
+    const int16x8_t g = vreinterpretq_s16_u16(gs);
+    const int16x8_t b = vreinterpretq_s16_u16(bs);
+    int32x4_t lo = weightedSum4<Shift>(vget_low_s16(r), vget_low_s16(g), vget_low_s16(b), cr, cg, cb);
+    int32x4_t hi = weightedSum4<Shift>(vget_high_s16(r), vget_high_s16(g), vget_high_s16(b), cr, cg, cb);
+    int16x8_t c = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+    return vqmovun_s16(vaddq_s16(c, vdupq_n_s16(offset)));
+}
+
+// rs/gs/bs 为 2x2 像素之和
+static inline uint8x8_t chroma8(uint16x8_t rs, uint16x8_t gs, uint16x8_t bs, int16_t cr, int16_t cg, int16_t cb)
+{
+    return weightedSum8<10>(rs, gs, bs, cr, cg, cb, 128);
+}
+
+int rgb24RowPairNeon(const uint8_t *rgb0, const uint8_t *rgb1,
+                     uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        // vld3 直接把 RGB 分离到三个向量中
+        const uint8x16x3_t p0 = vld3q_u8(rgb0 + x * 3);
+        const uint8x16x3_t p1 = vld3q_u8(rgb1 + x * 3);
+        vst1q_u8(y0 + x, luma16(p0));
+        vst1q_u8(y1 + x, luma16(p1));
+
+        // 水平两像素求和后累加另一行
+        const uint16x8_t rs = vpadalq_u8(vpaddlq_u8(p0.val[0]), p1.val[0]);
+        const uint16x8_t gs = vpadalq_u8(vpaddlq_u8(p0.val[1]), p1.val[1]);
+        const uint16x8_t bs = vpadalq_u8(vpaddlq_u8(p0.val[2]), p1.val[2]);
+        vst1_u8(u + x / 2, chroma8(rs, gs, bs, -38, -74, 112));
+        vst1_u8(v + x / 2, chroma8(rs, gs, bs, 112, -94, -18));
+    }
+    return x;
+}
+
+struct BlockSums
+{
+    uint16x8_t r, g, b;
+};
+
+// 两行各 16 个源像素 -> 8 个输出像素的 2x2 块和
+static inline BlockSums blockSums(const uint8_t *row0, const uint8_t *row1)
+{
+    const uint8x16x3_t p0 = vld3q_u8(row0);
+    const uint8x16x3_t p1 = vld3q_u8(row1);
+    BlockSums out;
+    out.r = vpadalq_u8(vpaddlq_u8(p0.val[0]), p1.val[0]);
+    out.g = vpadalq_u8(vpaddlq_u8(p0.val[1]), p1.val[1]);
+    out.b = vpadalq_u8(vpaddlq_u8(p0.val[2]), p1.val[2]);
+    return out;
+}
+
+static inline uint8x16_t blockLuma16(const BlockSums &lo, const BlockSums &hi)
+{
+    return vcombine_u8(weightedSum8<10>(lo.r, lo.g, lo.b, 66, 129, 25, 16),
+                       weightedSum8<10>(hi.r, hi.g, hi.b, 66, 129, 25, 16));
+}
+
+// 上下两个块相加后水平相邻两个相加，得到 8 个 4x4 源像素之和
+static inline uint16x8_t chromaSum8(uint16x8_t a0, uint16x8_t b0, uint16x8_t a1, uint16x8_t b1)
+{
+    const uint16x8_t lo = vaddq_u16(a0, b0);
+    const uint16x8_t hi = vaddq_u16(a1, b1);
+    return vcombine_u16(vpadd_u16(vget_low_u16(lo), vget_high_u16(lo)),
+                        vpadd_u16(vget_low_u16(hi), vget_high_u16(hi)));
+}
+
+int rgb24Downscale2RowPairNeon(const uint8_t *const rgb[4],
+                               uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        const int offset = x * 2 * 3;
+        const BlockSums a0 = blockSums(rgb[0] + offset, rgb[1] + offset);
+        const BlockSums a1 = blockSums(rgb[0] + offset + 48, rgb[1] + offset + 48);
+        const BlockSums b0 = blockSums(rgb[2] + offset, rgb[3] + offset);
+        const BlockSums b1 = blockSums(rgb[2] + offset + 48, rgb[3] + offset + 48);
+        vst1q_u8(y0 + x, blockLuma16(a0, a1));
+        vst1q_u8(y1 + x, blockLuma16(b0, b1));
+
+        const uint16x8_t rs = chromaSum8(a0.r, b0.r, a1.r, b1.r);
+        const uint16x8_t gs = chromaSum8(a0.g, b0.g, a1.g, b1.g);
+        const uint16x8_t bs = chromaSum8(a0.b, b0.b, a1.b, b1.b);
+        vst1_u8(u + x / 2, weightedSum8<12>(rs, gs, bs, -38, -74, 112, 128));
+        vst1_u8(v + x / 2, weightedSum8<12>(rs, gs, bs, 112, -94, -18, 128));
+    }
+    return x;
+}
+
+} // namespace ColorConvert
+
+#endif // COLORCONVERT_NEON
@@ -0,0 +1,461 @@
+#include "ColorConvertKernels.h"
+
+#if defined(COLORCONVERT_X86)
+
+// GCC 12 的 AVX-512 头文件中 _mm512_undefined_* 会触发 -Wmaybe-uninitialized 误报
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+/*
+ * x86 内核使用函数级 target 属性编译，无需为整个库打开 -mavx2 等编译选项，
+ * 运行时由 ColorConvert::detectSimdLevel() 保证只调用 CPU 支持的版本。
+ *
+ * 三种宽度的实现结构相同：
+ * 1. 每 16 个像素（48 字节）用 pshufb 把 R、G、B 分离到三个 16 字节向量中；
+ *    AVX2/AVX-512 的每个 128 位通道各自处理 16 个像素，shuffle/unpack/pack 都在通道内进行，
+ *    unpack 与 pack 的通道内交错相互抵消，亮度结果保持原始顺序。
+ * 2. 亮度按 16 位无符号计算：66R + 129G + 25B + 128 最大为 56228，不会溢出。
+ * 3. 色度先用 maddubs 求水平相邻两像素之和，再加上另一行，得到 2x2 像素之和；
+ *    然后与常数 512 交错，用 madd 一次算出 32 位的 c0*R + c1*G 和 c2*B + 512。
+ */
+
+namespace ColorConvert
+{
+
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+// 16 个像素中各颜色分量在 3 个 16 字节块中的位置，-1 表示置零
+static const int8_t kShuffleR[3][16] = {
+    {0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13},
+};
+static const int8_t kShuffleG[3][16] = {
+    {1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14},
+};
+static const int8_t kShuffleB[3][16] = {
+    {2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15},
+};
+
+// madd 使用的系数对，低 16 位乘偶数位置的元素
+static inline int coeffPair(int lo, int hi)
+{
+    return (int)((uint32_t)(uint16_t)lo | ((uint32_t)(uint16_t)hi << 16));
+}
+
+/* ---------------------------------- SSE4.1 ---------------------------------- */
+
+struct Rgb128
+{
+    __m128i r, g, b;
+};
+
+TARGET_SSE41 static inline __m128i loadMask128(const int8_t *mask)
+{
+    return _mm_loadu_si128((const __m128i *)mask);
+}
+
+TARGET_SSE41 static inline Rgb128 deinterleave128(const uint8_t *p)
+{
+    const __m128i a = _mm_loadu_si128((const __m128i *)p);
+    const __m128i b = _mm_loadu_si128((const __m128i *)(p + 16));
+    const __m128i c = _mm_loadu_si128((const __m128i *)(p + 32));
+    Rgb128 out;
+    out.r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, loadMask128(kShuffleR[0])),
+                                      _mm_shuffle_epi8(b, loadMask128(kShuffleR[1]))),
+                         _mm_shuffle_epi8(c, loadMask128(kShuffleR[2])));
+    out.g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, loadMask128(kShuffleG[0])),
+                                      _mm_shuffle_epi8(b, loadMask128(kShuffleG[1]))),
+                         _mm_shuffle_epi8(c, loadMask128(kShuffleG[2])));
+    out.b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, loadMask128(kShuffleB[0])),
+                                      _mm_shuffle_epi8(b, loadMask128(kShuffleB[1]))),
+                         _mm_shuffle_epi8(c, loadMask128(kShuffleB[2])));
+    return out;
+}
+
+TARGET_SSE41 static inline __m128i luma16x8(__m128i r, __m128i g, __m128i b)
+{
+    __m128i sum = _mm_mullo_epi16(r, _mm_set1_epi16(66));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(25)));
+    sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+    return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+}
+
+TARGET_SSE41 static inline __m128i luma128(const Rgb128 &p)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = luma16x8(_mm_unpacklo_epi8(p.r, zero), _mm_unpacklo_epi8(p.g, zero), _mm_unpacklo_epi8(p.b, zero));
+    __m128i hi = luma16x8(_mm_unpackhi_epi8(p.r, zero), _mm_unpackhi_epi8(p.g, zero), _mm_unpackhi_epi8(p.b, zero));
+    return _mm_packus_epi16(lo, hi);
+}
+
+// 返回 8 个 16 位的 ((cr*rs + cg*gs + cb*bs + round) >> Shift) + offset
+template <int Shift>
+TARGET_SSE41 static inline __m128i weightedSum128(__m128i rs, __m128i gs, __m128i bs, int cr, int cg, int cb, int offset)
+{
+    const __m128i rg_coeff = _mm_set1_epi32(coeffPair(cr, cg));
+    const __m128i b_coeff = _mm_set1_epi32(coeffPair(cb, 1));
+    const __m128i round = _mm_set1_epi16(1 << (Shift - 1));
+    __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(rs, gs), rg_coeff),
+                               _mm_madd_epi16(_mm_unpacklo_epi16(bs, round), b_coeff));
+    __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(rs, gs), rg_coeff),
+                               _mm_madd_epi16(_mm_unpackhi_epi16(bs, round), b_coeff));
+    __m128i c = _mm_packs_epi32(_mm_srai_epi32(lo, Shift), _mm_srai_epi32(hi, Shift));
+    return _mm_add_epi16(c, _mm_set1_epi16(offset));
+}
+
+// rs/gs/bs 为 2x2 像素之和，返回 8 个 16 位色度值
+TARGET_SSE41 static inline __m128i chroma128(__m128i rs, __m128i gs, __m128i bs, int cr, int cg, int cb)
+{
+    return weightedSum128<10>(rs, gs, bs, cr, cg, cb, 128);
+}
+
+TARGET_SSE41 int rgb24RowPairSse41(const uint8_t *rgb0, const uint8_t *rgb1,
+                                   uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width)
+{
+    const __m128i ones = _mm_set1_epi8(1);
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        const Rgb128 p0 = deinterleave128(rgb0 + x * 3);
+        const Rgb128 p1 = deinterleave128(rgb1 + x * 3);
+        _mm_storeu_si128((__m128i *)(y0 + x), luma128(p0));
+        _mm_storeu_si128((__m128i *)(y1 + x), luma128(p1));
+
+        const __m128i rs = _mm_add_epi16(_mm_maddubs_epi16(p0.r, ones), _mm_maddubs_epi16(p1.r, ones));
+        const __m128i gs = _mm_add_epi16(_mm_maddubs_epi16(p0.g, ones), _mm_maddubs_epi16(p1.g, ones));
+        const __m128i bs = _mm_add_epi16(_mm_maddubs_epi16(p0.b, ones), _mm_maddubs_epi16(p1.b, ones));
+        const __m128i uc = chroma128(rs, gs, bs, -38, -74, 112);
+        const __m128i vc = chroma128(rs, gs, bs, 112, -94, -18);
+        _mm_storel_epi64((__m128i *)(u + x / 2), _mm_packus_epi16(uc, uc));
+        _mm_storel_epi64((__m128i *)(v + x / 2), _mm_packus_epi16(vc, vc));
+    }
+    return x;
+}
+
+/* ----------------------------------- AVX2 ----------------------------------- */
+
+struct Rgb256
+{
+    __m256i r, g, b;
+};
+
+TARGET_AVX2 static inline __m256i loadMask256(const int8_t *mask)
+{
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)mask));
+}
+
+// 两个 16 像素块分别放入低、高 128 位通道
+TARGET_AVX2 static inline __m256i load2x128(const uint8_t *lo, const uint8_t *hi)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)lo)),
+                                   _mm_loadu_si128((const __m128i *)hi), 1);
+}
+
+TARGET_AVX2 static inline Rgb256 deinterleave256(const uint8_t *p)
+{
+    const __m256i a = load2x128(p, p + 48);
+    const __m256i b = load2x128(p + 16, p + 64);
+    const __m256i c = load2x128(p + 32, p + 80);
+    Rgb256 out;
+    out.r = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, loadMask256(kShuffleR[0])),
+                                            _mm256_shuffle_epi8(b, loadMask256(kShuffleR[1]))),
+                            _mm256_shuffle_epi8(c, loadMask256(kShuffleR[2])));
+    out.g = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, loadMask256(kShuffleG[0])),
+                                            _mm256_shuffle_epi8(b, loadMask256(kShuffleG[1]))),
+                            _mm256_shuffle_epi8(c, loadMask256(kShuffleG[2])));
+    out.b = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, loadMask256(kShuffleB[0])),
+                                            _mm256_shuffle_epi8(b, loadMask256(kShuffleB[1]))),
+                            _mm256_shuffle_epi8(c, loadMask256(kShuffleB[2])));
+    return out;
+}
+
+TARGET_AVX2 static inline __m256i luma16x16(__m256i r, __m256i g, __m256i b)
+{
+    __m256i sum = _mm256_mullo_epi16(r, _mm256_set1_epi16(66));
+    sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(g, _mm256_set1_epi16(129)));
+    sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(b, _mm256_set1_epi16(25)));
+    sum = _mm256_add_epi16(sum, _mm256_set1_epi16(128));
+    return _mm256_add_epi16(_mm256_srli_epi16(sum, 8), _mm256_set1_epi16(16));
+}
+
+TARGET_AVX2 static inline __m256i luma256(const Rgb256 &p)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = luma16x16(_mm256_unpacklo_epi8(p.r, zero), _mm256_unpacklo_epi8(p.g, zero), _mm256_unpacklo_epi8(p.b, zero));
+    __m256i hi = luma16x16(_mm256_unpackhi_epi8(p.r, zero), _mm256_unpackhi_epi8(p.g, zero), _mm256_unpackhi_epi8(p.b, zero));
+    return _mm256_packus_epi16(lo, hi);
+}
+
+template <int Shift>
+TARGET_AVX2 static inline __m256i weightedSum256(__m256i rs, __m256i gs, __m256i bs, int cr, int cg, int cb, int offset)
+{
+    const __m256i rg_coeff = _mm256_set1_epi32(coeffPair(cr, cg));
+    const __m256i b_coeff = _mm256_set1_epi32(coeffPair(cb, 1));
+    const __m256i round = _mm256_set1_epi16(1 << (Shift - 1));
+    __m256i lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(rs, gs), rg_coeff),
+                                  _mm256_madd_epi16(_mm256_unpacklo_epi16(bs, round), b_coeff));
+    __m256i hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(rs, gs), rg_coeff),
+                                  _mm256_madd_epi16(_mm256_unpackhi_epi16(bs, round), b_coeff));
+    __m256i c = _mm256_packs_epi32(_mm256_srai_epi32(lo, Shift), _mm256_srai_epi32(hi, Shift));
+    return _mm256_add_epi16(c, _mm256_set1_epi16(offset));
+}
+
+TARGET_AVX2 static inline __m256i chroma256(__m256i rs, __m256i gs, __m256i bs, int cr, int cg, int cb)
+{
+    return weightedSum256<10>(rs, gs, bs, cr, cg, cb, 128);
+}
+
+// 16 个 16 位色度值压缩为字节；packus 在每个通道内重复一次，取 0、2 两个 64 位块
+TARGET_AVX2 static inline __m128i packChroma256(__m256i c)
+{
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(c, c), 0xD8));
+}
+
+TARGET_AVX2 int rgb24RowPairAvx2(const uint8_t *rgb0, const uint8_t *rgb1,
+                                 uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width)
+{
+    const __m256i ones = _mm256_set1_epi8(1);
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        const Rgb256 p0 = deinterleave256(rgb0 + x * 3);
+        const Rgb256 p1 = deinterleave256(rgb1 + x * 3);
+        _mm256_storeu_si256((__m256i *)(y0 + x), luma256(p0));
+        _mm256_storeu_si256((__m256i *)(y1 + x), luma256(p1));
+
+        const __m256i rs = _mm256_add_epi16(_mm256_maddubs_epi16(p0.r, ones), _mm256_maddubs_epi16(p1.r, ones));
+        const __m256i gs = _mm256_add_epi16(_mm256_maddubs_epi16(p0.g, ones), _mm256_maddubs_epi16(p1.g, ones));
+        const __m256i bs = _mm256_add_epi16(_mm256_maddubs_epi16(p0.b, ones), _mm256_maddubs_epi16(p1.b, ones));
+        _mm_storeu_si128((__m128i *)(u + x / 2), packChroma256(chroma256(rs, gs, bs, -38, -74, 112)));
+        _mm_storeu_si128((__m128i *)(v + x / 2), packChroma256(chroma256(rs, gs, bs, 112, -94, -18)));
+    }
+    // 剩余部分交给 SSE4.1 版本，AVX2 的 CPU 一定支持 SSE4.1
+    return x + rgb24RowPairSse41(rgb0 + x * 3, rgb1 + x * 3, y0 + x, y1 + x, u + x / 2, v + x / 2, width - x);
+}
+
+/* --------------------------------- AVX-512BW -------------------------------- */
+
+struct Rgb512
+{
+    __m512i r, g, b;
+};
+
+TARGET_AVX512 static inline __m512i loadMask512(const int8_t *mask)
+{
+    return _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)mask));
+}
+
+// 4 个 16 像素块分别放入 4 个 128 位通道，块间距为 48 字节
+TARGET_AVX512 static inline __m512i load4x128(const uint8_t *p)
+{
+    __m512i v = _mm512_castsi128_si512(_mm_loadu_si128((const __m128i *)p));
+    v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *)(p + 48)), 1);
+    v = _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *)(p + 96)), 2);
+    return _mm512_inserti32x4(v, _mm_loadu_si128((const __m128i *)(p + 144)), 3);
+}
+
+TARGET_AVX512 static inline Rgb512 deinterleave512(const uint8_t *p)
+{
+    const __m512i a = load4x128(p);
+    const __m512i b = load4x128(p + 16);
+    const __m512i c = load4x128(p + 32);
+    Rgb512 out;
+    out.r = _mm512_or_si512(_mm512_or_si512(_mm512_shuffle_epi8(a, loadMask512(kShuffleR[0])),
+                                            _mm512_shuffle_epi8(b, loadMask512(kShuffleR[1]))),
+                            _mm512_shuffle_epi8(c, loadMask512(kShuffleR[2])));
+    out.g = _mm512_or_si512(_mm512_or_si512(_mm512_shuffle_epi8(a, loadMask512(kShuffleG[0])),
+                                            _mm512_shuffle_epi8(b, loadMask512(kShuffleG[1]))),
+                            _mm512_shuffle_epi8(c, loadMask512(kShuffleG[2])));
+    out.b = _mm512_or_si512(_mm512_or_si512(_mm512_shuffle_epi8(a, loadMask512(kShuffleB[0])),
+                                            _mm512_shuffle_epi8(b, loadMask512(kShuffleB[1]))),
+                            _mm512_shuffle_epi8(c, loadMask512(kShuffleB[2])));
+    return out;
+}
+
+TARGET_AVX512 static inline __m512i luma16x32(__m512i r, __m512i g, __m512i b)
+{
+    __m512i sum = _mm512_mullo_epi16(r, _mm512_set1_epi16(66));
+    sum = _mm512_add_epi16(sum, _mm512_mullo_epi16(g, _mm512_set1_epi16(129)));
+    sum = _mm512_add_epi16(sum, _mm512_mullo_epi16(b, _mm512_set1_epi16(25)));
+    sum = _mm512_add_epi16(sum, _mm512_set1_epi16(128));
+    return _mm512_add_epi16(_mm512_srli_epi16(sum, 8), _mm512_set1_epi16(16));
+}
+
+TARGET_AVX512 static inline __m512i luma512(const Rgb512 &p)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i lo = luma16x32(_mm512_unpacklo_epi8(p.r, zero), _mm512_unpacklo_epi8(p.g, zero), _mm512_unpacklo_epi8(p.b, zero));
+    __m512i hi = luma16x32(_mm512_unpackhi_epi8(p.r, zero), _mm512_unpackhi_epi8(p.g, zero), _mm512_unpackhi_epi8(p.b, zero));
+    return _mm512_packus_epi16(lo, hi);
+}
+
+// 返回 32 个色度字节，packs_epi32 在通道内交错后各通道依次为第 8k ~ 8k+7 个色度
+TARGET_AVX512 static inline __m256i chroma512(__m512i rs, __m512i gs, __m512i bs, int cr, int cg, int cb)
+{
+    const __m512i rg_coeff = _mm512_set1_epi32(coeffPair(cr, cg));
+    const __m512i b_coeff = _mm512_set1_epi32(coeffPair(cb, 1));
+    const __m512i round = _mm512_set1_epi16(512);
+    __m512i lo = _mm512_add_epi32(_mm512_madd_epi16(_mm512_unpacklo_epi16(rs, gs), rg_coeff),
+                                  _mm512_madd_epi16(_mm512_unpacklo_epi16(bs, round), b_coeff));
+    __m512i hi = _mm512_add_epi32(_mm512_madd_epi16(_mm512_unpackhi_epi16(rs, gs), rg_coeff),
+                                  _mm512_madd_epi16(_mm512_unpackhi_epi16(bs, round), b_coeff));
+    __m512i c = _mm512_packs_epi32(_mm512_srai_epi32(lo, 10), _mm512_srai_epi32(hi, 10));
+    c = _mm512_add_epi16(c, _mm512_set1_epi16(128));
+    return _mm512_cvtusepi16_epi8(c);
+}
+
+TARGET_AVX512 int rgb24RowPairAvx512(const uint8_t *rgb0, const uint8_t *rgb1,
+                                     uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width)
+{
+    const __m512i ones = _mm512_set1_epi8(1);
+    int x = 0;
+    for (; x + 64 <= width; x += 64)
+    {
+        const Rgb512 p0 = deinterleave512(rgb0 + x * 3);
+        const Rgb512 p1 = deinterleave512(rgb1 + x * 3);
+        _mm512_storeu_si512((void *)(y0 + x), luma512(p0));
+        _mm512_storeu_si512((void *)(y1 + x), luma512(p1));
+
+        const __m512i rs = _mm512_add_epi16(_mm512_maddubs_epi16(p0.r, ones), _mm512_maddubs_epi16(p1.r, ones));
+        const __m512i gs = _mm512_add_epi16(_mm512_maddubs_epi16(p0.g, ones), _mm512_maddubs_epi16(p1.g, ones));
+        const __m512i bs = _mm512_add_epi16(_mm512_maddubs_epi16(p0.b, ones), _mm512_maddubs_epi16(p1.b, ones));
+        _mm256_storeu_si256((__m256i *)(u + x / 2), chroma512(rs, gs, bs, -38, -74, 112));
+        _mm256_storeu_si256((__m256i *)(v + x / 2), chroma512(rs, gs, bs, 112, -94, -18));
+    }
+    return x + rgb24RowPairAvx2(rgb0 + x * 3, rgb1 + x * 3, y0 + x, y1 + x, u + x / 2, v + x / 2, width - x);
+}
+
+/* ------------------------------- 2:1 缩小 + 转换 ------------------------------- */
+
+/*
+ * 每个输出像素是 2x2 个源像素之和，maddubs 求水平两像素之和再加上下一行即可得到，
+ * 与 1:1 转换中的色度求和完全相同；输出的色度再由相邻两行、两列的块和相加得到（4x4 个源像素）。
+ * 块和最大 1020，色度和最大 4080，都不会超出 16 位有符号整数。
+ */
+
+struct BlockSums128
+{
+    __m128i r, g, b;
+};
+
+// 两行各 16 个源像素 -> 8 个输出像素的 2x2 块和
+TARGET_SSE41 static inline BlockSums128 blockSums128(const uint8_t *row0, const uint8_t *row1)
+{
+    const __m128i ones = _mm_set1_epi8(1);
+    const Rgb128 p0 = deinterleave128(row0);
+    const Rgb128 p1 = deinterleave128(row1);
+    BlockSums128 out;
+    out.r = _mm_add_epi16(_mm_maddubs_epi16(p0.r, ones), _mm_maddubs_epi16(p1.r, ones));
+    out.g = _mm_add_epi16(_mm_maddubs_epi16(p0.g, ones), _mm_maddubs_epi16(p1.g, ones));
+    out.b = _mm_add_epi16(_mm_maddubs_epi16(p0.b, ones), _mm_maddubs_epi16(p1.b, ones));
+    return out;
+}
+
+TARGET_SSE41 static inline __m128i blockLuma128(const BlockSums128 &lo, const BlockSums128 &hi)
+{
+    return _mm_packus_epi16(weightedSum128<10>(lo.r, lo.g, lo.b, 66, 129, 25, 16),
+                            weightedSum128<10>(hi.r, hi.g, hi.b, 66, 129, 25, 16));
+}
+
+TARGET_SSE41 int rgb24Downscale2RowPairSse41(const uint8_t *const rgb[4],
+                                             uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        const int offset = x * 2 * 3;
+        const BlockSums128 a0 = blockSums128(rgb[0] + offset, rgb[1] + offset);
+        const BlockSums128 a1 = blockSums128(rgb[0] + offset + 48, rgb[1] + offset + 48);
+        const BlockSums128 b0 = blockSums128(rgb[2] + offset, rgb[3] + offset);
+        const BlockSums128 b1 = blockSums128(rgb[2] + offset + 48, rgb[3] + offset + 48);
+        _mm_storeu_si128((__m128i *)(y0 + x), blockLuma128(a0, a1));
+        _mm_storeu_si128((__m128i *)(y1 + x), blockLuma128(b0, b1));
+
+        // 上下两个块相加后水平相邻两个相加
+        const __m128i rs = _mm_hadd_epi16(_mm_add_epi16(a0.r, b0.r), _mm_add_epi16(a1.r, b1.r));
+        const __m128i gs = _mm_hadd_epi16(_mm_add_epi16(a0.g, b0.g), _mm_add_epi16(a1.g, b1.g));
+        const __m128i bs = _mm_hadd_epi16(_mm_add_epi16(a0.b, b0.b), _mm_add_epi16(a1.b, b1.b));
+        const __m128i uc = weightedSum128<12>(rs, gs, bs, -38, -74, 112, 128);
+        const __m128i vc = weightedSum128<12>(rs, gs, bs, 112, -94, -18, 128);
+        _mm_storel_epi64((__m128i *)(u + x / 2), _mm_packus_epi16(uc, uc));
+        _mm_storel_epi64((__m128i *)(v + x / 2), _mm_packus_epi16(vc, vc));
+    }
+    return x;
+}
+
+struct BlockSums256
+{
+    __m256i r, g, b;
+};
+
+// 两行各 32 个源像素 -> 16 个输出像素的 2x2 块和，两个 128 位通道依次各 8 个
+TARGET_AVX2 static inline BlockSums256 blockSums256(const uint8_t *row0, const uint8_t *row1)
+{
+    const __m256i ones = _mm256_set1_epi8(1);
+    const Rgb256 p0 = deinterleave256(row0);
+    const Rgb256 p1 = deinterleave256(row1);
+    BlockSums256 out;
+    out.r = _mm256_add_epi16(_mm256_maddubs_epi16(p0.r, ones), _mm256_maddubs_epi16(p1.r, ones));
+    out.g = _mm256_add_epi16(_mm256_maddubs_epi16(p0.g, ones), _mm256_maddubs_epi16(p1.g, ones));
+    out.b = _mm256_add_epi16(_mm256_maddubs_epi16(p0.b, ones), _mm256_maddubs_epi16(p1.b, ones));
+    return out;
+}
+
+// lo 为第 0~15 个输出像素，hi 为第 16~31 个；通道内 pack 后按 64 位块重新排列
+TARGET_AVX2 static inline __m256i blockLuma256(const BlockSums256 &lo, const BlockSums256 &hi)
+{
+    __m256i y = _mm256_packus_epi16(weightedSum256<10>(lo.r, lo.g, lo.b, 66, 129, 25, 16),
+                                    weightedSum256<10>(hi.r, hi.g, hi.b, 66, 129, 25, 16));
+    return _mm256_permute4x64_epi64(y, 0xD8);
+}
+
+// 先把两组的同一通道拼在一起，hadd 之后色度保持原始顺序
+TARGET_AVX2 static inline __m256i chromaSum256(__m256i a0, __m256i b0, __m256i a1, __m256i b1)
+{
+    const __m256i lo = _mm256_add_epi16(a0, b0);
+    const __m256i hi = _mm256_add_epi16(a1, b1);
+    return _mm256_hadd_epi16(_mm256_permute2x128_si256(lo, hi, 0x20), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+TARGET_AVX2 int rgb24Downscale2RowPairAvx2(const uint8_t *const rgb[4],
+                                           uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, int width)
+{
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        const int offset = x * 2 * 3;
+        const BlockSums256 a0 = blockSums256(rgb[0] + offset, rgb[1] + offset);
+        const BlockSums256 a1 = blockSums256(rgb[0] + offset + 96, rgb[1] + offset + 96);
+        const BlockSums256 b0 = blockSums256(rgb[2] + offset, rgb[3] + offset);
+        const BlockSums256 b1 = blockSums256(rgb[2] + offset + 96, rgb[3] + offset + 96);
+        _mm256_storeu_si256((__m256i *)(y0 + x), blockLuma256(a0, a1));
+        _mm256_storeu_si256((__m256i *)(y1 + x), blockLuma256(b0, b1));
+
+        const __m256i rs = chromaSum256(a0.r, b0.r, a1.r, b1.r);
+        const __m256i gs = chromaSum256(a0.g, b0.g, a1.g, b1.g);
+        const __m256i bs = chromaSum256(a0.b, b0.b, a1.b, b1.b);
+        _mm_storeu_si128((__m128i *)(u + x / 2), packChroma256(weightedSum256<12>(rs, gs, bs, -38, -74, 112, 128)));
+        _mm_storeu_si128((__m128i *)(v + x / 2), packChroma256(weightedSum256<12>(rs, gs, bs, 112, -94, -18, 128)));
+    }
+    if (x < width)
+    {
+        const int offset = x * 2 * 3;
+        const uint8_t *const rest[4] = {rgb[0] + offset, rgb[1] + offset, rgb[2] + offset, rgb[3] + offset};
+        x += rgb24Downscale2RowPairSse41(rest, y0 + x, y1 + x, u + x / 2, v + x / 2, width - x);
+    }
+    return x;
+}
+
+} // namespace ColorConvert
+
+#endif // COLORCONVERT_X86
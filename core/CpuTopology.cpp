@@ -0,0 +1,312 @@
+#include "CpuTopology.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#if !defined (_WIN32) && !defined (_WIN64)
+#define LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#else
+#define WINDOWS
+#include <windows.h>
+#endif
+
+namespace CpuTopology
+{
+
+#if defined (LINUX)
+
+// 读取文件的第一行，去掉行尾换行
+static bool read_line(const std::string &path, std::string &line)
+{
+    FILE *fp = fopen(path.c_str(), "r");
+    if (fp == NULL)
+        return false;
+    char buf[4096];
+    bool ok = fgets(buf, sizeof(buf), fp) != NULL;
+    fclose(fp);
+    if (!ok)
+        return false;
+    line = buf;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+        line.pop_back();
+    return true;
+}
+
+static int read_int(const std::string &path, int default_value)
+{
+    std::string line;
+    if (!read_line(path, line) || line.empty())
+        return default_value;
+    return atoi(line.c_str());
+}
+
+// 解析 "0-3,8,10-11" 形式的 CPU 列表
+static std::vector<int> parse_cpu_list(const std::string &list)
+{
+    std::vector<int> cpus;
+    const char *p = list.c_str();
+    while (*p)
+    {
+        char *end = NULL;
+        long first = strtol(p, &end, 10);
+        if (end == p)
+            break;
+        long last = first;
+        p = end;
+        if (*p == '-')
+        {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; ++cpu)
+            cpus.push_back((int)cpu);
+        if (*p == ',')
+            ++p;
+    }
+    return cpus;
+}
+
+static std::vector<int> affinity_cpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+    }
+    if (cpus.empty())
+    {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = 0; cpu < std::max(1L, count); ++cpu)
+            cpus.push_back((int)cpu);
+    }
+    return cpus;
+}
+
+// cgroup v2：cpu.max 内容为 "max 100000" 或 "<quota> <period>"
+static double read_cpu_max(const std::string &dir)
+{
+    std::string line;
+    if (!read_line(dir + "/cpu.max", line))
+        return 0;
+    char quota[32] = {0};
+    long period = 0;
+    if (sscanf(line.c_str(), "%31s %ld", quota, &period) != 2 || period <= 0 || strcmp(quota, "max") == 0)
+        return 0;
+    return (double)atol(quota) / period;
+}
+
+// cgroup v1：cpu.cfs_quota_us 为 -1 表示不限制
+static double read_cfs_quota(const std::string &dir)
+{
+    int quota = read_int(dir + "/cpu.cfs_quota_us", -1);
+    int period = read_int(dir + "/cpu.cfs_period_us", 0);
+    if (quota <= 0 || period <= 0)
+        return 0;
+    return (double)quota / period;
+}
+
+// 从 cgroup 路径向上逐级读取配额，取最小值（父 cgroup 的限制同样生效）
+static double walk_quota(const std::string &root, std::string path, double (*read_quota)(const std::string &))
+{
+    double result = 0;
+    while (true)
+    {
+        double quota = read_quota(root + path);
+        if (quota > 0 && (result <= 0 || quota < result))
+            result = quota;
+        if (path.empty() || path == "/")
+            break;
+        size_t pos = path.find_last_of('/');
+        path = pos == 0 || pos == std::string::npos ? "/" : path.substr(0, pos);
+    }
+    return result;
+}
+
+static double cgroup_cpu_quota()
+{
+    FILE *fp = fopen("/proc/self/cgroup", "r");
+    if (fp == NULL)
+        return 0;
+    std::string v1_path, v2_path;
+    bool has_v1 = false, has_v2 = false;
+    char buf[4096];
+    // 每行格式为 "hierarchy-ID:controller-list:cgroup-path"
+    while (fgets(buf, sizeof(buf), fp))
+    {
+        std::string line(buf);
+        while (!line.empty() && line.back() == '\n')
+            line.pop_back();
+        size_t first = line.find(':');
+        size_t second = first == std::string::npos ? std::string::npos : line.find(':', first + 1);
+        if (second == std::string::npos)
+            continue;
+        std::string controllers = line.substr(first + 1, second - first - 1);
+        std::string path = line.substr(second + 1);
+        if (controllers.empty())
+        {
+            has_v2 = true;
+            v2_path = path;
+            continue;
+        }
+        std::string list = "," + controllers + ",";
+        if (list.find(",cpu,") != std::string::npos)
+        {
+            has_v1 = true;
+            v1_path = path;
+        }
+    }
+    fclose(fp);
+
+    // 容器内通常挂载的是自己的 cgroup 命名空间，宿主机视角的路径不存在，逐级向上最终会读到挂载点根目录
+    double quota = 0;
+    if (has_v1)
+    {
+        const char *roots[] = {"/sys/fs/cgroup/cpu,cpuacct", "/sys/fs/cgroup/cpu"};
+        for (const char *root : roots)
+        {
+            quota = walk_quota(root, v1_path, read_cfs_quota);
+            if (quota > 0)
+                break;
+        }
+    }
+    if (quota <= 0 && has_v2)
+        quota = walk_quota("/sys/fs/cgroup", v2_path, read_cpu_max);
+    return quota;
+}
+
+static Topology detect()
+{
+    Topology topo;
+    std::vector<int> cpus = affinity_cpus();
+
+    // 逻辑 CPU -> NUMA 节点，没有 NUMA 信息时全部属于节点 0
+    std::map<int, int> cpu_node;
+    std::string online;
+    if (read_line("/sys/devices/system/node/online", online))
+    {
+        for (int node : parse_cpu_list(online))
+        {
+            std::string list;
+            if (!read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", list))
+                continue;
+            for (int cpu : parse_cpu_list(list))
+                cpu_node[cpu] = node;
+        }
+    }
+
+    std::set<std::pair<int, int>> physical;
+    std::set<int> nodes;
+    for (int cpu : cpus)
+    {
+        const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        CpuInfo info;
+        info.cpu = cpu;
+        info.core = read_int(dir + "core_id", cpu);
+        info.package = read_int(dir + "physical_package_id", 0);
+        auto it = cpu_node.find(cpu);
+        info.node = it == cpu_node.end() ? 0 : it->second;
+        topo.cpus.push_back(info);
+        physical.insert(std::make_pair(info.package, info.core));
+        nodes.insert(info.node);
+    }
+    topo.nodes.assign(nodes.begin(), nodes.end());
+    topo.physical_cores = (int)physical.size();
+    topo.cpu_quota = cgroup_cpu_quota();
+    topo.usable_cpus = (int)topo.cpus.size();
+    if (topo.cpu_quota > 0)
+        topo.usable_cpus = std::min(topo.usable_cpus, std::max(1, (int)std::ceil(topo.cpu_quota)));
+    return topo;
+}
+
+bool pin_current_thread(const std::vector<int> &cpus)
+{
+    if (cpus.empty())
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+#elif defined (WINDOWS)
+
+static Topology detect()
+{
+    Topology topo;
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    for (DWORD cpu = 0; cpu < si.dwNumberOfProcessors; ++cpu)
+    {
+        CpuInfo info;
+        info.cpu = info.core = (int)cpu;
+        topo.cpus.push_back(info);
+    }
+    topo.nodes.push_back(0);
+    topo.physical_cores = (int)topo.cpus.size();
+    topo.usable_cpus = std::max(1, (int)topo.cpus.size());
+    return topo;
+}
+
+bool pin_current_thread(const std::vector<int> &cpus)
+{
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < (int)(sizeof(mask) * 8))
+            mask |= (DWORD_PTR)1 << cpu;
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
+#endif
+
+const Topology &get()
+{
+    static const Topology topo = detect();
+    return topo;
+}
+
+std::vector<int> node_cpus(int node, bool physical_only)
+{
+    std::vector<int> cpus;
+    std::set<std::pair<int, int>> seen;
+    for (const CpuInfo &info : get().cpus)
+    {
+        if (node >= 0 && info.node != node)
+            continue;
+        if (physical_only && !seen.insert(std::make_pair(info.package, info.core)).second)
+            continue;
+        cpus.push_back(info.cpu);
+    }
+    return cpus;
+}
+
+int node_for_index(int index)
+{
+    const std::vector<int> &nodes = get().nodes;
+    if (nodes.empty())
+        return 0;
+    return nodes[(size_t)std::abs(index) % nodes.size()];
+}
+
+} // namespace CpuTopology
@@ -0,0 +1,71 @@
+#ifndef CPUTOPOLOGY_H
+#define CPUTOPOLOGY_H
+
+#include <vector>
+
+/**
+ * @brief 进程可用的 CPU 拓扑：亲和性掩码、cgroup 配额、物理核与超线程、NUMA 节点
+ */
+namespace CpuTopology
+{
+
+/**
+ * @brief 一个逻辑 CPU 的位置
+ */
+struct CpuInfo
+{
+    int cpu = 0;     ///< 逻辑 CPU 编号
+    int core = 0;    ///< 所在物理核编号（同一封装内唯一）
+    int package = 0; ///< 所在封装（插槽）编号
+    int node = 0;    ///< 所在 NUMA 节点编号
+};
+
+/**
+ * @brief 进程可用的 CPU 拓扑
+ */
+struct Topology
+{
+    std::vector<CpuInfo> cpus; ///< 亲和性掩码允许的逻辑 CPU，按编号升序
+    std::vector<int> nodes;    ///< 可用 CPU 所在的 NUMA 节点，按编号升序
+    int physical_cores = 0;    ///< 可用 CPU 对应的物理核数，超线程的兄弟 CPU 只计一次
+    double cpu_quota = 0;      ///< cgroup 限制的 CPU 个数（quota / period），0 表示不限制
+    int usable_cpus = 1;       ///< 实际可以并行运行的线程数：亲和性 CPU 数与 cgroup 配额取较小值
+};
+
+/**
+ * @brief 获取进程可用的 CPU 拓扑，首次调用时检测，之后返回缓存的结果
+ *
+ * Linux 下依次读取 sched_getaffinity、/sys/devices/system/cpu、/sys/devices/system/node
+ * 以及 /proc/self/cgroup 指向的 cgroup v1（cpu.cfs_quota_us）或 v2（cpu.max）配额。
+ * 读取失败的部分退化为单 NUMA 节点、每个逻辑 CPU 一个物理核、不限制配额。
+ */
+const Topology &get();
+
+/**
+ * @brief 获取一个 NUMA 节点上的可用 CPU
+ *
+ * @param node NUMA 节点编号，小于 0 时返回所有可用 CPU
+ * @param physical_only 为 true 时每个物理核只返回一个逻辑 CPU，避免两个线程落在同一核的超线程上
+ * @return std::vector<int> 逻辑 CPU 编号，节点不存在时为空
+ */
+std::vector<int> node_cpus(int node, bool physical_only = false);
+
+/**
+ * @brief 把第 index 个对象（例如第 index 路会话）轮流分配到各 NUMA 节点
+ *
+ * @param index 对象序号
+ * @return int NUMA 节点编号
+ */
+int node_for_index(int index);
+
+/**
+ * @brief 把当前线程绑定到指定的 CPU 集合
+ *
+ * @param cpus 逻辑 CPU 编号，为空时不做任何操作
+ * @return bool 绑定成功返回 true
+ */
+bool pin_current_thread(const std::vector<int> &cpus);
+
+} // namespace CpuTopology
+
+#endif // CPUTOPOLOGY_H
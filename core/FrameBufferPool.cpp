@@ -0,0 +1,135 @@
+#include "FrameBufferPool.h"
+#include <new>
+#include <vector>
+
+extern "C"
+{
+#include <libavutil/buffer.h>
+}
+
+/**
+ * @brief 借出的池内缓冲区，释放时先递减借出计数，再把底层缓冲区归还 AVBufferPool
+ */
+struct PooledBuffer
+{
+    AVBufferRef *ref;
+    std::shared_ptr<std::atomic<int>> outstanding;
+};
+
+static void release_pooled_buffer(void *opaque, uint8_t * /* data */)
+{
+    PooledBuffer *pooled = (PooledBuffer *)opaque;
+    --*pooled->outstanding;
+    av_buffer_unref(&pooled->ref);
+    delete pooled;
+}
+
+FrameBufferPool::FrameBufferPool(int byte_size, int capacity)
+    : outstanding(std::make_shared<std::atomic<int>>(0))
+{
+    if (byte_size > 0)
+        reset(byte_size, capacity);
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // 未归还的缓冲区会在最后一个引用释放时由 FFmpeg 回收
+    av_buffer_pool_uninit(&pool);
+}
+
+bool FrameBufferPool::reset(int byte_size, int capacity)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    av_buffer_pool_uninit(&pool);
+    this->byte_size = byte_size > 0 ? byte_size : 0;
+    this->capacity = capacity > 0 ? capacity : 0;
+    prewarmed = 0;
+    outstanding = std::make_shared<std::atomic<int>>(0);
+    if (0 == this->byte_size)
+        return true;
+
+    pool = av_buffer_pool_init(this->byte_size, av_buffer_alloc);
+    if (!pool)
+    {
+        this->byte_size = 0;
+        return false;
+    }
+    prewarm(this->capacity);
+    return true;
+}
+
+void FrameBufferPool::setCapacity(int capacity)
+{
+    if (capacity < 0)
+        capacity = 0;
+    int cur_byte_size = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (capacity >= this->capacity / 2 || !pool)
+        {
+            this->capacity = capacity;
+            prewarm(capacity);
+            return;
+        }
+        cur_byte_size = byte_size;
+    }
+    // 容量大幅缩小，重建缓冲池以释放多余的缓存
+    reset(cur_byte_size, capacity);
+}
+
+AVBufferRef *FrameBufferPool::acquire()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!pool)
+        return nullptr;
+    // 超出容量的缓冲区不进入池，池中缓存的缓冲区个数不超过容量
+    if (*outstanding >= capacity)
+        return av_buffer_alloc(byte_size);
+    AVBufferRef *ref = av_buffer_pool_get(pool);
+    if (!ref)
+        return nullptr;
+    PooledBuffer *pooled = new (std::nothrow) PooledBuffer{ref, outstanding};
+    AVBufferRef *out = pooled ? av_buffer_create(ref->data, ref->size, release_pooled_buffer, pooled, 0) : nullptr;
+    if (!out)
+    {
+        delete pooled;
+        av_buffer_unref(&ref);
+        return nullptr;
+    }
+    ++*outstanding;
+    return out;
+}
+
+int FrameBufferPool::getByteSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return byte_size;
+}
+
+int FrameBufferPool::getCapacity() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity;
+}
+
+void FrameBufferPool::prewarm(int count)
+{
+    if (count > MAX_PREWARM)
+        count = MAX_PREWARM;
+    if (!pool || count <= prewarmed)
+        return;
+    // 同时持有 count 个缓冲区再全部释放，池中便缓存了 count 个缓冲区
+    std::vector<AVBufferRef *> refs;
+    refs.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        AVBufferRef *ref = av_buffer_pool_get(pool);
+        if (!ref)
+            break;
+        refs.push_back(ref);
+    }
+    for (auto &ref : refs)
+        av_buffer_unref(&ref);
+    prewarmed = count;
+}
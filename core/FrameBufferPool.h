@@ -0,0 +1,105 @@
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+struct AVBufferPool;
+struct AVBufferRef;
+
+/**
+ * @class FrameBufferPool
+ * @brief 基于 AVBufferPool 的定长帧缓冲池，为 FramePtrWrapper 提供可复用的引用计数缓冲区。
+ *
+ * 池中的每个缓冲区大小相同（一帧图像的字节数）。缓冲区在最后一个引用释放后自动回到池中，
+ * 避免每帧都进行 malloc/free。池的容量是同时借出的池内缓冲区个数的上限，也就是池中最多缓存的缓冲区个数；
+ * 借出的缓冲区达到容量后，acquire() 返回不属于池的缓冲区，释放时直接归还系统，内存占用随容量有界。
+ * 容量可以随队列长度调整，收缩时会重建底层 AVBufferPool，旧缓冲区在其引用全部释放后由 FFmpeg 自动回收。
+ * 只预分配最多 MAX_PREWARM 个缓冲区，其余在首次使用时分配，队列较长时不会一次占用全部内存。
+ * 该类是线程安全的，生产者与消费者线程可以同时获取和释放缓冲区。
+ */
+class FrameBufferPool
+{
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param byte_size 每个缓冲区的字节大小，为 0 时表示暂不创建底层缓冲池
+     * @param capacity 池中最多缓存的缓冲区个数
+     */
+    FrameBufferPool(int byte_size = 0, int capacity = 0);
+
+    /**
+     * @brief 析构函数
+     * 释放底层缓冲池，尚在使用中的缓冲区会在其引用全部释放后自动回收。
+     */
+    ~FrameBufferPool();
+
+    FrameBufferPool(const FrameBufferPool &) = delete;
+    FrameBufferPool &operator=(const FrameBufferPool &) = delete;
+
+    /**
+     * @brief 重新设置缓冲区大小和容量
+     *
+     * 当缓冲区大小发生变化（如分辨率变化）时重建底层缓冲池。
+     *
+     * @param byte_size 每个缓冲区的字节大小
+     * @param capacity 池中最多缓存的缓冲区个数
+     * @return bool 成功返回 true，失败返回 false
+     */
+    bool reset(int byte_size, int capacity);
+
+    /**
+     * @brief 调整缓冲池的容量
+     *
+     * 扩容时补足预分配的缓冲区；容量缩小到原来一半以下时重建缓冲池以归还多余内存。
+     *
+     * @param capacity 新的容量
+     */
+    void setCapacity(int capacity);
+
+    /**
+     * @brief 从池中获取一个缓冲区
+     *
+     * 借出的池内缓冲区个数达到容量时分配一个不属于池的缓冲区。
+     *
+     * @return AVBufferRef* 引用计数为 1 的缓冲区，调用者负责 av_buffer_unref；失败或未初始化时返回 nullptr
+     */
+    AVBufferRef *acquire();
+
+    /**
+     * @brief 获取每个缓冲区的字节大小
+     *
+     * @return int 缓冲区字节大小
+     */
+    int getByteSize() const;
+
+    /**
+     * @brief 获取缓冲池的容量
+     *
+     * @return int 缓冲池容量
+     */
+    int getCapacity() const;
+
+    /**
+     * @brief 预分配的缓冲区个数上限，超出的部分按需分配
+     */
+    static const int MAX_PREWARM = 4;
+
+private:
+    /**
+     * @brief 预分配缓冲区，使池中至少缓存 min(count, MAX_PREWARM) 个缓冲区（调用者需持有锁）
+     */
+    void prewarm(int count);
+
+    AVBufferPool *pool = nullptr; // 底层 FFmpeg 缓冲池
+    int byte_size = 0;            // 每个缓冲区的字节大小
+    int capacity = 0;             // 池中最多缓存的缓冲区个数
+    int prewarmed = 0;            // 已经预分配过的缓冲区个数
+    // 借出的池内缓冲区个数，缓冲区释放时递减；重建缓冲池时换用新的计数，池对象析构后仍可能被访问
+    std::shared_ptr<std::atomic<int>> outstanding;
+    mutable std::mutex mutex;     // 保护 pool 指针的替换
+};
+
+#endif // FRAMEBUFFERPOOL_H
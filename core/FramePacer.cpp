@@ -0,0 +1,105 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+
+#if !defined (_WIN32) && !defined (_WIN64)
+#define LINUX
+#include <time.h>
+#else
+#define WINDOWS
+#include <chrono>
+#include <thread>
+#endif
+
+// 单次休眠的最长时间，超过后检查取消标志
+static const int64_t MAX_SLEEP_SLICE_US = 100000;
+
+FramePacer::FramePacer(int64_t max_late_us, int64_t resync_us)
+    : max_late_us(max_late_us), resync_us(resync_us > 0 ? resync_us : 2000000)
+{
+}
+
+void FramePacer::reset()
+{
+    has_origin = false;
+}
+
+int64_t FramePacer::now()
+{
+#if defined (LINUX)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+FramePacer::Action FramePacer::wait(int64_t timestamp, const std::atomic<bool> *cancel)
+{
+    int64_t cur = now();
+    if (!has_origin)
+    {
+        // 第一帧立即送出
+        origin = cur - timestamp;
+        has_origin = true;
+    }
+
+    int64_t delay = origin + timestamp - cur;
+    if (delay > resync_us || -delay > resync_us)
+    {
+        // 长时间卡顿或时间戳跳变，不追赶也不成批丢帧，从该帧重新开始计时
+        origin = cur - timestamp;
+        ++resyncs;
+        delay = 0;
+    }
+    if (max_late_us > 0 && -delay > max_late_us)
+    {
+        ++dropped_frames;
+        return Drop;
+    }
+    if (delay > 0 && !sleepUntil(origin + timestamp, cancel))
+        return Cancelled;
+    if (delay < 0)
+    {
+        ++late_frames;
+        if (-delay > max_late)
+            max_late = -delay;
+    }
+    ++sent_frames;
+    return Send;
+}
+
+bool FramePacer::sleepUntil(int64_t deadline, const std::atomic<bool> *cancel)
+{
+    while (true)
+    {
+        if (cancel && *cancel)
+            return false;
+        int64_t cur = now();
+        if (cur >= deadline)
+            return true;
+        int64_t target = std::min(deadline, cur + MAX_SLEEP_SLICE_US);
+#if defined (LINUX)
+        // 绝对时间休眠，被信号打断后重新计算剩余时间即可
+        struct timespec ts;
+        ts.tv_sec = (time_t)(target / 1000000);
+        ts.tv_nsec = (long)(target % 1000000) * 1000;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+#else
+        std::this_thread::sleep_for(std::chrono::microseconds(target - cur));
+#endif
+    }
+}
+
+FramePacer::Stats FramePacer::getStats() const
+{
+    Stats stats;
+    stats.sent_frames = sent_frames;
+    stats.late_frames = late_frames;
+    stats.dropped_frames = dropped_frames;
+    stats.resyncs = resyncs;
+    stats.max_late_us = max_late;
+    return stats;
+}
@@ -0,0 +1,98 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class FramePacer
+ * @brief 按帧时间戳节拍送出帧的定时器，用于实时推流。
+ *
+ * 第一帧到达时建立时间戳与单调时钟的对应关系，之后每帧休眠到绝对截止时间
+ * （Linux 下为 clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME)），等待期间不占用 CPU，
+ * 休眠误差也不会逐帧累积。迟到的帧按以下规则处理：
+ * - 迟到不超过 max_late_us：立即送出，追赶节拍；
+ * - 迟到超过 max_late_us：丢弃，使输出延迟有界；
+ * - 迟到或提前超过 resync_us（网络卡顿、时间戳跳变）：重新建立对应关系，该帧立即送出。
+ *
+ * wait() 只能由取帧的线程调用，getStats() 可以在其他线程中调用。
+ */
+class FramePacer
+{
+public:
+    /**
+     * @brief 一帧的处理结果
+     */
+    enum Action
+    {
+        Send = 0,  ///< 帧已到期，应当送出
+        Drop,      ///< 帧迟到过多，应当丢弃
+        Cancelled, ///< 等待期间收到取消请求
+    };
+
+    /**
+     * @brief 节拍统计信息
+     */
+    struct Stats
+    {
+        int64_t sent_frames = 0;    ///< 送出的帧数
+        int64_t late_frames = 0;    ///< 迟到但仍然送出的帧数
+        int64_t dropped_frames = 0; ///< 迟到过多被丢弃的帧数
+        int64_t resyncs = 0;        ///< 重新建立时钟对应关系的次数
+        int64_t max_late_us = 0;    ///< 送出的帧的最大迟到时间（微秒）
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * @param max_late_us 允许迟到的最长时间（微秒），超过后丢帧；小于等于 0 表示从不丢帧
+     * @param resync_us 迟到或提前超过该时间（微秒）时重新对齐时钟
+     */
+    explicit FramePacer(int64_t max_late_us = 250000, int64_t resync_us = 2000000);
+
+    /**
+     * @brief 清除时钟对应关系，下一帧到达时重新建立
+     */
+    void reset();
+
+    /**
+     * @brief 等待时间戳为 timestamp 的帧到期
+     *
+     * 每次最长休眠 100ms 后检查 cancel，停止会话时能够及时返回。
+     *
+     * @param timestamp 帧时间戳（微秒）
+     * @param cancel 取消标志，为 true 时立即返回 Cancelled；可以为空
+     * @return Action 该帧的处理结果
+     */
+    Action wait(int64_t timestamp, const std::atomic<bool> *cancel = nullptr);
+
+    /**
+     * @brief 获取节拍统计信息
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief 获取单调时钟的当前时间（微秒）
+     */
+    static int64_t now();
+
+private:
+    /**
+     * @brief 休眠到单调时钟的绝对时间 deadline（微秒）
+     *
+     * @return bool 被取消时返回 false
+     */
+    bool sleepUntil(int64_t deadline, const std::atomic<bool> *cancel);
+
+    const int64_t max_late_us;
+    const int64_t resync_us;
+    bool has_origin = false;
+    int64_t origin = 0; // 时间戳 0 对应的单调时钟时间（微秒）
+    std::atomic<int64_t> sent_frames{0};
+    std::atomic<int64_t> late_frames{0};
+    std::atomic<int64_t> dropped_frames{0};
+    std::atomic<int64_t> resyncs{0};
+    std::atomic<int64_t> max_late{0};
+};
+
+#endif // FRAMEPACER_H
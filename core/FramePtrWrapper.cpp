@@ -1,10 +1,24 @@
 #include "FramePtrWrapper.h"
+#include "FrameBufferPool.h"
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
 #include <cstdio>
 #include <iostream>
 
+extern "C"
+{
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+static void free_malloc_buffer(void * /* opaque */, uint8_t *data)
+{
+    free(data);
+}
+
 int64_t FramePtrWrapper::getTimestamp() const
 {
     return timestamp;
@@ -15,6 +29,16 @@ void FramePtrWrapper::setTimestamp(int64_t value)
     timestamp = value;
 }
 
+bool FramePtrWrapper::isKeyFrame() const
+{
+    return key_frame;
+}
+
+void FramePtrWrapper::setKeyFrame(bool value)
+{
+    key_frame = value;
+}
+
 int FramePtrWrapper::getByteSize() const
 {
     return byte_size;
@@ -29,9 +53,10 @@ FramePtrWrapper::FramePtrWrapper(void *data_ptr, int byte_size, int64_t timestam
         this->timestamp = -1;
         return;
     }
-    this->data_ptr = malloc(byte_size);
-    assert(NULL != this->data_ptr);
+    this->buf = av_buffer_alloc(byte_size);
+    assert(NULL != this->buf);
     assert(NULL != data_ptr);
+    this->data_ptr = this->buf->data;
     memcpy(this->data_ptr, data_ptr, byte_size);
     this->byte_size = byte_size;
     this->timestamp = timestamp;
@@ -46,90 +71,148 @@ FramePtrWrapper::FramePtrWrapper(int byte_size)
         this->timestamp = -1;
         return;
     }
-    this->data_ptr = malloc(byte_size);
+    this->buf = av_buffer_alloc(byte_size);
+    assert(NULL != this->buf);
+    this->data_ptr = this->buf->data;
     this->byte_size = byte_size;
     this->timestamp = -1;
 }
 
+FramePtrWrapper::FramePtrWrapper(FrameBufferPool &pool, int64_t timestamp)
+{
+    this->buf = pool.acquire();
+    if (!this->buf)
+        return;
+    this->data_ptr = this->buf->data;
+    this->byte_size = pool.getByteSize();
+    this->timestamp = timestamp;
+}
+
+FramePtrWrapper::FramePtrWrapper(FrameBufferPool &pool, const void *data_ptr, int byte_size, int64_t timestamp)
+{
+    if (byte_size <= 0)
+        return;
+    if (byte_size == pool.getByteSize())
+        this->buf = pool.acquire();
+    if (!this->buf)
+        this->buf = av_buffer_alloc(byte_size);
+    assert(NULL != this->buf);
+    assert(NULL != data_ptr);
+    this->data_ptr = this->buf->data;
+    memcpy(this->data_ptr, data_ptr, byte_size);
+    this->byte_size = byte_size;
+    this->timestamp = timestamp;
+}
+
+FramePtrWrapper::FramePtrWrapper(const AVFrame *frame, int64_t timestamp)
+{
+    if (!frame || !frame->data[0])
+        return;
+    // 只增加帧缓冲区的引用计数
+    this->frame = av_frame_clone(frame);
+    assert(NULL != this->frame);
+    this->data_ptr = this->frame->data[0];
+    this->pix_fmt = frame->format;
+    this->width = frame->width;
+    this->height = frame->height;
+    int size = av_image_get_buffer_size((AVPixelFormat)frame->format, frame->width, frame->height, 1);
+    this->byte_size = size > 0 ? size : 0;
+    this->timestamp = timestamp;
+}
+
 FramePtrWrapper::FramePtrWrapper(const FramePtrWrapper &other)
 {
-    this->byte_size = other.byte_size;
-    if (0 != this->byte_size)
+    if (other.buf)
+    {
+        this->buf = av_buffer_ref(other.buf);
+        assert(NULL != this->buf);
+        this->data_ptr = other.data_ptr;
+        this->byte_size = other.byte_size;
+    }
+    if (other.frame)
     {
-        this->data_ptr = malloc(this->byte_size);
-        assert(NULL != this->data_ptr);
-        memcpy(this->data_ptr, other.data_ptr, this->byte_size);
+        this->frame = av_frame_clone(other.frame);
+        assert(NULL != this->frame);
+        this->data_ptr = this->frame->data[0];
+        this->byte_size = other.byte_size;
     }
     this->timestamp = other.timestamp;
+    this->key_frame = other.key_frame;
+    this->pix_fmt = other.pix_fmt;
+    this->width = other.width;
+    this->height = other.height;
 }
 
 FramePtrWrapper &FramePtrWrapper::operator=(const FramePtrWrapper &other)
 {
-    if (this->data_ptr)
-        free(this->data_ptr);
-
-    this->byte_size = other.byte_size;
-    if (0 != this->byte_size)
-    {
-        this->data_ptr = malloc(this->byte_size);
-        assert(NULL != this->data_ptr);
-        memcpy(this->data_ptr, other.data_ptr, this->byte_size);
-    }
-    this->timestamp = other.timestamp;
+    if (this == &other)
+        return *this;
+    FramePtrWrapper tmp(other);
+    swap(tmp);
     return *this;
 }
 
 FramePtrWrapper::FramePtrWrapper(FramePtrWrapper &&other)
 {
-    this->byte_size = other.byte_size;
-    other.byte_size = 0;
-    this->data_ptr = other.data_ptr;
-    other.data_ptr = nullptr;
-    this->timestamp = other.timestamp;
-    other.timestamp = -1;
+    swap(other);
 }
 
 FramePtrWrapper &FramePtrWrapper::operator=(FramePtrWrapper &&other)
 {
-    if (this->data_ptr)
-        free(this->data_ptr);
-    this->byte_size = other.byte_size;
-    other.byte_size = 0;
-    this->data_ptr = other.data_ptr;
-    other.data_ptr = nullptr;
-    this->timestamp = other.timestamp;
-    other.timestamp = -1;
+    if (this == &other)
+        return *this;
+    release();
+    swap(other);
     return *this;
 }
 
 void FramePtrWrapper::swap(FramePtrWrapper &other)
 {
+    std::swap(this->buf, other.buf);
     std::swap(this->byte_size, other.byte_size);
     std::swap(this->data_ptr, other.data_ptr);
     std::swap(this->timestamp, other.timestamp);
+    std::swap(this->key_frame, other.key_frame);
+    std::swap(this->frame, other.frame);
+    std::swap(this->pix_fmt, other.pix_fmt);
+    std::swap(this->width, other.width);
+    std::swap(this->height, other.height);
 }
 
 FramePtrWrapper::~FramePtrWrapper()
 {
-    if (this->data_ptr)
-    {
-        free(this->data_ptr);
-        this->data_ptr = nullptr;
-    }
-    this->byte_size = 0;
+    release();
+}
+
+void FramePtrWrapper::release()
+{
+    releaseData();
     this->timestamp = -1;
+    this->key_frame = false;
+}
+
+void FramePtrWrapper::releaseData()
+{
+    // 引用计数归零时缓冲区被释放或回到缓冲池
+    av_buffer_unref(&this->buf);
+    av_frame_free(&this->frame);
+    this->data_ptr = nullptr;
+    this->byte_size = 0;
+    this->pix_fmt = -1;
+    this->width = 0;
+    this->height = 0;
 }
 
 void FramePtrWrapper::setDataPtr(void *data_ptr, int byte_size)
 {
     if (byte_size <= 0)
         return;
-    if (this->data_ptr)
-        free(this->data_ptr);
+    releaseData();
 
-    this->data_ptr = malloc(byte_size);
-    assert(NULL != this->data_ptr);
+    this->buf = av_buffer_alloc(byte_size);
+    assert(NULL != this->buf);
     assert(NULL != data_ptr);
+    this->data_ptr = this->buf->data;
     memcpy(this->data_ptr, data_ptr, byte_size);
     this->byte_size = byte_size;
 }
@@ -138,24 +221,129 @@ void FramePtrWrapper::bindDataPtr(void *data_ptr, int byte_size)
 {
     if (byte_size <= 0)
         return;
+    assert(NULL != data_ptr);
+    releaseData();
+    this->buf = av_buffer_create((uint8_t *)data_ptr, byte_size, free_malloc_buffer, NULL, 0);
+    assert(NULL != this->buf);
     this->data_ptr = data_ptr;
-    assert(NULL != this->data_ptr);
     this->byte_size = byte_size;
 }
 
+void FramePtrWrapper::bindBuffer(AVBufferRef *buf)
+{
+    if (!buf)
+        return;
+    releaseData();
+    this->buf = buf;
+    this->data_ptr = buf->data;
+    this->byte_size = (int)buf->size;
+}
+
+bool FramePtrWrapper::isWritable() const
+{
+    if (this->frame)
+        return av_frame_is_writable(this->frame);
+    return this->buf && av_buffer_is_writable(this->buf);
+}
+
+bool FramePtrWrapper::makeWritable()
+{
+    if (this->frame)
+    {
+        if (av_frame_make_writable(this->frame) < 0)
+            return false;
+        this->data_ptr = this->frame->data[0];
+        return true;
+    }
+    if (!this->buf)
+        return false;
+    // 被其他对象共享时拷贝一份，之后的修改不会影响其他对象
+    if (av_buffer_make_writable(&this->buf) < 0)
+        return false;
+    this->data_ptr = this->buf->data;
+    return true;
+}
+
 void *FramePtrWrapper::getDataPtr() const
 {
     return data_ptr;
 }
 
+void FramePtrWrapper::setImageInfo(int pix_fmt, int width, int height)
+{
+    this->pix_fmt = pix_fmt;
+    this->width = width;
+    this->height = height;
+}
+
+AVFrame *FramePtrWrapper::getAVFrame() const
+{
+    return frame;
+}
+
+int FramePtrWrapper::getPixelFormat() const
+{
+    return pix_fmt;
+}
+
+int FramePtrWrapper::getWidth() const
+{
+    return width;
+}
+
+int FramePtrWrapper::getHeight() const
+{
+    return height;
+}
+
+int FramePtrWrapper::getPlaneCount() const
+{
+    if (pix_fmt < 0)
+        return data_ptr ? 1 : 0;
+    int count = av_pix_fmt_count_planes((AVPixelFormat)pix_fmt);
+    return count > 0 ? count : 0;
+}
+
+uint8_t *FramePtrWrapper::getPlane(int index) const
+{
+    if (index < 0 || index >= 4 || !data_ptr)
+        return nullptr;
+    if (frame)
+        return frame->data[index];
+    if (pix_fmt < 0)
+        return 0 == index ? (uint8_t *)data_ptr : nullptr;
+    // 打包数据按 1 字节对齐紧密排列，缓冲区小于图像信息描述的大小时不返回平面
+    if (av_image_get_buffer_size((AVPixelFormat)pix_fmt, width, height, 1) > byte_size)
+        return nullptr;
+    uint8_t *planes[4] = {0};
+    int strides[4] = {0};
+    if (av_image_fill_arrays(planes, strides, (uint8_t *)data_ptr, (AVPixelFormat)pix_fmt, width, height, 1) < 0)
+        return nullptr;
+    return planes[index];
+}
+
+int FramePtrWrapper::getStride(int index) const
+{
+    if (index < 0 || index >= 4 || !data_ptr)
+        return 0;
+    if (frame)
+        return frame->linesize[index];
+    if (pix_fmt < 0)
+        return 0;
+    int strides[4] = {0};
+    if (av_image_fill_linesizes(strides, (AVPixelFormat)pix_fmt, width) < 0)
+        return 0;
+    return strides[index];
+}
+
 void FramePtrWrapper::resize(int byte_size)
 {
-    if (this->data_ptr)
-        free(this->data_ptr);
-    this->byte_size = byte_size;
+    releaseData();
+    this->byte_size = byte_size > 0 ? byte_size : 0;
     if (0 != this->byte_size)
     {
-        this->data_ptr = malloc(this->byte_size);
-        assert(NULL != this->data_ptr);
+        this->buf = av_buffer_alloc(this->byte_size);
+        assert(NULL != this->buf);
+        this->data_ptr = this->buf->data;
     }
 }
@@ -3,19 +3,46 @@
 
 #include <cstdint>
 
+struct AVBufferRef;
+struct AVFrame;
+class FrameBufferPool;
+
 /**
  * @class FramePtrWrapper
  * @brief 用于封装数据指针及其相关信息的类，提供了数据管理和操作的功能。
  * 
  * 该类管理一个指向数据的指针，同时记录数据的字节大小和时间戳。
- * 支持深拷贝、移动语义等操作，确保数据的安全管理和高效使用。
+ * 数据存放在引用计数的 AVBufferRef 中，拷贝时共享同一块缓冲区而不是深拷贝，
+ * 缓冲区可以来自 FrameBufferPool 以避免每帧 malloc。
+ * 需要修改共享数据前应调用 makeWritable()。
+ *
+ * 除了单块的打包数据（如 RGB24），该类还可以引用一个 AVFrame，以原生像素格式保存多平面图像，
+ * 通过 getPlane()/getStride()/getPixelFormat() 访问各个平面，拷贝时只增加 AVFrame 的引用计数。
  */
 class FramePtrWrapper
 {
 private:
+    AVBufferRef* buf = nullptr; // 引用计数的数据缓冲区
     void* data_ptr = nullptr;  // 指向数据的指针，初始化为空指针
     int byte_size = 0;         // 数据的字节大小，初始化为 0
     int64_t timestamp = -1;    // 数据的时间戳，初始化为 -1，表示无效时间戳
+    bool key_frame = false;    // 是否为关键帧（GOP 的第一帧）
+    AVFrame* frame = nullptr;  // 引用的原生格式图像帧，为空时数据存放在 buf 中
+    int pix_fmt = -1;          // 图像的像素格式（AVPixelFormat），-1 表示未知
+    int width = 0;             // 图像宽度
+    int height = 0;            // 图像高度
+
+    /**
+     * @brief 释放持有的数据和帧引用，并恢复默认值
+     */
+    void release();
+
+    /**
+     * @brief 释放当前的缓冲区和帧引用，并清除图像信息，替换数据之前调用
+     *
+     * 旧的像素格式和宽高不适用于新的数据，保留会使 getPlane() 按错误的布局越界访问。
+     */
+    void releaseData();
 
 public:
     /**
@@ -43,17 +70,46 @@ public:
     FramePtrWrapper(int byte_size);
 
     /**
-     * @brief 深拷贝构造函数
-     * 创建一个新对象，复制另一个对象的数据。
+     * @brief 构造函数
+     * 从缓冲池中获取一块未初始化的缓冲区，调用者可以直接向 getDataPtr() 写入数据，省去一次拷贝。
+     * 
+     * @param pool 缓冲池，字节大小由缓冲池决定
+     * @param timestamp 数据的时间戳，默认为 -1
+     */
+    FramePtrWrapper(FrameBufferPool& pool, int64_t timestamp = -1);
+
+    /**
+     * @brief 构造函数
+     * 从缓冲池中获取缓冲区并拷贝数据，byte_size 与缓冲池大小不一致时退化为普通分配。
+     * 
+     * @param pool 缓冲池
+     * @param data_ptr 指向数据的指针
+     * @param byte_size 数据的字节大小
+     * @param timestamp 数据的时间戳，默认为 -1
+     */
+    FramePtrWrapper(FrameBufferPool& pool, const void* data_ptr, int byte_size, int64_t timestamp = -1);
+
+    /**
+     * @brief 构造函数
+     * 引用一个原生像素格式的图像帧，不拷贝像素数据。
+     * 
+     * @param frame 要引用的图像帧，调用者仍然负责释放自己的 frame
+     * @param timestamp 数据的时间戳，默认为 -1
+     */
+    FramePtrWrapper(const AVFrame* frame, int64_t timestamp = -1);
+
+    /**
+     * @brief 拷贝构造函数
+     * 创建一个新对象，与另一个对象共享同一块数据缓冲区（引用计数加一）。
      * 
      * @param other 要复制的对象
      */
-    // 深拷贝 拷贝构造
+    // 浅拷贝 拷贝构造
     FramePtrWrapper(const FramePtrWrapper& other);
 
     /**
      * @brief 赋值运算符重载
-     * 将另一个对象的数据复制到当前对象。
+     * 释放当前数据的引用，并与另一个对象共享数据缓冲区。
      * 
      * @param other 要复制的对象
      * @return FramePtrWrapper& 返回当前对象的引用
@@ -82,7 +138,7 @@ public:
 
     /**
      * @brief 交换两个对象的资源
-     * 交换当前对象和另一个对象的数据指针、字节大小和时间戳。
+     * 交换当前对象和另一个对象的数据指针、字节大小、时间戳和关键帧标志。
      * 
      * @param other 要交换的对象
      */
@@ -98,6 +154,8 @@ public:
     /**
      * @brief 设置数据指针和字节大小
      * 
+     * 图像信息被清除，需要时重新调用 setImageInfo()。
+     * 
      * @param data_ptr 指向数据的指针
      * @param byte_size 数据的字节大小
      */
@@ -105,12 +163,35 @@ public:
 
     /**
      * @brief 直接设置数据指针和字节大小
+     * 接管由 malloc 分配的数据指针，释放时调用 free。图像信息被清除。
      * 
      * @param data_ptr 指向数据的指针
      * @param byte_size 数据的字节大小
      */
     void bindDataPtr(void* data_ptr, int byte_size);
 
+    /**
+     * @brief 接管一个引用计数的数据缓冲区
+     * 不拷贝数据，字节大小为缓冲区的大小。图像信息被清除，需要时重新调用 setImageInfo()。
+     * 
+     * @param buf 要接管的缓冲区，调用后由当前对象负责释放
+     */
+    void bindBuffer(AVBufferRef* buf);
+
+    /**
+     * @brief 判断数据缓冲区是否只被当前对象引用
+     * 
+     * @return bool 可以直接修改数据时返回 true
+     */
+    bool isWritable() const;
+
+    /**
+     * @brief 确保数据缓冲区只被当前对象引用，必要时拷贝一份
+     * 
+     * @return bool 成功返回 true，失败返回 false
+     */
+    bool makeWritable();
+
     /**
      * @brief 获取数据指针
      * 
@@ -120,6 +201,7 @@ public:
 
     /**
      * @brief 调整数据的字节大小
+     * 重新分配缓冲区，原有数据和图像信息被清除。
      * 
      * @param byte_size 新的数据字节大小
      */
@@ -139,6 +221,81 @@ public:
      */
     void setTimestamp(int64_t value);
 
+    /**
+     * @brief 判断数据是否为关键帧
+     * 
+     * @return bool 关键帧返回 true
+     */
+    bool isKeyFrame() const;
+
+    /**
+     * @brief 设置数据是否为关键帧
+     * 
+     * @param value 是否为关键帧
+     */
+    void setKeyFrame(bool value);
+
+    /**
+     * @brief 设置打包数据的图像信息
+     * 用于描述存放在 buf 中的图像（如 RGB24），以便通过 getPlane()/getStride() 访问。
+     * 
+     * @param pix_fmt 像素格式（AVPixelFormat）
+     * @param width 图像宽度
+     * @param height 图像高度
+     */
+    void setImageInfo(int pix_fmt, int width, int height);
+
+    /**
+     * @brief 获取引用的原生格式图像帧
+     * 
+     * @return AVFrame* 图像帧，数据不是以 AVFrame 形式保存时返回 nullptr
+     */
+    AVFrame* getAVFrame() const;
+
+    /**
+     * @brief 获取图像的像素格式
+     * 
+     * @return int 像素格式（AVPixelFormat），未知时返回 -1
+     */
+    int getPixelFormat() const;
+
+    /**
+     * @brief 获取图像宽度
+     * 
+     * @return int 图像宽度，未知时返回 0
+     */
+    int getWidth() const;
+
+    /**
+     * @brief 获取图像高度
+     * 
+     * @return int 图像高度，未知时返回 0
+     */
+    int getHeight() const;
+
+    /**
+     * @brief 获取图像的平面个数
+     * 
+     * @return int 平面个数，像素格式未知时返回 1
+     */
+    int getPlaneCount() const;
+
+    /**
+     * @brief 获取指定平面的数据指针
+     * 
+     * @param index 平面索引
+     * @return uint8_t* 平面数据指针，不存在时返回 nullptr
+     */
+    uint8_t* getPlane(int index) const;
+
+    /**
+     * @brief 获取指定平面一行的字节数
+     * 
+     * @param index 平面索引
+     * @return int 一行的字节数，不存在时返回 0
+     */
+    int getStride(int index) const;
+
     /**
      * @brief 获取数据的字节大小
      * 
@@ -0,0 +1,60 @@
+#include "LatencyHistogram.h"
+
+static const int64_t BUCKET_BOUNDS[LatencyHistogram::BUCKET_COUNT] = {
+    50, 100, 250, 500,
+    1000, 2500, 5000, 10000,
+    25000, 50000, 100000, 250000,
+    500000, 1000000, 2500000, 5000000,
+};
+
+int64_t LatencyHistogram::bucketBound(int index)
+{
+    if (index < 0 || index >= BUCKET_COUNT)
+        return -1;
+    return BUCKET_BOUNDS[index];
+}
+
+void LatencyHistogram::observe(int64_t us)
+{
+    if (us < 0)
+        us = 0;
+    int index = 0;
+    while (index < BUCKET_COUNT && us > BUCKET_BOUNDS[index])
+        ++index;
+    buckets[index].fetch_add(1, std::memory_order_relaxed);
+    sum_us.fetch_add(us, std::memory_order_relaxed);
+    int64_t cur = max_us.load(std::memory_order_relaxed);
+    while (us > cur && !max_us.compare_exchange_weak(cur, us, std::memory_order_relaxed))
+        ;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot snap;
+    // 各计数分别读取，count 取桶计数之和，保证导出的直方图中 +Inf 桶与 count 一致
+    for (int i = 0; i <= BUCKET_COUNT; ++i)
+    {
+        snap.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        snap.count += snap.buckets[i];
+    }
+    snap.sum_us = sum_us.load(std::memory_order_relaxed);
+    snap.max_us = max_us.load(std::memory_order_relaxed);
+    return snap;
+}
+
+int64_t LatencyHistogram::Snapshot::percentile(double q) const
+{
+    if (count <= 0)
+        return 0;
+    int64_t rank = (int64_t)(q * count + 0.5);
+    if (rank < 1)
+        rank = 1;
+    int64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+            return BUCKET_BOUNDS[i] < max_us ? BUCKET_BOUNDS[i] : max_us;
+    }
+    return max_us;
+}
@@ -0,0 +1,65 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class LatencyHistogram
+ * @brief 固定桶边界的耗时直方图，记录一个处理环节每次执行的耗时。
+ *
+ * 桶边界从 50us 到 5s 按 1-2.5-5 递增，覆盖从颜色空间转换到网络写入的耗时范围。
+ * observe() 只做几次原子加法，不加锁，可以在解码、编码、写入线程的热路径上调用；
+ * snapshot() 可以在任意线程中调用，用于导出统计。
+ */
+class LatencyHistogram
+{
+public:
+    /**
+     * @brief 有上界的桶个数，另有一个 +Inf 桶
+     */
+    static const int BUCKET_COUNT = 16;
+
+    /**
+     * @brief 直方图某一时刻的副本
+     */
+    struct Snapshot
+    {
+        int64_t buckets[BUCKET_COUNT + 1] = {0}; ///< 每个桶的计数（非累计），最后一个为 +Inf 桶
+        int64_t count = 0;                       ///< 记录次数
+        int64_t sum_us = 0;                      ///< 累计耗时（微秒）
+        int64_t max_us = 0;                      ///< 最大耗时（微秒）
+
+        /**
+         * @brief 估算分位数，返回该分位所在桶的上界
+         *
+         * @param q 分位，取值 0 ~ 1
+         * @return int64_t 耗时（微秒），没有记录时返回 0，落在 +Inf 桶时返回 max_us
+         */
+        int64_t percentile(double q) const;
+    };
+
+    /**
+     * @brief 获取第 index 个桶的上界（微秒）
+     */
+    static int64_t bucketBound(int index);
+
+    /**
+     * @brief 记录一次耗时
+     *
+     * @param us 耗时（微秒）
+     */
+    void observe(int64_t us);
+
+    /**
+     * @brief 获取直方图的副本
+     */
+    Snapshot snapshot() const;
+
+private:
+    std::atomic<int64_t> buckets[BUCKET_COUNT + 1] = {};
+    std::atomic<int64_t> sum_us{0};
+    std::atomic<int64_t> max_us{0};
+};
+
+#endif // LATENCYHISTOGRAM_H
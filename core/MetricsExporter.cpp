@@ -0,0 +1,177 @@
+#include "MetricsExporter.h"
+#include "MetricsRegistry.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if !defined (_WIN32) && !defined (_WIN64)
+#define LINUX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#else
+#define WINDOWS
+#endif
+
+MetricsExporter::MetricsExporter(MetricsRegistry *registry)
+    : registry(registry ? registry : &MetricsRegistry::instance())
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::startFile(const std::string &path, int interval_ms)
+{
+    if (file_thread.joinable())
+    {
+        err_msg = "file export already started";
+        return false;
+    }
+    is_exit = false;
+    file_thread = std::thread(&MetricsExporter::fileLoop, this, path, interval_ms > 0 ? interval_ms : 1000);
+    return true;
+}
+
+bool MetricsExporter::startHttp(int port, const std::string &bind_address)
+{
+    if (http_thread.joinable())
+    {
+        err_msg = "http export already started";
+        return false;
+    }
+#if defined (LINUX)
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        err_msg = "create socket failed";
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) != 1 ||
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, 8) != 0)
+    {
+        err_msg = "listen on " + bind_address + ":" + std::to_string(port) + " failed";
+        ::close(fd);
+        return false;
+    }
+    is_exit = false;
+    listen_fd = fd;
+    http_thread = std::thread(&MetricsExporter::httpLoop, this, fd);
+    return true;
+#else
+    (void)port;
+    (void)bind_address;
+    err_msg = "http export is not supported on this platform";
+    return false;
+#endif
+}
+
+void MetricsExporter::stop()
+{
+    is_exit = true;
+    if (file_thread.joinable())
+        file_thread.join();
+    if (http_thread.joinable())
+        http_thread.join();
+#if defined (LINUX)
+    if (listen_fd >= 0)
+        ::close(listen_fd);
+#endif
+    listen_fd = -1;
+}
+
+const std::string &MetricsExporter::getLastError() const
+{
+    return err_msg;
+}
+
+bool MetricsExporter::writeFile(const std::string &path)
+{
+    // 先写临时文件再改名，读取方不会读到写了一半的内容
+    const std::string tmp_path = path + ".tmp";
+    FILE *fp = fopen(tmp_path.c_str(), "w");
+    if (fp == NULL)
+        return false;
+    std::string text = registry->collect();
+    bool ok = fwrite(text.data(), 1, text.size(), fp) == text.size();
+    ok = 0 == fclose(fp) && ok;
+    return ok && 0 == rename(tmp_path.c_str(), path.c_str());
+}
+
+void MetricsExporter::fileLoop(std::string path, int interval_ms)
+{
+    auto next = std::chrono::steady_clock::now();
+    while (!is_exit)
+    {
+        writeFile(path);
+        next += std::chrono::milliseconds(interval_ms);
+        // 分段休眠以便及时响应 stop()
+        while (!is_exit && std::chrono::steady_clock::now() < next)
+        {
+            auto remain = next - std::chrono::steady_clock::now();
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(remain, std::chrono::milliseconds(100)));
+        }
+    }
+}
+
+void MetricsExporter::httpLoop(int fd)
+{
+#if defined (LINUX)
+    while (!is_exit)
+    {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+        int client = accept(fd, NULL, NULL);
+        if (client < 0)
+            continue;
+        // 只需要读掉请求头，不解析路径，任何请求都返回全部指标
+        struct timeval tv;
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        char buf[1024];
+        std::string request;
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+        {
+            ssize_t n = recv(client, buf, sizeof(buf), 0);
+            if (n <= 0)
+                break;
+            request.append(buf, (size_t)n);
+        }
+        std::string body = registry->collect();
+        std::string response = "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: text/plain; version=0.0.4\r\n"
+                               "Connection: close\r\n"
+                               "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < response.size())
+        {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                break;
+            sent += (size_t)n;
+        }
+        ::close(client);
+    }
+#else
+    (void)fd;
+#endif
+}
@@ -0,0 +1,79 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+class MetricsRegistry;
+
+/**
+ * @class MetricsExporter
+ * @brief 在后台线程中导出 MetricsRegistry 的内容，可以同时开启文件和 HTTP 两种方式。
+ *
+ * - 文件：按固定周期把 Prometheus 文本写入临时文件后原子地改名为目标文件，
+ *   可以配合 node_exporter 的 textfile collector 使用；
+ * - HTTP：监听本地端口，对任意 GET 请求返回 Prometheus 文本，可以直接被 Prometheus 抓取。
+ *
+ * 导出只在后台线程中进行，不影响解码、编码和写入线程。
+ */
+class MetricsExporter
+{
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param registry 要导出的注册表，默认为进程内共享的注册表
+     */
+    explicit MetricsExporter(MetricsRegistry *registry = nullptr);
+
+    /**
+     * @brief 析构函数，停止所有导出线程
+     */
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+    /**
+     * @brief 开始周期性地写入文件
+     *
+     * @param path 目标文件路径
+     * @param interval_ms 写入周期（毫秒）
+     * @return bool 已经开启时返回 false
+     */
+    bool startFile(const std::string &path, int interval_ms = 5000);
+
+    /**
+     * @brief 开始在本地端口上提供 HTTP 抓取接口（仅 Linux）
+     *
+     * @param port 监听端口
+     * @param bind_address 监听地址，默认只监听本机
+     * @return bool 端口监听失败或已经开启时返回 false
+     */
+    bool startHttp(int port, const std::string &bind_address = "127.0.0.1");
+
+    /**
+     * @brief 停止所有导出线程
+     */
+    void stop();
+
+    /**
+     * @brief 获取最后一次发生的错误信息
+     */
+    const std::string &getLastError() const;
+
+private:
+    void fileLoop(std::string path, int interval_ms);
+    void httpLoop(int fd);
+    bool writeFile(const std::string &path);
+
+    MetricsRegistry *registry;
+    std::atomic<bool> is_exit{false};
+    std::thread file_thread;
+    std::thread http_thread;
+    int listen_fd = -1;
+    std::string err_msg;
+};
+
+#endif // METRICSEXPORTER_H
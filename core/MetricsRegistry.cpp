@@ -0,0 +1,163 @@
+#include "MetricsRegistry.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// 整数按整数输出，其余按浮点数输出
+static std::string format_value(double value)
+{
+    char buf[64];
+    if (std::floor(value) == value && std::fabs(value) < 1e15)
+        snprintf(buf, sizeof(buf), "%lld", (long long)value);
+    else
+        snprintf(buf, sizeof(buf), "%.9g", value);
+    return buf;
+}
+
+// 标签值中的反斜杠、双引号和换行需要转义
+static std::string format_labels(const MetricsWriter::Labels &labels, const char *extra_name = NULL,
+                                 const std::string &extra_value = std::string())
+{
+    if (labels.empty() && !extra_name)
+        return std::string();
+    std::string out = "{";
+    bool first = true;
+    auto append = [&](const std::string &name, const std::string &value) {
+        if (!first)
+            out += ",";
+        first = false;
+        out += name;
+        out += "=\"";
+        for (char c : value)
+        {
+            if ('\\' == c || '"' == c)
+                out += '\\';
+            if ('\n' == c)
+            {
+                out += "\\n";
+                continue;
+            }
+            out += c;
+        }
+        out += "\"";
+    };
+    for (auto &label : labels)
+        append(label.first, label.second);
+    if (extra_name)
+        append(extra_name, extra_value);
+    out += "}";
+    return out;
+}
+
+MetricsWriter::Family *MetricsWriter::family(const std::string &name, const char *type, const std::string &help,
+                                             const Labels &labels)
+{
+    auto it = families.find(name);
+    if ((it != families.end() && it->second.type != type) || !series.insert(name + format_labels(labels)).second)
+    {
+        duplicates.push_back(name);
+        return nullptr;
+    }
+    if (it == families.end())
+    {
+        order.push_back(name);
+        Family &f = families[name];
+        f.type = type;
+        f.help = help;
+        return &f;
+    }
+    return &it->second;
+}
+
+void MetricsWriter::counter(const std::string &name, const std::string &help, const Labels &labels, double value)
+{
+    if (Family *f = family(name, "counter", help, labels))
+        f->samples += name + format_labels(labels) + " " + format_value(value) + "\n";
+}
+
+void MetricsWriter::gauge(const std::string &name, const std::string &help, const Labels &labels, double value)
+{
+    if (Family *f = family(name, "gauge", help, labels))
+        f->samples += name + format_labels(labels) + " " + format_value(value) + "\n";
+}
+
+void MetricsWriter::histogram(const std::string &name, const std::string &help, const Labels &labels,
+                              const LatencyHistogram::Snapshot &snapshot)
+{
+    Family *f = family(name, "histogram", help, labels);
+    if (!f)
+        return;
+    std::string &samples = f->samples;
+    // Prometheus 的桶计数是累计的
+    int64_t cumulative = 0;
+    for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i)
+    {
+        cumulative += snapshot.buckets[i];
+        samples += name + "_bucket" + format_labels(labels, "le", format_value(LatencyHistogram::bucketBound(i) / 1e6)) +
+                   " " + format_value((double)cumulative) + "\n";
+    }
+    samples += name + "_bucket" + format_labels(labels, "le", "+Inf") + " " + format_value((double)snapshot.count) + "\n";
+    samples += name + "_sum" + format_labels(labels) + " " + format_value(snapshot.sum_us / 1e6) + "\n";
+    samples += name + "_count" + format_labels(labels) + " " + format_value((double)snapshot.count) + "\n";
+}
+
+std::string MetricsWriter::str() const
+{
+    std::string out;
+    for (const std::string &name : order)
+    {
+        const Family &f = families.at(name);
+        out += "# HELP " + name + " " + f.help + "\n";
+        out += "# TYPE " + name + " " + f.type + "\n";
+        out += f.samples;
+    }
+    return out;
+}
+
+const std::vector<std::string> &MetricsWriter::getDuplicates() const
+{
+    return duplicates;
+}
+
+MetricsRegistry &MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+int MetricsRegistry::addCollector(Collector collector)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    int id = next_id++;
+    collectors[id] = std::move(collector);
+    return id;
+}
+
+void MetricsRegistry::removeCollector(int id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    collectors.erase(id);
+}
+
+std::string MetricsRegistry::collect() const
+{
+    MetricsWriter writer;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &item : collectors)
+        item.second(writer);
+    return writer.str();
+}
+
+double RateMeter::update(int64_t total)
+{
+    int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::lock_guard<std::mutex> lock(mutex);
+    double rate = 0;
+    if (last_time >= 0 && now > last_time)
+        rate = (total - last_total) * 1e6 / (now - last_time);
+    last_total = total;
+    last_time = now;
+    return rate;
+}
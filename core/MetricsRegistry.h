@@ -0,0 +1,141 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+/**
+ * @class MetricsWriter
+ * @brief 把计数器、仪表和直方图格式化为 Prometheus 文本格式。
+ *
+ * 同名指标的所有样本（不同标签）按 Prometheus 的要求输出在同一组 HELP/TYPE 之后，
+ * 因此不同采集函数可以各自写同一个指标名。名称和标签都相同的样本，或者同名但类型不同的样本
+ * 会使 Prometheus 拒绝整次抓取，这类样本被丢弃，指标名记录在 getDuplicates() 中。
+ */
+class MetricsWriter
+{
+public:
+    /**
+     * @brief 标签列表，按给定顺序输出
+     */
+    typedef std::vector<std::pair<std::string, std::string>> Labels;
+
+    /**
+     * @brief 写入一个单调递增的计数器样本，name 应以 _total 结尾
+     */
+    void counter(const std::string &name, const std::string &help, const Labels &labels, double value);
+
+    /**
+     * @brief 写入一个仪表样本（队列深度、帧率等可增可减的值）
+     */
+    void gauge(const std::string &name, const std::string &help, const Labels &labels, double value);
+
+    /**
+     * @brief 写入一个耗时直方图，单位转换为秒，name 应以 _seconds 结尾
+     */
+    void histogram(const std::string &name, const std::string &help, const Labels &labels,
+                   const LatencyHistogram::Snapshot &snapshot);
+
+    /**
+     * @brief 获取 Prometheus 文本格式的全部内容
+     */
+    std::string str() const;
+
+    /**
+     * @brief 获取被丢弃的重复样本的指标名，按写入顺序，每次重复记录一次
+     */
+    const std::vector<std::string> &getDuplicates() const;
+
+private:
+    struct Family
+    {
+        std::string type;
+        std::string help;
+        std::string samples;
+    };
+
+    /**
+     * @brief 获取指标族，样本与已写入的样本重复时返回 nullptr
+     */
+    Family *family(const std::string &name, const char *type, const std::string &help, const Labels &labels);
+
+    std::vector<std::string> order; // 指标名按第一次写入的顺序输出
+    std::map<std::string, Family> families;
+    std::set<std::string> series;   // 已写入的样本：指标名加标签
+    std::vector<std::string> duplicates;
+};
+
+/**
+ * @class MetricsRegistry
+ * @brief 进程内的指标注册表，导出时依次调用各组件注册的采集函数。
+ *
+ * 组件自己维护统计（队列统计、耗时直方图等），热路径上不访问注册表；
+ * 只有导出时才在锁内调用采集函数读取这些统计。removeCollector() 返回后采集函数不会再被调用，
+ * 组件可以随后安全地析构。
+ */
+class MetricsRegistry
+{
+public:
+    /**
+     * @brief 采集函数，把组件当前的统计写入 MetricsWriter
+     */
+    typedef std::function<void(MetricsWriter &)> Collector;
+
+    /**
+     * @brief 获取进程内共享的注册表
+     */
+    static MetricsRegistry &instance();
+
+    /**
+     * @brief 注册采集函数
+     *
+     * @return int 采集函数的标识，传给 removeCollector()
+     */
+    int addCollector(Collector collector);
+
+    /**
+     * @brief 注销采集函数，正在执行的导出完成后才返回
+     */
+    void removeCollector(int id);
+
+    /**
+     * @brief 调用所有采集函数并返回 Prometheus 文本格式的结果
+     */
+    std::string collect() const;
+
+private:
+    mutable std::mutex mutex;
+    std::map<int, Collector> collectors;
+    int next_id = 1;
+};
+
+/**
+ * @class RateMeter
+ * @brief 根据累计计数计算两次采集之间的速率，例如由累计编码帧数得到帧率。
+ */
+class RateMeter
+{
+public:
+    /**
+     * @brief 输入当前的累计计数，返回与上一次调用之间的每秒速率
+     *
+     * @param total 累计计数
+     * @return double 每秒速率，第一次调用返回 0
+     */
+    double update(int64_t total);
+
+private:
+    std::mutex mutex;
+    int64_t last_total = 0;
+    int64_t last_time = -1;
+};
+
+#endif // METRICSREGISTRY_H
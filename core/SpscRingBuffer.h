@@ -0,0 +1,194 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @class SpscRingBuffer
+ * @brief 有界的单生产者单消费者无锁环形队列。
+ *
+ * 只允许一个线程调用 tryPush（生产者），一个线程调用 front/tryPop/discard（消费者），
+ * 两端各自只写自己的索引，通过 acquire/release 原子操作同步，无需互斥锁。
+ * 读写索引分别放在独立的缓存行中，避免生产者和消费者之间的伪共享。
+ * 容量向上取整为 2 的幂，索引单调递增，元素个数为 tail - head。
+ *
+ * @tparam T 元素类型，需要支持默认构造和移动赋值
+ */
+template <typename T>
+class SpscRingBuffer
+{
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param capacity 队列容量，会向上取整为 2 的幂
+     */
+    explicit SpscRingBuffer(size_t capacity = 0)
+    {
+        reset(capacity);
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    /**
+     * @brief 重新设置容量并清空队列
+     *
+     * 该方法不是线程安全的，只能在生产者和消费者都不访问队列时调用。
+     *
+     * @param capacity 队列容量，会向上取整为 2 的幂
+     */
+    void reset(size_t capacity)
+    {
+        size_t real_capacity = 1;
+        while (real_capacity < capacity)
+            real_capacity <<= 1;
+        slots.clear();
+        slots.resize(capacity > 0 ? real_capacity : 0);
+        mask = real_capacity - 1;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        cached_head = 0;
+        cached_tail = 0;
+    }
+
+    /**
+     * @brief 生产者插入一个元素
+     *
+     * @param v 要插入的元素，成功时被移动
+     * @return bool 插入成功返回 true，队列已满返回 false
+     */
+    bool tryPush(T &&v)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head >= slots.size())
+        {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head >= slots.size())
+                return false;
+        }
+        slots[t & mask] = std::move(v);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 生产者插入一个元素的拷贝
+     *
+     * @param v 要插入的元素
+     * @return bool 插入成功返回 true，队列已满返回 false
+     */
+    bool tryPush(const T &v)
+    {
+        T tmp(v);
+        return tryPush(std::move(tmp));
+    }
+
+    /**
+     * @brief 消费者查看队首元素
+     *
+     * 返回的指针在消费者下一次调用 tryPop/discard 之前有效。
+     *
+     * @return T* 队首元素指针，队列为空时返回 nullptr
+     */
+    T *front()
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == cached_tail)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h == cached_tail)
+                return nullptr;
+        }
+        return &slots[h & mask];
+    }
+
+    /**
+     * @brief 消费者取出队首元素
+     *
+     * @param out 输出参数，接收队首元素
+     * @return bool 成功返回 true，队列为空返回 false
+     */
+    bool tryPop(T &out)
+    {
+        T *p = front();
+        if (!p)
+            return false;
+        out = std::move(*p);
+        *p = T();
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 消费者丢弃队首元素
+     *
+     * @return bool 成功返回 true，队列为空返回 false
+     */
+    bool discard()
+    {
+        T *p = front();
+        if (!p)
+            return false;
+        // 及时释放元素持有的资源（如帧缓冲区）
+        *p = T();
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 获取队列中的元素个数（近似值，两端并发修改时可能已经过期）
+     *
+     * @return size_t 元素个数
+     */
+    size_t size() const
+    {
+        const size_t h = head.load(std::memory_order_acquire);
+        const size_t t = tail.load(std::memory_order_acquire);
+        return t - h;
+    }
+
+    /**
+     * @brief 判断队列是否为空
+     *
+     * @return bool 为空返回 true
+     */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @brief 获取队列容量
+     *
+     * @return size_t 队列容量（2 的幂）
+     */
+    size_t capacity() const
+    {
+        return slots.size();
+    }
+
+private:
+    static const size_t CACHE_LINE = 64;
+
+    // 消费者写、生产者读的索引，独占一个缓存行
+    std::atomic<size_t> head{0};
+    char pad0[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    // 生产者写、消费者读的索引，独占一个缓存行
+    std::atomic<size_t> tail{0};
+    char pad1[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    // 生产者缓存的 head，减少对消费者缓存行的访问
+    size_t cached_head = 0;
+    char pad2[CACHE_LINE - sizeof(size_t)];
+    // 消费者缓存的 tail，减少对生产者缓存行的访问
+    size_t cached_tail = 0;
+    char pad3[CACHE_LINE - sizeof(size_t)];
+
+    std::vector<T> slots;
+    size_t mask = 0;
+};
+
+#endif // SPSCRINGBUFFER_H
@@ -0,0 +1,196 @@
+#include "TaskScheduler.h"
+#include "Utils.h"
+
+#include <algorithm>
+
+// 当前线程在所属调度器中的队列序号，外部线程为 -1
+static thread_local const TaskScheduler *current_scheduler = nullptr;
+static thread_local int current_index = -1;
+
+TaskScheduler &TaskScheduler::instance()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler(int thread_count)
+{
+    if (thread_count <= 0)
+        thread_count = Utils::core_count();
+    if (thread_count <= 0)
+        thread_count = 1;
+    // 为工作线程保留 1/8 的 CPU，其余作为编解码线程配额
+    codec_budget = thread_count > 1 ? thread_count - std::max(1, thread_count / 8) : 1;
+    for (int i = 0; i < thread_count; ++i)
+        queues.emplace_back(new WorkQueue());
+    for (int i = 0; i < thread_count; ++i)
+        workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        is_exit = true;
+    }
+    wake_cv.notify_all();
+    for (auto &t : workers)
+    {
+        if (t.joinable())
+            t.join();
+    }
+}
+
+int TaskScheduler::getThreadCount() const
+{
+    return (int)workers.size();
+}
+
+void TaskScheduler::submit(std::function<void()> task)
+{
+    if (task)
+        enqueue(std::move(task));
+}
+
+void TaskScheduler::enqueue(Task task)
+{
+    int index = current_scheduler == this ? current_index : -1;
+    if (index < 0)
+        index = (int)(next_queue++ % queues.size());
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    ++pending;
+    // 只有存在空闲的工作线程时才需要唤醒
+    std::lock_guard<std::mutex> lock(sleep_mutex);
+    if (sleeping > 0)
+        wake_cv.notify_one();
+}
+
+bool TaskScheduler::runOne(int self)
+{
+    if (pending <= 0)
+        return false;
+    Task task;
+    if (self >= 0)
+    {
+        // 自己的队列后进先出，刚提交的任务数据还在缓存中
+        std::lock_guard<std::mutex> lock(queues[self]->mutex);
+        if (!queues[self]->tasks.empty())
+        {
+            task = std::move(queues[self]->tasks.back());
+            queues[self]->tasks.pop_back();
+        }
+    }
+    if (!task)
+    {
+        // 从其他队列的队首窃取最早提交的任务
+        const int count = (int)queues.size();
+        const int start = self >= 0 ? self + 1 : 0;
+        for (int i = 0; i < count && !task; ++i)
+        {
+            WorkQueue &queue = *queues[(start + i) % count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+    }
+    if (!task)
+        return false;
+    --pending;
+    task();
+    return true;
+}
+
+void TaskScheduler::workerLoop(int index)
+{
+    current_scheduler = this;
+    current_index = index;
+    while (true)
+    {
+        if (runOne(index))
+            continue;
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        if (is_exit && pending <= 0)
+            break;
+        ++sleeping;
+        wake_cv.wait(lock, [this]() { return is_exit || pending > 0; });
+        --sleeping;
+    }
+}
+
+void TaskScheduler::parallelFor(int count, const std::function<void(int)> &fn)
+{
+    if (count <= 0)
+        return;
+    if (1 == count)
+    {
+        fn(0);
+        return;
+    }
+
+    // 等待状态放在栈上。计数在 group.mutex 内递减，调用线程返回前也要获取一次该锁，
+    // 保证最后一个任务已经离开 finish()，不再访问即将销毁的 group
+    struct Group
+    {
+        std::atomic<int> remaining;
+        std::mutex mutex;
+        std::condition_variable done_cv;
+    } group;
+    group.remaining = count;
+    auto finish = [&group]() {
+        std::lock_guard<std::mutex> lock(group.mutex);
+        if (0 == --group.remaining)
+            group.done_cv.notify_all();
+    };
+
+    for (int i = 1; i < count; ++i)
+    {
+        enqueue([&fn, &finish, i]() {
+            fn(i);
+            finish();
+        });
+    }
+    fn(0);
+    finish();
+
+    // 等待期间帮助执行任务，工作线程中嵌套调用时也不会死锁
+    const int self = current_scheduler == this ? current_index : -1;
+    while (group.remaining > 0)
+    {
+        if (runOne(self))
+            continue;
+        std::unique_lock<std::mutex> lock(group.mutex);
+        group.done_cv.wait_for(lock, std::chrono::milliseconds(1), [&group]() { return group.remaining <= 0; });
+    }
+    std::lock_guard<std::mutex> lock(group.mutex);
+}
+
+int TaskScheduler::getCodecThreadBudget() const
+{
+    return codec_budget;
+}
+
+int TaskScheduler::acquireCodecThreads(int requested)
+{
+    std::lock_guard<std::mutex> lock(codec_mutex);
+    const int remaining = codec_budget - codec_threads_used;
+    if (requested <= 0 || requested > remaining)
+        requested = remaining;
+    // 配额用完后仍分配 1 个线程（超额订阅），编解码器不能没有线程
+    int granted = std::max(1, requested);
+    codec_threads_used += granted;
+    return granted;
+}
+
+void TaskScheduler::releaseCodecThreads(int granted)
+{
+    if (granted <= 0)
+        return;
+    std::lock_guard<std::mutex> lock(codec_mutex);
+    codec_threads_used -= granted;
+}
@@ -0,0 +1,140 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class TaskScheduler
+ * @brief 进程内共享的工作窃取线程池，所有会话的缩放、编解码分片任务都提交到这里。
+ *
+ * 线程数在创建时按机器的 CPU 核数确定一次，并发会话增加时只增加任务，不增加线程，
+ * 避免成百上千个线程争抢 CPU。每个工作线程有自己的任务队列：本线程提交的任务后进先出，
+ * 空闲时从其他线程的队首窃取任务。外部线程提交的任务轮流放入各工作线程的队列。
+ *
+ * parallelFor 的调用线程在等待期间也会执行队列中的任务，因此可以在任务中嵌套调用而不会死锁。
+ */
+class TaskScheduler
+{
+public:
+    /**
+     * @brief 获取进程内共享的调度器，线程数为 Utils::core_count()
+     *
+     * @return TaskScheduler& 共享的调度器
+     */
+    static TaskScheduler &instance();
+
+    /**
+     * @brief 构造函数
+     *
+     * @param thread_count 工作线程数，小于等于 0 时使用 Utils::core_count()
+     */
+    explicit TaskScheduler(int thread_count = 0);
+
+    /**
+     * @brief 析构函数，执行完已提交的任务后通知工作线程退出
+     */
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+    /**
+     * @brief 获取工作线程数
+     */
+    int getThreadCount() const;
+
+    /**
+     * @brief 提交一个异步任务
+     *
+     * @param task 任务函数
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief 并行执行 fn(0) ... fn(count - 1)，全部完成后返回
+     *
+     * 调用线程执行其中一部分，并在等待期间帮助执行其他任务。
+     *
+     * @param count 任务个数
+     * @param fn 任务函数，参数为任务序号
+     */
+    void parallelFor(int count, const std::function<void(int)> &fn);
+
+    /**
+     * @brief 获取所有编解码器共享的线程配额总数
+     *
+     * 工作线程也在执行缩放和单线程编解码器的分片任务，配额总数从 CPU 核数中扣除为工作线程保留的部分（1/8，至少 1 个）。
+     */
+    int getCodecThreadBudget() const;
+
+    /**
+     * @brief 为一个编解码器申请线程配额
+     *
+     * libavcodec 的帧级多线程使用自己创建的线程，无法交给调度器执行，只能限制其数量。
+     * 每个编解码器最多分到剩余的配额，已分配的配额总数不超过 getCodecThreadBudget()。
+     * 配额用完后每个编解码器仍分到 1 个线程，此时属于超额订阅，超出的线程数不超过编解码器个数。
+     * 同时打开多个编解码器时调用者应当指定线程数（如按配额平分），否则先打开的编解码器会占用全部剩余配额。
+     *
+     * @param requested 期望的线程数，小于等于 0 表示使用全部剩余配额
+     * @return int 分配的线程数，至少为 1，使用完后需要调用 releaseCodecThreads 归还
+     */
+    int acquireCodecThreads(int requested);
+
+    /**
+     * @brief 归还 acquireCodecThreads 分配的线程配额
+     *
+     * @param granted acquireCodecThreads 的返回值
+     */
+    void releaseCodecThreads(int granted);
+
+private:
+    typedef std::function<void()> Task;
+
+    /**
+     * @brief 一个工作线程的任务队列
+     */
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /**
+     * @brief 工作线程的主循环
+     */
+    void workerLoop(int index);
+
+    /**
+     * @brief 取出并执行一个任务：先取 self 队列的队尾，再从其他队列的队首窃取
+     *
+     * @param self 当前线程的队列序号，外部线程为 -1
+     * @return bool 执行了一个任务返回 true，所有队列都为空返回 false
+     */
+    bool runOne(int self);
+
+    /**
+     * @brief 把任务放入队列并唤醒一个空闲的工作线程
+     */
+    void enqueue(Task task);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<int> pending{0};          // 所有队列中尚未取出的任务数
+    std::atomic<unsigned> next_queue{0};  // 外部线程提交任务时轮流选择队列
+    std::mutex sleep_mutex;
+    std::condition_variable wake_cv;
+    int sleeping = 0;                     // 等待任务的工作线程数
+    bool is_exit = false;
+    int codec_budget = 1;                 // 编解码线程配额总数
+    std::mutex codec_mutex;
+    int codec_threads_used = 0;           // 已分配的编解码线程配额，由 codec_mutex 保护
+};
+
+#endif // TASKSCHEDULER_H
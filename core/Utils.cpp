@@ -1,12 +1,11 @@
 #include "Utils.h"
+#include "CpuTopology.h"
 #if !defined (_WIN32) && !defined (_WIN64)
 #define LINUX
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
+#include <sys/resource.h>
+#include <time.h>
 #else
 #define WINDOWS
-#include <windows.h>
 #endif
 
 namespace Utils
@@ -17,36 +16,51 @@ int64_t get_curtime()
     return av_gettime();
 }
 
+int core_count()
+{
+    // 按亲和性掩码和 cgroup 配额计算，容器内不会创建超过配额的线程
+    return CpuTopology::get().usable_cpus;
+}
 
+#if defined (LINUX)
+static int64_t clock_us(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0)
+        return 0;
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
 
-
-int core_count()
+int64_t thread_cpu_time_us()
 {
-    int core_count = 0; // 至少一个
 #if defined (LINUX)
-    FILE *fp = fopen("/proc/cpuinfo", "r");
-    if (fp == NULL) {
-        return 1;
-    }
-
-    char line[256];
-    
-    while (fgets(line, sizeof(line), fp)) {
-        // 每个逻辑处理器会有一行 "processor"
-        if (strncmp(line, "processor", 9) == 0) {
-            core_count++;
-        }
-    }
-
-    fclose(fp);
-#elif defined (WINDOWS)
-    SYSTEM_INFO si;
-    GetSystemInfo(&si);
-    core_count = (int)si.dwNumberOfProcessors;
+    return clock_us(CLOCK_THREAD_CPUTIME_ID);
+#else
+    return 0;
 #endif
-    return core_count;
 }
 
+int64_t process_cpu_time_us()
+{
+#if defined (LINUX)
+    return clock_us(CLOCK_PROCESS_CPUTIME_ID);
+#else
+    return 0;
+#endif
+}
 
+int64_t peak_rss_kb()
+{
+#if defined (LINUX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    // Linux 上 ru_maxrss 的单位是 KB
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
 
 }
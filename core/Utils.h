@@ -11,6 +11,21 @@ namespace Utils
 
 int64_t get_curtime();
 int core_count();
+
+/**
+ * @brief 获取调用线程已使用的 CPU 时间（用户态加内核态，微秒），不支持的平台返回 0
+ */
+int64_t thread_cpu_time_us();
+
+/**
+ * @brief 获取整个进程已使用的 CPU 时间（所有线程的用户态加内核态，微秒），不支持的平台返回 0
+ */
+int64_t process_cpu_time_us();
+
+/**
+ * @brief 获取进程常驻内存的峰值（KB），不支持的平台返回 0
+ */
+int64_t peak_rss_kb();
 }
 
 #endif // UTILS_HPP
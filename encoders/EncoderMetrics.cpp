@@ -0,0 +1,41 @@
+#include "EncoderMetrics.h"
+
+namespace EncoderMetrics
+{
+
+static const char *STAGE_LATENCY = "video_stage_latency_seconds";
+static const char *STAGE_LATENCY_HELP = "Time spent in each processing step per frame or packet.";
+
+static MetricsWriter::Labels with_stage(const MetricsWriter::Labels &labels, const char *stage)
+{
+    MetricsWriter::Labels out = labels;
+    out.emplace_back("stage", stage);
+    return out;
+}
+
+void collectEncoder(MetricsWriter &writer, const MetricsWriter::Labels &labels, const XMediaEncode &encoder)
+{
+    XMediaEncode::LatencyStats stats = encoder.getLatencyStats();
+    writer.histogram(STAGE_LATENCY, STAGE_LATENCY_HELP, with_stage(labels, "rgb2yuv"), stats.convert);
+    writer.histogram(STAGE_LATENCY, STAGE_LATENCY_HELP, with_stage(labels, "encode"), stats.encode);
+    writer.histogram("video_encode_delay_seconds", "Time from sending a frame to the encoder to receiving its packet.",
+                     labels, stats.delay);
+}
+
+void collectWriter(MetricsWriter &writer, const MetricsWriter::Labels &labels, const XRtmp::WriterStats &stats)
+{
+    writer.histogram(STAGE_LATENCY, STAGE_LATENCY_HELP, with_stage(labels, "mux_write"), stats.write_latency);
+    writer.counter("video_output_written_packets_total", "Packets written to the output.", labels,
+                   (double)stats.written_packets);
+    writer.counter("video_output_dropped_packets_total", "Packets dropped because the write queue was over budget.",
+                   labels, (double)stats.dropped_packets);
+    writer.counter("video_output_dropped_gops_total", "GOPs dropped because the write queue was over budget.",
+                   labels, (double)stats.dropped_gops);
+    writer.counter("video_output_write_errors_total", "Failed packet writes.", labels, (double)stats.write_errors);
+    writer.counter("video_output_producer_stall_seconds_total", "Time producers waited for write queue space.",
+                   labels, stats.producer_stall_us / 1e6);
+    writer.gauge("video_output_queue_packets", "Packets waiting in the write queue.", labels, stats.queue_packets);
+    writer.gauge("video_output_queue_bytes", "Bytes waiting in the write queue.", labels, (double)stats.queue_bytes);
+}
+
+} // namespace EncoderMetrics
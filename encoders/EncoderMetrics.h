@@ -0,0 +1,34 @@
+#ifndef ENCODERMETRICS_H
+#define ENCODERMETRICS_H
+
+#include "MetricsRegistry.h"
+#include "XMediaEncode.h"
+#include "XRtmp.h"
+
+/**
+ * @brief 把编码器和封装器的统计写入指标，供会话和示例程序的采集函数共用
+ */
+namespace EncoderMetrics
+{
+
+/**
+ * @brief 写入编码器的转换耗时、编码耗时和编码延迟
+ *
+ * @param writer 指标输出
+ * @param labels 附加在每个样本上的标签
+ * @param encoder 编码器
+ */
+void collectEncoder(MetricsWriter &writer, const MetricsWriter::Labels &labels, const XMediaEncode &encoder);
+
+/**
+ * @brief 写入一路输出写入线程的写入耗时、队列深度和丢包计数
+ *
+ * @param writer 指标输出
+ * @param labels 附加在每个样本上的标签
+ * @param stats 写入线程的统计
+ */
+void collectWriter(MetricsWriter &writer, const MetricsWriter::Labels &labels, const XRtmp::WriterStats &stats);
+
+} // namespace EncoderMetrics
+
+#endif // ENCODERMETRICS_H
@@ -0,0 +1,219 @@
+#include "XFanout.h"
+
+#include <memory>
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+class CXFanout : public XFanout
+{
+public:
+    ~CXFanout()
+    {
+        close();
+    }
+
+    int addOutput(const char* url, int64_t max_queue_bytes, XRtmp::OverflowPolicy policy)
+    {
+        if(!url)
+        {
+            this->setLastError("output url is empty");
+            return -1;
+        }
+        if(!stream_types.empty() && !is_closed)
+        {
+            this->setLastError("addOutput must be called before addStream");
+            return -1;
+        }
+        if(is_closed)
+        {
+            outputs.clear();
+            stream_types.clear();
+            is_closed = false;
+        }
+        Output output;
+        output.url = url;
+        output.max_queue_bytes = max_queue_bytes;
+        output.policy = policy;
+        output.muxer.reset(XRtmp::create());
+        if(!output.muxer->init(url))
+        {
+            this->setLastError(output.url + ": " + output.muxer->getLastError());
+            return -1;
+        }
+        outputs.push_back(std::move(output));
+        return (int)outputs.size() - 1;
+    }
+
+    int addStream(const AVCodecContext* c)
+    {
+        if(!c || outputs.empty())
+        {
+            this->setLastError("no output or codec context");
+            return -1;
+        }
+        for(auto& output : outputs)
+        {
+            if(!output.active)
+                continue;
+            int index = output.muxer->addStream(c);
+            if(index < 0)
+                deactivate(output, output.muxer->getLastError());
+            // 各输出的流索引可能不同，按分发器的流索引记录映射
+            output.stream_map.push_back(index);
+        }
+        stream_types.push_back(c->codec_type);
+        return (int)stream_types.size() - 1;
+    }
+
+    bool sendHead()
+    {
+        int active_count = 0;
+        for(auto& output : outputs)
+        {
+            if(!output.active)
+                continue;
+            if(!output.muxer->sendHead())
+            {
+                deactivate(output, output.muxer->getLastError());
+                continue;
+            }
+            // 每路输出使用独立的写入线程，一路变慢不会阻塞其他输出
+            if(!output.muxer->startAsync(output.max_queue_bytes, output.policy))
+            {
+                deactivate(output, output.muxer->getLastError());
+                continue;
+            }
+            ++active_count;
+        }
+        if(0 == active_count)
+        {
+            this->setLastError("no output could be opened");
+            return false;
+        }
+        return true;
+    }
+
+    bool sendFrame(AVPacket* pkt, int index)
+    {
+        if(!pkt || index < 0 || index >= (int)stream_types.size())
+        {
+            if(pkt)
+                av_packet_unref(pkt);
+            return false;
+        }
+        if(!shared_pkt)
+            shared_pkt = av_packet_alloc();
+        bool accepted = false;
+        for(auto& output : outputs)
+        {
+            if(!output.active || output.stream_map[index] < 0)
+                continue;
+            // 只增加数据缓冲区的引用计数，时间戳等字段各输出独立转换
+            if(av_packet_ref(shared_pkt, pkt) < 0)
+                break;
+            bool sent = output.muxer->sendFrame(shared_pkt, output.stream_map[index]);
+            av_packet_unref(shared_pkt);
+            if(sent)
+            {
+                accepted = true;
+                continue;
+            }
+            // DropGop 策略丢弃数据包时也返回 false，只有写入线程出错时才停用该输出
+            if(output.muxer->getWriterStats().write_errors > 0)
+                deactivate(output, output.muxer->getLastError().empty() ? "write packet failed" : output.muxer->getLastError());
+        }
+        av_packet_unref(pkt);
+        return accepted;
+    }
+
+    int getOutputCount() const
+    {
+        return (int)outputs.size();
+    }
+
+    const std::string& getOutputUrl(int output) const
+    {
+        static const std::string empty;
+        if(output < 0 || output >= (int)outputs.size())
+            return empty;
+        return outputs[output].url;
+    }
+
+    bool isOutputActive(int output) const
+    {
+        if(output < 0 || output >= (int)outputs.size())
+            return false;
+        return outputs[output].active;
+    }
+
+    XRtmp::WriterStats getOutputStats(int output) const
+    {
+        if(output < 0 || output >= (int)outputs.size())
+            return XRtmp::WriterStats();
+        return outputs[output].muxer->getWriterStats();
+    }
+
+    std::string getOutputError(int output) const
+    {
+        if(output < 0 || output >= (int)outputs.size())
+            return std::string();
+        return outputs[output].error;
+    }
+
+    void close()
+    {
+        if(is_closed)
+            return;
+        // 保留输出列表，关闭后仍可以读取各输出的统计信息
+        for(auto& output : outputs)
+            output.muxer->close();
+        av_packet_free(&shared_pkt);
+        is_closed = true;
+    }
+
+    void setLastError(const std::string& buf)
+    {
+        err_msg = buf;
+    }
+    const std::string& getLastError()
+    {
+        return err_msg;
+    }
+
+private:
+    /**
+     * @brief 一路输出
+     */
+    struct Output
+    {
+        std::string url;
+        std::unique_ptr<XRtmp> muxer;
+        std::vector<int> stream_map;          // 分发器流索引 -> 该输出的流索引
+        int64_t max_queue_bytes = 0;
+        XRtmp::OverflowPolicy policy = XRtmp::DropGop;
+        bool active = true;
+        std::string error;
+    };
+
+    void deactivate(Output& output, const std::string& error)
+    {
+        output.active = false;
+        output.error = error;
+        this->setLastError(output.url + ": " + error);
+    }
+
+    std::vector<Output> outputs;
+    std::vector<int> stream_types;            // 已添加的流的媒体类型
+    AVPacket* shared_pkt = NULL;
+    bool is_closed = false;
+    std::string err_msg;
+};
+
+XFanout* XFanout::create()
+{
+    return new CXFanout();
+}
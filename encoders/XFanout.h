@@ -0,0 +1,118 @@
+#ifndef XFANOUT_H
+#define XFANOUT_H
+
+#include <cstdint>
+#include <string>
+
+#include "XRtmp.h"
+
+class AVCodecContext;
+class AVPacket;
+
+/**
+ * @class XFanout
+ * @brief 一次编码、多路输出的封装器，例如同时推流到RTMP服务器和录制到本地文件。
+ * 
+ * 每个编码后的数据包只送入一次，通过增加引用计数共享给所有输出，不拷贝数据。
+ * 每路输出是一个独立的异步 XRtmp 实例，拥有各自的时间戳转换、写入线程、队列和错误处理，
+ * 一路输出变慢或失败不会拖慢其他输出。
+ */
+class XFanout
+{
+public:
+    /**
+     * @brief 工厂方法，创建一个多路输出封装器，调用者负责 delete。
+     * 
+     * @return XFanout* 新创建的实例。
+     */
+    static XFanout* create();
+
+    /**
+     * @brief 添加一路输出，需要在 addStream() 之前调用。
+     * 
+     * @param url RTMP/RTSP 地址或本地文件路径。
+     * @param max_queue_bytes 该输出写入队列的字节预算。
+     * @param policy 队列超出字节预算时的处理策略。各输出在 sendFrame() 的调用线程上依次入队，
+     * 一路输出使用 BlockProducer 时其队列满会阻塞所有输出，有多路输出时应使用 DropGop。
+     * @return int 输出的序号，初始化封装器失败时返回-1。
+     */
+    virtual int addOutput(const char* url, int64_t max_queue_bytes = 8 * 1024 * 1024,
+                          XRtmp::OverflowPolicy policy = XRtmp::DropGop) = 0;
+
+    /**
+     * @brief 向所有输出添加视频或音频流。
+     * 
+     * @param c 编码器上下文。
+     * @return int 流的索引，sendFrame() 使用该索引，失败返回-1。
+     */
+    virtual int addStream(const AVCodecContext* c) = 0;
+
+    /**
+     * @brief 打开所有输出的IO并写入封装头，然后启动各自的写入线程。
+     * 
+     * 打开失败的输出被停用，不影响其他输出。
+     * 
+     * @return bool 至少有一路输出可用时返回true。
+     */
+    virtual bool sendHead() = 0;
+
+    /**
+     * @brief 把一个数据包分发到所有可用的输出。
+     * 
+     * 每路输出得到数据包的一个引用，调用返回后 pkt 被 unref。写入出错的输出被停用。
+     * 
+     * @param pkt 编码后的数据包，时间戳使用编码器的时间基。
+     * @param index addStream() 返回的流索引。
+     * @return bool 至少有一路输出接收了该数据包时返回true。
+     */
+    virtual bool sendFrame(AVPacket* pkt, int index) = 0;
+
+    /**
+     * @brief 获取输出的个数。
+     */
+    virtual int getOutputCount() const = 0;
+
+    /**
+     * @brief 获取输出的地址。
+     */
+    virtual const std::string& getOutputUrl(int output) const = 0;
+
+    /**
+     * @brief 判断输出是否可用（未因错误被停用）。
+     */
+    virtual bool isOutputActive(int output) const = 0;
+
+    /**
+     * @brief 获取输出写入线程的统计信息。
+     */
+    virtual XRtmp::WriterStats getOutputStats(int output) const = 0;
+
+    /**
+     * @brief 获取输出最后一次发生的错误信息。
+     */
+    virtual std::string getOutputError(int output) const = 0;
+
+    /**
+     * @brief 设置最后一次发生的错误信息。
+     */
+    virtual void setLastError(const std::string&) = 0;
+
+    /**
+     * @brief 获取最后一次发生的错误信息。
+     */
+    virtual const std::string& getLastError(void) = 0;
+
+    /**
+     * @brief 写完各输出队列中剩余的数据包，关闭所有输出并释放资源。
+     * 
+     * 关闭后仍可以读取各输出的统计信息，下一次 addOutput() 时清空输出列表。
+     */
+    virtual void close() = 0;
+
+    virtual ~XFanout() = default;
+
+protected:
+    XFanout() = default;
+};
+
+#endif // XFANOUT_H
@@ -1,5 +1,9 @@
 #include "XMediaEncode.h"
+#include "FramePtrWrapper.h"
 #include "Utils.h"
+#include "TaskScheduler.h"
+#include "CodecThreads.h"
+#include "ColorConvert.h"
 
 extern "C"
 {
@@ -10,8 +14,14 @@ extern "C"
 }
 
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 class CXMediaEncode : public XMediaEncode
 {
@@ -20,6 +30,11 @@ private:
     std::string err_msg;
 
 public:
+    ~CXMediaEncode()
+    {
+        close();
+    }
+
     void setLastError(const std::string &buf)
     {
         err_msg = buf;
@@ -35,16 +50,34 @@ public:
             sws_freeContext(vsc);
             vsc = NULL;
         }
+        freeBands();
+        if (nsc)
+        {
+            sws_freeContext(nsc);
+            nsc = NULL;
+        }
         if (yuv)
         {
             av_frame_free(&yuv);
         }
+        if (ref_yuv)
+        {
+            av_frame_free(&ref_yuv);
+        }
         if (vc)
         {
             avcodec_free_context(&vc);
         }
+        CodecThreads::release(codec_threads);
         last_video_pts = 0;
         av_packet_unref(&vpack);
+        for (auto &pkt : pending_packets)
+            av_packet_free(&pkt);
+        pending_packets.clear();
+        send_times.clear();
+        pending_frames = 0;
+        last_latency = 0;
+        flushed = false;
 
     }
 
@@ -84,10 +117,11 @@ public:
         //   c. 配置编码器参数
         vc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER; // 全局参数
         vc->codec_id = codec->id;
-        vc->thread_count = use_hard_encoder ? 1 : Utils::core_count();
+        // 从共享调度器申请线程配额，多路会话时编码线程总数不超过CPU核数
+        codec_threads = CodecThreads::configure(vc, codecThreads, use_hard_encoder);
 
-        // 压缩后每秒视频的最大bit位大小 200 kB
-        vc->bit_rate = 200 * 1024 * 8;
+        // 压缩后每秒视频的比特位大小
+        vc->bit_rate = bitrate;
         vc->width = outWidth;
         vc->height = outHeight;
         // 时间基准是us
@@ -97,10 +131,16 @@ public:
         // 画面组的大小，多少帧一个关键帧
         vc->gop_size = this->fps;
         vc->max_b_frames = 5;
+        if (closedGop)
+            vc->flags |= AV_CODEC_FLAG_CLOSED_GOP;
         vc->pix_fmt = AV_PIX_FMT_YUV420P;
 
         //   d. 打开编码器上下文
-        int ret = avcodec_open2(vc, 0, NULL);
+        AVDictionary *opts = NULL;
+        if (!use_hard_encoder && !preset.empty())
+            av_dict_set(&opts, "preset", preset.c_str(), 0);
+        int ret = avcodec_open2(vc, 0, &opts);
+        av_dict_free(&opts);
         if (ret != 0)
         {
             char buf[1024] = {0};
@@ -115,6 +155,35 @@ public:
     {
         av_packet_unref(&vpack);
 
+        std::vector<AVPacket *> packets;
+        bool ok = encodeVideo(frame, pts, packets);
+        pending_packets.insert(pending_packets.end(), packets.begin(), packets.end());
+        if (!ok || pending_packets.empty())
+            return NULL;
+
+        // 多余的包留到下一次调用返回
+        AVPacket *pkt = pending_packets.front();
+        pending_packets.pop_front();
+        av_packet_move_ref(&vpack, pkt);
+        av_packet_free(&pkt);
+        return &vpack;
+    }
+
+    bool encodeVideo(AVFrame *frame, int64_t pts, std::vector<AVPacket *> &packets)
+    {
+        int64_t begin = av_gettime_relative();
+        bool ok = encodeFrame(frame, pts, packets);
+        encode_latency.observe(av_gettime_relative() - begin);
+        return ok;
+    }
+
+    bool encodeFrame(AVFrame *frame, int64_t pts, std::vector<AVPacket *> &packets)
+    {
+        if (!vc || !frame)
+        {
+            this->setLastError("encoder is not initialized or frame is null!");
+            return false;
+        }
         // h264编码
         while (pts == last_video_pts)
             pts += 1000;
@@ -125,29 +194,88 @@ public:
         // Supply a raw video or audio frame to the encoder.
         // Use avcodec_receive_packet() to retrieve buffered output packets.
         int ret = avcodec_send_frame(vc, frame);
-        if (ret != 0)
-            return NULL;
-        // Read encoded data from the encoder.
-        ret = avcodec_receive_packet(vc, &vpack);
-        if (ret != 0 || vpack.size <= 0)
-            return NULL;
+        if (ret == AVERROR(EAGAIN))
+        {
+            // 输出队列已满，先取走数据包再送入
+            if (!receivePackets(packets))
+                return false;
+            ret = avcodec_send_frame(vc, frame);
+        }
+        if (ret < 0)
+        {
+            setAVError(ret);
+            return false;
+        }
+        send_times[pts] = Utils::get_curtime();
+        ++pending_frames;
+        // Read all encoded data ready in the encoder.
+        return receivePackets(packets);
+    }
 
-        return &vpack;
+    bool flushVideo(std::vector<AVPacket *> &packets)
+    {
+        if (!vc)
+        {
+            this->setLastError("encoder is not initialized!");
+            return false;
+        }
+        if (!flushed)
+        {
+            // 送入空帧使编码器进入冲刷模式
+            int ret = avcodec_send_frame(vc, NULL);
+            if (ret < 0 && ret != AVERROR_EOF)
+            {
+                setAVError(ret);
+                return false;
+            }
+            flushed = true;
+        }
+        return receivePackets(packets);
+    }
+
+    int getPendingFrames() const
+    {
+        return pending_frames;
+    }
+
+    int64_t getLastLatency() const
+    {
+        return last_latency;
+    }
+
+    LatencyStats getLatencyStats() const
+    {
+        LatencyStats stats;
+        stats.convert = convert_latency.snapshot();
+        stats.encode = encode_latency.snapshot();
+        stats.delay = delay_latency.snapshot();
+        return stats;
     }
 
     bool initScale()
     {
+        freeBands();
+        if (yuv)
+        {
+            av_frame_free(&yuv);
+        }
+        // 尺寸不变或整数倍缩小时使用融合的向量化内核，不需要 swscale
+        convert_factor = useSimdConvert ? getDirectConvertFactor() : 0;
         // 2. 初始化格式转换上下文
-        vsc = sws_getCachedContext(vsc,
-                                   inWidth, inHeight, AV_PIX_FMT_RGB24,     // 源宽、高、像素格式
-                                   outWidth, outHeight, AV_PIX_FMT_YUV420P, // 目标宽、高、像素格式
-                                   SWS_BICUBIC,                             // 尺寸变化使用算法
-                                   0, 0, 0);
-        if (!vsc)
+        if (!convert_factor)
         {
-            this->setLastError("sws_getCachedContext failed!");
-            return false;
+            vsc = sws_getCachedContext(vsc,
+                                       inWidth, inHeight, AV_PIX_FMT_RGB24,     // 源宽、高、像素格式
+                                       outWidth, outHeight, AV_PIX_FMT_YUV420P, // 目标宽、高、像素格式
+                                       SWS_BICUBIC,                             // 尺寸变化使用算法
+                                       0, 0, 0);
+            if (!vsc)
+            {
+                this->setLastError("sws_getCachedContext failed!");
+                return false;
+            }
         }
+        // 行带在第一次转换打包 RGB 时才创建，原生格式帧只使用 nsc，不需要为每个行带建立整帧上下文
 
         // 3. 初始化输出的数据结构
         yuv = av_frame_alloc();
@@ -168,6 +296,23 @@ public:
     }
 
     AVFrame *rgb2yuv(char *rgb)
+    {
+        int64_t begin = av_gettime_relative();
+        AVFrame *out = packedToYuv(rgb);
+        convert_latency.observe(av_gettime_relative() - begin);
+        return out;
+    }
+
+    AVFrame *toYuv(const FramePtrWrapper &frame)
+    {
+        int64_t begin = av_gettime_relative();
+        AVFrame *out = frameToYuv(frame);
+        convert_latency.observe(av_gettime_relative() - begin);
+        return out;
+    }
+
+private:
+    AVFrame *packedToYuv(char *rgb)
     {
         // 输入的数据结构
         uint8_t *indata[AV_NUM_DATA_POINTERS] = {0};
@@ -177,6 +322,13 @@ public:
         // 一行（宽）数据的字节数
         insize[0] = inWidth * inPixSize;
 
+        // 编码器可能仍引用上一帧的缓冲区，必要时重新分配
+        if (av_frame_make_writable(yuv) < 0)
+            return NULL;
+        if (!ensureBands())
+            return NULL;
+        if (convert_factor || !bands.empty())
+            return convertRgb(indata[0], insize[0]) ? yuv : NULL;
         int h = sws_scale(vsc, indata, insize, 0, inHeight, // 源数据
                           yuv->data, yuv->linesize);
         if (h <= 0)
@@ -186,11 +338,297 @@ public:
         return yuv;
     }
 
-private:
+    AVFrame *frameToYuv(const FramePtrWrapper &frame)
+    {
+        const AVFrame *src = frame.getAVFrame();
+        if (!src)
+            return packedToYuv((char *)frame.getDataPtr());
+        if (!yuv)
+        {
+            this->setLastError("initScale must be called before toYuv!");
+            return NULL;
+        }
+
+        // 格式和尺寸一致，直接引用解码器输出的帧
+        if (src->format == AV_PIX_FMT_YUV420P && src->width == outWidth && src->height == outHeight)
+        {
+            if (!ref_yuv)
+                ref_yuv = av_frame_alloc();
+            av_frame_unref(ref_yuv);
+            if (av_frame_ref(ref_yuv, src) < 0)
+                return NULL;
+            // 不沿用解码端的帧类型，否则编码器会照搬源视频的 GOP 结构
+            ref_yuv->pict_type = AV_PICTURE_TYPE_NONE;
+            return ref_yuv;
+        }
+
+        // RGB24 且尺寸与 initScale 时一致，使用向量化内核
+        if (convert_factor && src->format == AV_PIX_FMT_RGB24 && src->width == inWidth && src->height == inHeight)
+        {
+            if (av_frame_make_writable(yuv) < 0)
+                return NULL;
+            return convertRgb(src->data[0], src->linesize[0]) ? yuv : NULL;
+        }
+
+        // 只做一次缩放和颜色空间转换
+        nsc = sws_getCachedContext(nsc,
+                                   src->width, src->height, (AVPixelFormat)src->format,
+                                   outWidth, outHeight, AV_PIX_FMT_YUV420P,
+                                   SWS_BICUBIC,
+                                   0, 0, 0);
+        if (!nsc)
+        {
+            this->setLastError("sws_getCachedContext failed!");
+            return NULL;
+        }
+        if (av_frame_make_writable(yuv) < 0)
+            return NULL;
+        int h = sws_scale(nsc, src->data, src->linesize, 0, src->height,
+                          yuv->data, yuv->linesize);
+        if (h <= 0)
+        {
+            return NULL;
+        }
+        return yuv;
+    }
+
+    /**
+     * @brief 按输出行带拆分 RGB 转 YUV 的任务
+     *
+     * 使用向量化内核时行带只是行范围，高度为偶数，保证 YUV420P 的色度行不会跨越两个行带。
+     * 使用 swscale 时每个行带有一个按整帧配置的上下文，输入整帧，只输出本行带的行
+     * （sws_receive_slice），垂直滤波在行带边界处读取的仍是相邻的真实行，结果与整帧转换相同。
+     */
+    bool initBands()
+    {
+        int threads = scaleThreads;
+        if (threads <= 0)
+            // 每个行带至少 128 行，避免小分辨率时线程调度开销超过转换本身
+            threads = std::min(TaskScheduler::instance().getThreadCount(), outHeight / 128);
+        if (threads <= 1)
+            return true;
+
+        int band_count = 0;
+        int band_height = (outHeight + threads - 1) / threads;
+        for (int y = 0; y < outHeight; y += band_height)
+        {
+            Band band;
+            if (!convert_factor)
+            {
+                band.sc = sws_getContext(inWidth, inHeight, AV_PIX_FMT_RGB24,
+                                         outWidth, outHeight, AV_PIX_FMT_YUV420P,
+                                         SWS_BICUBIC, 0, 0, 0);
+                if (!band.sc)
+                {
+                    freeBands();
+                    this->setLastError("sws_getContext failed!");
+                    return false;
+                }
+            }
+            if (0 == band_count++)
+            {
+                // 除最后一个行带外，行带的起始行和高度都要按 swscale 要求的行数对齐
+                int align = band.sc ? std::max(2, (int)sws_receive_slice_alignment(band.sc)) : 2;
+                band_height = (band_height + align - 1) / align * align;
+            }
+            band.y = y;
+            band.height = std::min(band_height, outHeight - y);
+            bands.push_back(band);
+        }
+        return true;
+    }
+
+    void freeBands()
+    {
+        for (auto &band : bands)
+        {
+            if (band.sc)
+                sws_freeContext(band.sc);
+        }
+        bands.clear();
+        bands_ready = false;
+        av_frame_free(&rgb_frame);
+    }
+
+    /**
+     * @brief 第一次转换打包 RGB 时按需创建行带
+     */
+    bool ensureBands()
+    {
+        if (!bands_ready)
+            bands_ready = initBands();
+        return bands_ready;
+    }
+
+    struct Band
+    {
+        int y = 0;              // 行带在图像中的起始行
+        int height = 0;         // 行带的高度
+        SwsContext *sc = NULL;  // 行带的整帧转换上下文，使用向量化内核时为空
+    };
+
+    /**
+     * @brief 取出编码器中所有已就绪的数据包，直到编码器需要新的输入或者冲刷结束
+     */
+    bool receivePackets(std::vector<AVPacket *> &packets)
+    {
+        while (true)
+        {
+            AVPacket *pkt = av_packet_alloc();
+            if (!pkt)
+            {
+                this->setLastError("av_packet_alloc failed!");
+                return false;
+            }
+            int ret = avcodec_receive_packet(vc, pkt);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            {
+                av_packet_free(&pkt);
+                return true;
+            }
+            if (ret < 0)
+            {
+                av_packet_free(&pkt);
+                setAVError(ret);
+                return false;
+            }
+            // 数据包的 pts 与送入的帧一致，据此计算编码延迟
+            auto it = send_times.find(pkt->pts);
+            if (it != send_times.end())
+            {
+                last_latency = Utils::get_curtime() - it->second;
+                delay_latency.observe(last_latency);
+                send_times.erase(it);
+            }
+            // 之后输出的数据包的 pts 都不小于当前的 dts，更早的记录（如编码器丢弃的帧）不会再被匹配
+            int64_t horizon = AV_NOPTS_VALUE != pkt->dts ? pkt->dts : pkt->pts;
+            if (AV_NOPTS_VALUE != horizon)
+                send_times.erase(send_times.begin(), send_times.lower_bound(horizon));
+            if (pending_frames > 0)
+                --pending_frames;
+            packets.push_back(pkt);
+        }
+    }
+
+    void setAVError(int ret)
+    {
+        char buf[1024] = {0};
+        av_strerror(ret, buf, sizeof(buf) - 1);
+        this->setLastError(buf);
+    }
+
+    /**
+     * @brief 输入宽高是输出的 1、2、4 倍时返回倍数，可以使用融合的缩小转换内核；否则返回 0
+     */
+    int getDirectConvertFactor() const
+    {
+        const int factors[] = {1, 2, 4};
+        for (int factor : factors)
+        {
+            if (inWidth == outWidth * factor && inHeight == outHeight * factor)
+                return factor;
+        }
+        return 0;
+    }
+
+    /**
+     * @brief 转换一个行带，rgb 为整帧的起始地址，y 和 height 为输出图像中的行
+     *
+     * sc 不为空时 rgb_frame 已经引用整帧输入，只输出该行带的行。
+     */
+    bool convertBand(const uint8_t *rgb, int rgb_stride, int y, int height, SwsContext *sc)
+    {
+        if (sc)
+        {
+            if (sws_frame_start(sc, yuv, rgb_frame) < 0)
+                return false;
+            int ret = sws_send_slice(sc, 0, inHeight);
+            if (ret >= 0)
+                ret = sws_receive_slice(sc, y, height);
+            // 释放上下文对输入输出帧的引用，yuv 保持可写
+            sws_frame_end(sc);
+            return ret >= 0;
+        }
+        const uint8_t *src = rgb + (int64_t)y * std::max(convert_factor, 1) * rgb_stride;
+        uint8_t *dst[AV_NUM_DATA_POINTERS] = {0};
+        dst[0] = yuv->data[0] + (int64_t)y * yuv->linesize[0];
+        dst[1] = yuv->data[1] + (int64_t)(y / 2) * yuv->linesize[1];
+        dst[2] = yuv->data[2] + (int64_t)(y / 2) * yuv->linesize[2];
+        return ColorConvert::rgb24DownscaleToYuv420p(convert_factor, src, rgb_stride,
+                                                     dst, yuv->linesize, outWidth, height);
+    }
+
+    /**
+     * @brief 把整帧 RGB 数据包装为引用计数的帧，swscale 的帧接口只增加引用而不复制数据
+     *
+     * 缓冲区不归帧所有，转换完成后需要 av_frame_unref(rgb_frame)。
+     */
+    bool wrapRgb(const uint8_t *rgb, int rgb_stride)
+    {
+        if (!rgb_frame && !(rgb_frame = av_frame_alloc()))
+            return false;
+        av_frame_unref(rgb_frame);
+        rgb_frame->buf[0] = av_buffer_create((uint8_t *)rgb, (size_t)rgb_stride * inHeight,
+                                             keep_buffer, NULL, AV_BUFFER_FLAG_READONLY);
+        if (!rgb_frame->buf[0])
+            return false;
+        rgb_frame->data[0] = (uint8_t *)rgb;
+        rgb_frame->linesize[0] = rgb_stride;
+        rgb_frame->format = AV_PIX_FMT_RGB24;
+        rgb_frame->width = inWidth;
+        rgb_frame->height = inHeight;
+        return true;
+    }
+
+    static void keep_buffer(void *, uint8_t *)
+    {
+    }
+
+    /**
+     * @brief 使用向量化内核或按行带的 swscale 转换，有行带时并行转换（调用者需保证 yuv 可写）
+     */
+    bool convertRgb(const uint8_t *rgb, int rgb_stride)
+    {
+        if (!ensureBands())
+            return false;
+        if (bands.empty())
+            return convertBand(rgb, rgb_stride, 0, outHeight, NULL);
+        if (!convert_factor && !wrapRgb(rgb, rgb_stride))
+        {
+            this->setLastError("wrap rgb frame failed!");
+            return false;
+        }
+        // 各行带的输出互不重叠，可以并行转换，任务交给进程内共享的调度器
+        std::atomic<bool> ok(true);
+        TaskScheduler::instance().parallelFor((int)bands.size(), [&](int i) {
+            const Band &band = bands[i];
+            if (!convertBand(rgb, rgb_stride, band.y, band.height, band.sc))
+                ok = false;
+        });
+        if (rgb_frame)
+            av_frame_unref(rgb_frame);
+        return ok;
+    }
+
     int64_t last_video_pts = 0;
     SwsContext *vsc = NULL; // 像素格式转换上下文
+    SwsContext *nsc = NULL; // 原生格式帧的转换上下文，随输入格式自动重建
     AVFrame *yuv = NULL;    // 输出的YUV
+    AVFrame *ref_yuv = NULL; // 直接引用输入帧时使用的YUV
+    int convert_factor = 0;   // 使用向量化内核时的缩小倍数（1、2、4），0 表示使用 swscale
+    std::vector<Band> bands;  // 并行转换的行带，为空时整帧转换
+    bool bands_ready = false; // 行带是否已按当前的 initScale 参数创建
+    AVFrame *rgb_frame = NULL; // 按行带 swscale 转换时引用整帧输入的帧
     AVPacket vpack = {0};
+    std::deque<AVPacket *> pending_packets;   // 单包接口尚未返回的数据包
+    int codec_threads = 0;                     // 从共享调度器申请到的编码线程配额
+    std::map<int64_t, int64_t> send_times;     // 已送入编码器的帧 pts -> 送入时间
+    int pending_frames = 0;                    // 已送入但尚未输出的帧数
+    int64_t last_latency = 0;                  // 最近一个数据包的编码延迟（微秒）
+    bool flushed = false;                      // 已经送入空帧进入冲刷模式
+    LatencyHistogram convert_latency;          // rgb2yuv/toYuv 的耗时
+    LatencyHistogram encode_latency;           // encodeVideo 的耗时
+    LatencyHistogram delay_latency;            // 数据包的编码延迟
 };
 
 const std::map<std::string, std::string> CXMediaEncode::encoder_map = {
@@ -201,32 +639,43 @@ const std::map<std::string, std::string> CXMediaEncode::encoder_map = {
     {"libx265", "hevc_rkmpp"},
 };
 
-XMediaEncode *XMediaEncode::getInstance(unsigned char index)
+static void init_codecs()
 {
-    static bool is_first = true;
-    if (is_first)
-    {
-        // 注册所有的编解码器
-        // avcodec_register_all();
-        is_first = false;
+    // 注册所有的编解码器
+    // avcodec_register_all();
 
-        // 获取所有注册的编码器并输出它们的名称
-        const AVCodec *codec = NULL;
-        void *opaque = NULL;
+    // 获取所有注册的编码器并输出它们的名称
+    const AVCodec *codec = NULL;
+    void *opaque = NULL;
 
-        while ((codec = av_codec_iterate(&opaque)))
+    while ((codec = av_codec_iterate(&opaque)))
+    {
+        if (codec->type == AVMEDIA_TYPE_VIDEO)
         {
-            if (codec->type == AVMEDIA_TYPE_VIDEO)
+            // 输出编码器名称
+            if (strstr(codec->name, "rk") != NULL)
             {
-                // 输出编码器名称
-                if (strstr(codec->name, "rk") != NULL)
-                {
-                    av_log(NULL, AV_LOG_INFO, "RK Related Video Encoder name: %s\n", codec->name);
-                }
+                av_log(NULL, AV_LOG_INFO, "RK Related Video Encoder name: %s\n", codec->name);
             }
         }
     }
+}
 
-    static CXMediaEncode cxm[255];
-    return &cxm[index];
+XMediaEncode *XMediaEncode::getInstance(unsigned char index)
+{
+    // 按需创建，不再在启动时构造全部实例
+    static std::mutex mutex;
+    static std::unique_ptr<CXMediaEncode> instances[256];
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!instances[index])
+        instances[index].reset(static_cast<CXMediaEncode *>(create()));
+    return instances[index].get();
+}
+
+XMediaEncode *XMediaEncode::create()
+{
+    // 局部静态变量保证多线程下只执行一次
+    static const bool codecs_listed = (init_codecs(), true);
+    (void)codecs_listed;
+    return new CXMediaEncode();
 }
@@ -1,11 +1,16 @@
 #ifndef XMEDIAENCODE_H
 #define XMEDIAENCODE_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
 
 struct AVFrame;
 struct AVPacket;
 struct AVCodecContext;
+class FramePtrWrapper;
 
 
 /**
@@ -27,20 +32,38 @@ public:
     int outWidth = inWidth;  ///< 输出视频帧的宽度，默认为输入宽度
     int outHeight = inHeight; ///< 输出视频帧的高度，默认为输入高度
     int bitrate = 4000000; ///< 压缩后每秒视频的比特位大小，默认为4000000bps（约500kB/s）
+    int codecThreads = 0; ///< 软件编码器使用的线程数，0表示使用全部剩余配额，实际线程数受进程内共享的线程配额限制
     int fps = 25;  ///< 输出视频的帧率，默认为25帧每秒
+    int scaleThreads = 0; ///< RGB转YUV使用的线程数，0表示按输出高度和CPU核数自动选择，1表示单线程
+    bool useSimdConvert = false; ///< 输入尺寸是输出的1、2、4倍时使用手写向量化的RGB转YUV（盒式缩小）内核，默认使用swscale：内核的色度为2x2均值，细节丰富的画面上与swscale的差异超过1
+    bool closedGop = false; ///< 是否只使用封闭 GOP（GOP 内的帧不参考前一个 GOP），分段编码后拼接时需要
+    std::string preset; ///< 软件编码器的预设（如x264的ultrafast、veryfast、medium），为空时使用编码器默认值，硬件编码器忽略该参数
 
     /**
      * @brief 工厂方法，获取XMediaEncode实例
      * 
+     * 同一索引总是返回同一个实例，实例在第一次获取时创建，进程退出时释放。
+     * 
      * @param index 实例的索引，默认为0
      * @return XMediaEncode* 返回XMediaEncode实例的指针
      */
     static XMediaEncode *getInstance(unsigned char index = 0);
 
+    /**
+     * @brief 工厂方法，创建一个独立的XMediaEncode实例
+     * 
+     * 每次调用都返回新的实例，调用者负责 delete，析构时自动 close()。
+     * 多路会话应使用该方法，而不是共享 getInstance() 的实例。
+     * 
+     * @return XMediaEncode* 新创建的XMediaEncode实例
+     */
+    static XMediaEncode *create();
+
     /**
      * @brief 初始化像素格式转换的上下文
      * 
      * 该方法用于初始化像素格式转换所需的上下文，以便后续进行像素格式转换操作。
+     * 输入宽高是输出的1、2、4倍时自动选择融合缩小和颜色空间转换的向量化内核，其余情况使用swscale。
      * @return bool 初始化成功返回true，失败返回false
      */
     virtual bool initScale() = 0;
@@ -55,6 +78,17 @@ public:
      */
     virtual AVFrame *rgb2yuv(char *rgb) = 0;
 
+    /**
+     * @brief 将任意像素格式的视频帧转换为编码器需要的YUV420P格式
+     * 
+     * 对于引用 AVFrame 的多平面帧：像素格式和尺寸与编码器一致时直接引用，不做任何转换；
+     * 否则只做一次缩放和颜色空间转换。对于打包的RGB数据，等价于调用 rgb2yuv()。
+     * 返回的AVFrame对象无需调用者清理，在下一次调用前有效。
+     * @param frame 输入的视频帧
+     * @return AVFrame* 转换后的YUV格式AVFrame对象指针，失败时返回nullptr
+     */
+    virtual AVFrame *toYuv(const FramePtrWrapper &frame) = 0;
+
     /**
      * @brief 初始化视频编码器
      * 
@@ -67,12 +101,67 @@ public:
      * @brief 对视频帧进行编码
      * 
      * 该方法对输入的AVFrame对象进行编码，生成编码后的AVPacket对象。
+     * 每次调用最多返回一个包，编码器一次输出的多个包会缓存起来，在之后的调用中依次返回。
+     * 新代码应使用返回全部数据包的重载。
      * @param frame 输入的待编码视频帧
      * @param pts 视频帧的显示时间戳
-     * @return AVPacket* 编码后的AVPacket对象指针，失败时返回nullptr
+     * @return AVPacket* 编码后的AVPacket对象指针，在下一次调用前有效；失败或暂无输出时返回nullptr
      */
     virtual AVPacket *encodeVideo(AVFrame *frame, int64_t pts) = 0;
 
+    /**
+     * @brief 对视频帧进行编码，取出编码器当前已经输出的全部数据包
+     * 
+     * 开启B帧或帧级多线程时，编码器内部会缓存若干帧，一次送入可能输出零个或多个包。
+     * 返回的数据包追加到 packets 末尾，均为引用计数的独立对象，由调用者通过 av_packet_free 释放。
+     * @param frame 输入的待编码视频帧
+     * @param pts 视频帧的显示时间戳
+     * @param packets 输出参数，追加编码得到的数据包
+     * @return bool 成功返回true（即使没有输出包），失败返回false
+     */
+    virtual bool encodeVideo(AVFrame *frame, int64_t pts, std::vector<AVPacket *> &packets) = 0;
+
+    /**
+     * @brief 冲刷编码器，取出内部缓存的所有数据包
+     * 
+     * 在流结束时调用，否则编码器中缓存的最后几帧会丢失。冲刷之后编码器不能再接收新的帧，
+     * 需要 close() 后重新 initVideoCodec()。返回的数据包由调用者通过 av_packet_free 释放。
+     * @param packets 输出参数，追加冲刷得到的数据包
+     * @return bool 成功返回true，失败返回false
+     */
+    virtual bool flushVideo(std::vector<AVPacket *> &packets) = 0;
+
+    /**
+     * @brief 获取已送入编码器但尚未输出数据包的帧数，即编码器当前的延迟（帧）
+     * 
+     * @return int 编码器内部缓存的帧数
+     */
+    virtual int getPendingFrames() const = 0;
+
+    /**
+     * @brief 获取最近一个数据包从送入对应帧到输出数据包所经过的时间
+     * 
+     * @return int64_t 编码延迟（微秒），尚无输出时为0
+     */
+    virtual int64_t getLastLatency() const = 0;
+
+    /**
+     * @brief 编码器各环节的耗时统计
+     */
+    struct LatencyStats
+    {
+        LatencyHistogram::Snapshot convert; ///< rgb2yuv/toYuv 的耗时
+        LatencyHistogram::Snapshot encode;  ///< 每次 encodeVideo 调用（送入帧并取出数据包）的耗时
+        LatencyHistogram::Snapshot delay;   ///< 每个数据包从送入对应帧到输出的时间，包含编码器内部的缓存
+    };
+
+    /**
+     * @brief 获取编码器各环节的耗时统计，可以在其他线程中调用
+     * 
+     * @return LatencyStats 转换、编码和编码延迟的直方图
+     */
+    virtual LatencyStats getLatencyStats() const = 0;
+
     /**
      * @brief 设置最后一次错误信息
      * 
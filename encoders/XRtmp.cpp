@@ -1,7 +1,14 @@
 #include "XRtmp.h"
+#include "CpuTopology.h"
+#include "Utils.h"
 
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 extern "C"
 {
@@ -13,12 +20,20 @@ extern "C"
 class CXRtmp : public XRtmp
 {
 public:
+    ~CXRtmp()
+    {
+        stopWriter();
+        if(ic)
+            close();
+    }
 
     void close()
     {
+        // 先写完异步队列中剩余的数据包，再写封装尾
+        stopWriter();
         if(ic)
         {
-            int ret;
+            int ret = 0;
             if(url.substr(0, 4) != "rtmp")
                 av_write_trailer(ic);
             
@@ -30,13 +45,13 @@ public:
             this->setLastError(buf);
             std::cout << this->getLastError() << std::endl;
             avformat_free_context(ic);
-            
+            ic = NULL;
         }
         
         vs = NULL;
         as = NULL;
-        vc = NULL;
-        ac = NULL;
+        v_time_base = AVRational{0, 1};
+        a_time_base = AVRational{0, 1};
         url.clear();
         std::cout << "10" << std::endl;
     }
@@ -81,12 +96,49 @@ public:
 
         if(c->codec_type == AVMEDIA_TYPE_VIDEO)
         {
-            vc = c;
+            v_time_base = c->time_base;
             vs = st;
         }
         else if(c->codec_type == AVMEDIA_TYPE_AUDIO)
         {
-            ac = c;
+            a_time_base = c->time_base;
+            as = st;
+        }
+
+        return st->index;
+    }
+
+    int addStream(const AVStream* src)
+    {
+        if(!src)
+            return -1;
+
+        AVStream* st = avformat_new_stream(ic, NULL);
+        if(!st)
+        {
+            this->setLastError("avformat_new_stream failed");
+            return -1;
+        }
+        // 从输入流复制参数，输入封装的 codec_tag 不一定适用于输出封装
+        if(avcodec_parameters_copy(st->codecpar, src->codecpar) < 0)
+        {
+            this->setLastError("avcodec_parameters_copy failed");
+            return -1;
+        }
+        st->codecpar->codec_tag = 0;
+        // 只是建议值，写封装头时封装器可能改为自己的时间基
+        st->time_base = src->time_base;
+        st->avg_frame_rate = src->avg_frame_rate;
+        av_dump_format(ic, 0, url.c_str(), 1);
+
+        if(src->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        {
+            v_time_base = src->time_base;
+            vs = st;
+        }
+        else if(src->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+        {
+            a_time_base = src->time_base;
             as = st;
         }
 
@@ -128,30 +180,11 @@ public:
     {
         if(pack->size <= 0 || !pack->data)
             return false;
-        const AVRational* stime = NULL;
-        const AVRational* dtime = NULL;
-        pack->stream_index = index;
-        //判断是音频还是视频
-        if(vs && vc && pack->stream_index == vs->index)
-        {
-            stime = &(vc->time_base);
-            dtime = &(vs->time_base);
-        }
-        else if(as && ac && pack->stream_index == as->index)
-        {
-            stime = &(ac->time_base);
-            dtime = &(as->time_base);
-        }
-        else
-        {
+        if(!rescalePacket(pack, index))
             return false;
-        }
+        if(is_async)
+            return enqueuePacket(pack);
 
-        // 推流 a*b / c
-        // pack->pts * vc->time_base 为实际秒数
-        pack->pts = av_rescale_q(pack->pts, *stime, *dtime);
-        pack->dts = av_rescale_q(pack->dts, *stime, *dtime);
-        pack->duration = av_rescale_q(pack->duration, *stime, *dtime);
         int ret = av_interleaved_write_frame(ic, pack);
         av_packet_unref(pack);
         if(ret == 0)
@@ -160,6 +193,48 @@ public:
         return false;
     }
 
+    bool startAsync(int64_t max_queue_bytes, OverflowPolicy policy)
+    {
+        if(!ic || !ic->pb)
+        {
+            this->setLastError("startAsync must be called after sendHead");
+            return false;
+        }
+        if(is_async)
+        {
+            this->setLastError("async writer is already running");
+            return false;
+        }
+        this->max_queue_bytes = max_queue_bytes > 0 ? max_queue_bytes : 1;
+        this->overflow_policy = policy;
+        writer_exit = false;
+        skip_to_keyframe = false;
+        stats = WriterStats();
+        is_async = true;
+        writer_thread = std::thread(&CXRtmp::writerLoop, this);
+        return true;
+    }
+
+    void setWriterAffinity(const std::vector<int>& cpus)
+    {
+        writer_cpus = cpus;
+    }
+
+    bool isAsync() const
+    {
+        return is_async;
+    }
+
+    WriterStats getWriterStats() const
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        WriterStats result = stats;
+        result.queue_packets = (int)packet_queue.size();
+        result.queue_bytes = queue_bytes;
+        result.write_latency = write_latency.snapshot();
+        return result;
+    }
+
     void setLastError(const std::string& buf)
     {
         err_msg = buf;
@@ -169,33 +244,248 @@ public:
         return err_msg;
     }
 private:
+    /**
+     * @brief 检查流索引并把时间戳从编码器或输入流的时间基转换为输出流的时间基
+     */
+    bool rescalePacket(AVPacket* pack, int index)
+    {
+        AVRational stime;
+        AVRational dtime;
+        pack->stream_index = index;
+        //判断是音频还是视频
+        if(vs && pack->stream_index == vs->index)
+        {
+            stime = v_time_base;
+            dtime = vs->time_base;
+        }
+        else if(as && pack->stream_index == as->index)
+        {
+            stime = a_time_base;
+            dtime = as->time_base;
+        }
+        else
+        {
+            return false;
+        }
+
+        // 推流 a*b / c
+        // pack->pts * stime 为实际秒数；直通的数据包可能没有 pts 或 dts，未知的时间戳保持未知
+        av_packet_rescale_ts(pack, stime, dtime);
+        return true;
+    }
+
+    /**
+     * @brief 把数据包的引用移动到写入队列，超出字节预算时按策略阻塞或丢弃 GOP
+     */
+    bool enqueuePacket(AVPacket* pack)
+    {
+        const bool is_key = pack->flags & AV_PKT_FLAG_KEY;
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        // 写入线程出错后输出已经不可用，直到 close() 之前都拒绝新的数据包
+        if(!write_error.empty())
+        {
+            this->setLastError(write_error);
+            av_packet_unref(pack);
+            return false;
+        }
+        if(queue_bytes + pack->size > max_queue_bytes && !packet_queue.empty())
+        {
+            if(DropGop == overflow_policy)
+            {
+                dropOldestGops(pack->size);
+                // 当前 GOP 已经被丢弃，后续的非关键帧无法解码
+                if(packet_queue.empty() && !is_key)
+                    skip_to_keyframe = true;
+            }
+            else
+            {
+                int64_t begin = av_gettime_relative();
+                not_full.wait(lock, [&]() {
+                    return queue_bytes + pack->size <= max_queue_bytes || packet_queue.empty() || writer_exit ||
+                           !write_error.empty();
+                });
+                stats.producer_stall_us += av_gettime_relative() - begin;
+                if(!write_error.empty())
+                {
+                    this->setLastError(write_error);
+                    av_packet_unref(pack);
+                    return false;
+                }
+            }
+        }
+        if(skip_to_keyframe)
+        {
+            if(!is_key)
+            {
+                ++stats.dropped_packets;
+                av_packet_unref(pack);
+                return false;
+            }
+            skip_to_keyframe = false;
+        }
+
+        AVPacket* queued = av_packet_alloc();
+        if(!queued)
+        {
+            av_packet_unref(pack);
+            this->setLastError("av_packet_alloc failed");
+            return false;
+        }
+        av_packet_move_ref(queued, pack);
+        queue_bytes += queued->size;
+        if(queue_bytes > stats.peak_queue_bytes)
+            stats.peak_queue_bytes = queue_bytes;
+        packet_queue.push_back(queued);
+        ++stats.queued_packets;
+        lock.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 从队首整 GOP 地丢弃数据包，直到能放下 incoming_size 字节（调用者需持有 queue_mutex）
+     *
+     * 丢弃后队首总是关键帧，写入线程写出的码流在关键帧处衔接。
+     */
+    void dropOldestGops(int incoming_size)
+    {
+        while(!packet_queue.empty() && queue_bytes + incoming_size > max_queue_bytes)
+        {
+            do
+            {
+                AVPacket* pkt = packet_queue.front();
+                packet_queue.pop_front();
+                queue_bytes -= pkt->size;
+                av_packet_free(&pkt);
+                ++stats.dropped_packets;
+            } while(!packet_queue.empty() && !(packet_queue.front()->flags & AV_PKT_FLAG_KEY));
+            ++stats.dropped_gops;
+        }
+    }
+
+    /**
+     * @brief 写入线程的主循环，退出前写完队列中剩余的数据包
+     */
+    void writerLoop()
+    {
+        CpuTopology::pin_current_thread(writer_cpus);
+        while(true)
+        {
+            AVPacket* pkt = NULL;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                not_empty.wait(lock, [this]() { return !packet_queue.empty() || writer_exit; });
+                if(packet_queue.empty())
+                    break;
+                pkt = packet_queue.front();
+                packet_queue.pop_front();
+                queue_bytes -= pkt->size;
+            }
+            not_full.notify_all();
+
+            int64_t begin = av_gettime_relative();
+            int ret = av_interleaved_write_frame(ic, pkt);
+            int64_t latency = av_gettime_relative() - begin;
+            av_packet_free(&pkt);
+            write_latency.observe(latency);
+
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stats.last_write_latency_us = latency;
+            stats.total_write_latency_us += latency;
+            if(latency > stats.max_write_latency_us)
+                stats.max_write_latency_us = latency;
+            if(ret == 0)
+            {
+                ++stats.written_packets;
+            }
+            else
+            {
+                ++stats.write_errors;
+                char buf[1024] = { 0 };
+                av_strerror(ret, buf, sizeof(buf) - 1);
+                write_error = buf;
+            }
+        }
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stats.writer_cpu_us = Utils::thread_cpu_time_us();
+    }
+
+    /**
+     * @brief 通知写入线程写完剩余数据包后退出，并等待其退出
+     */
+    void stopWriter()
+    {
+        if(!is_async)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            writer_exit = true;
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+        if(writer_thread.joinable())
+            writer_thread.join();
+        is_async = false;
+        if(!write_error.empty())
+        {
+            this->setLastError(write_error);
+            write_error.clear();
+        }
+    }
+
     //rtmp flv 封装器
     AVFormatContext* ic = NULL;
 
-    // 视频编码器流
-    const AVCodecContext* vc = NULL;
+    // 视频流，及 sendFrame 传入的数据包的时间基（编码器或输入流的时间基）
+    AVRational v_time_base = {0, 1};
     AVStream* vs = NULL;
 
-    // 音频编码器流
-    const AVCodecContext* ac = NULL;
+    // 音频流
+    AVRational a_time_base = {0, 1};
     AVStream* as = NULL;
 
     std::string url;
     std::string err_msg;
+
+    // 异步写入模式
+    bool is_async = false;
+    std::thread writer_thread;
+    std::vector<int> writer_cpus;              // 写入线程绑定的 CPU，为空表示不绑定
+    mutable std::mutex queue_mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<AVPacket*> packet_queue;        // 等待写入的数据包，由队列独占
+    int64_t queue_bytes = 0;                   // 队列中数据包的总字节数
+    int64_t max_queue_bytes = 0;               // 队列的字节预算
+    OverflowPolicy overflow_policy = BlockProducer;
+    bool writer_exit = false;
+    bool skip_to_keyframe = false;             // 丢弃了当前 GOP 后，新的数据包在关键帧前都要丢弃
+    std::string write_error;                   // 写入线程最近一次的错误信息，close() 时清除
+    WriterStats stats;
+    LatencyHistogram write_latency;            // 写入耗时直方图，不需要持有 queue_mutex
 };
 
+static void init_network()
+{
+    //注册所有网络协议，局部静态变量保证多线程下只初始化一次
+    static const int ret = avformat_network_init();
+    (void)ret;
+}
+
 //工厂生产方法
 XRtmp* XRtmp::getInstance(unsigned char index)
 {
-    static CXRtmp cxr[255];
-
-    static bool is_first = true;
-    if(is_first)
-    {
-        //注册所有网络协议
-        avformat_network_init();
-        is_first = false;
-    }
-    return &cxr[index];
+    // 按需创建，不再在启动时构造全部实例
+    static std::mutex mutex;
+    static std::unique_ptr<XRtmp> instances[256];
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!instances[index])
+        instances[index].reset(create());
+    return instances[index].get();
 }
 
+XRtmp* XRtmp::create()
+{
+    init_network();
+    return new CXRtmp();
+}
@@ -1,10 +1,15 @@
 #ifndef XRTMP_H
 #define XRTMP_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
 
 class AVCodecContext;
 class AVPacket;
+class AVStream;
 
 /**
  * @class XRtmp
@@ -16,16 +21,57 @@ class AVPacket;
 class XRtmp
 {
 public:
+    /**
+     * @brief 异步写入模式下队列超出字节预算时的处理策略
+     */
+    enum OverflowPolicy
+    {
+        BlockProducer = 0, ///< 阻塞调用 sendFrame 的线程直到队列有空间，不丢数据，适合写本地文件
+        DropGop,           ///< 从队首丢弃整个 GOP，不阻塞编码线程，适合直播推流
+    };
+
+    /**
+     * @brief 异步写入线程的统计信息
+     */
+    struct WriterStats
+    {
+        int64_t queued_packets = 0;          ///< 进入队列的数据包数
+        int64_t written_packets = 0;         ///< 写入成功的数据包数
+        int64_t dropped_packets = 0;         ///< 因超出字节预算丢弃的数据包数
+        int64_t dropped_gops = 0;            ///< 丢弃的 GOP 数
+        int64_t write_errors = 0;            ///< 写入失败的次数
+        int64_t producer_stall_us = 0;       ///< 调用线程等待队列空间的累计时间（微秒）
+        int64_t last_write_latency_us = 0;   ///< 最近一次 av_interleaved_write_frame 的耗时（微秒）
+        int64_t max_write_latency_us = 0;    ///< 单次写入的最大耗时（微秒）
+        int64_t total_write_latency_us = 0;  ///< 写入的累计耗时（微秒）
+        int queue_packets = 0;               ///< 当前队列中的数据包数
+        int64_t queue_bytes = 0;             ///< 当前队列中的字节数
+        int64_t peak_queue_bytes = 0;        ///< 队列字节数的峰值
+        int64_t writer_cpu_us = 0;           ///< 写入线程退出时已使用的 CPU 时间（微秒），线程运行中为 0
+        LatencyHistogram::Snapshot write_latency; ///< 每次写入耗时的直方图
+    };
+
     /**
      * @brief 工厂方法，用于获取XRtmp类的实例。
      * 
      * 通过该方法可以创建XRtmp类的派生类实例，用户可以根据需要指定实例的索引。
+     * 同一索引总是返回同一个实例，实例在第一次获取时创建，进程退出时释放。
      * 
      * @param index 实例的索引，默认为0。
      * @return XRtmp* 返回XRtmp类实例的指针，失败时返回nullptr。
      */
     static XRtmp* getInstance(unsigned char index = 0);
 
+    /**
+     * @brief 工厂方法，创建一个独立的XRtmp实例。
+     * 
+     * 与 getInstance() 不同，每次调用都返回新的实例，调用者负责 delete，
+     * 适用于同时写多个输出的场景。
+     * 
+     * @return XRtmp* 新创建的XRtmp实例。
+     */
+    static XRtmp* create();
+
     /**
      * @brief 初始化封装器上下文。
      * 
@@ -47,6 +93,17 @@ public:
      */
     virtual int addStream(const AVCodecContext* c) = 0;
 
+    /**
+     * @brief 按输入流的参数向封装器中添加流，用于不经过编解码直接转发数据包（直通）。
+     * 
+     * 用 avcodec_parameters_copy 复制输入流的编解码参数（包括 SPS/PPS 等 extradata），
+     * sendFrame() 把数据包的时间戳从输入流的时间基转换为输出流的时间基。
+     * 
+     * @param src 指向输入封装器中AVStream的指针。
+     * @return int 成功添加流后返回对应的索引，失败返回-1。
+     */
+    virtual int addStream(const AVStream* src) = 0;
+
 
     /**
      * @brief 打开RTMP网络IO或者文件IO，并发送封装头信息。
@@ -64,12 +121,51 @@ public:
      * 
      * 该方法将编码后的音视频数据包推送到RTMP服务器，需要指定数据包和对应的流索引。
      * 
-     * @param pkt 指向AVPacket的指针，包含编码后的音视频数据包。
+     * @param pkt 指向AVPacket的指针，包含编码后的音视频数据包，时间戳以添加流时的编码器或输入流的时间基为单位。
+     * 异步写入模式下数据包的引用被移动到写入队列中，返回值只表示是否入队成功；写入线程出错后，
+     * 直到 close() 之前都返回 false，错误信息通过 getLastError() 获取。
+     * 
      * @param index 流的索引，用于标识音视频流。
      * @return bool 推流成功返回true，失败返回false。
      */
     virtual bool sendFrame(AVPacket* pkt, int index) = 0;
 
+    /**
+     * @brief 开启异步写入模式。
+     * 
+     * 需要在 sendHead() 成功之后调用。开启后 sendFrame() 只做时间戳转换并把数据包放入有界队列，
+     * 由独立的写入线程调用 av_interleaved_write_frame()，网络或磁盘变慢时不会直接阻塞编码线程。
+     * 队列中数据包的总字节数超过 max_queue_bytes 时按 policy 处理。close() 会先写完队列中剩余的数据包。
+     * 
+     * @param max_queue_bytes 队列的字节预算。
+     * @param policy 超出字节预算时的处理策略。
+     * @return bool 尚未发送封装头或已经开启时返回false。
+     */
+    virtual bool startAsync(int64_t max_queue_bytes = 8 * 1024 * 1024, OverflowPolicy policy = BlockProducer) = 0;
+
+    /**
+     * @brief 判断是否处于异步写入模式。
+     * 
+     * @return bool 异步写入模式返回true。
+     */
+    virtual bool isAsync() const = 0;
+
+    /**
+     * @brief 设置异步写入线程绑定的 CPU。
+     * 
+     * 需要在 startAsync() 之前调用。
+     * 
+     * @param cpus 逻辑 CPU 编号，为空表示不绑定。
+     */
+    virtual void setWriterAffinity(const std::vector<int>& cpus) = 0;
+
+    /**
+     * @brief 获取异步写入线程的统计信息。
+     * 
+     * @return WriterStats 写入延迟、队列深度和丢包统计。
+     */
+    virtual WriterStats getWriterStats() const = 0;
+
     /**
      * @brief 设置最后一次发生的错误信息。
      * 
@@ -1,12 +1,51 @@
+#include <algorithm>
 #include <iostream>
 #include <cstdint>
+#include <cstdlib>
 #include <ctime>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "Utils.h"
+#include "CpuTopology.h"
+#include "TaskScheduler.h"
+#include "CodecThreads.h"
+#include "FramePacer.h"
+#include "MetricsExporter.h"
+#include "EncoderMetrics.h"
 #include "FileVideoProvider.h"
 #include "XRtmp.h"
+#include "XFanout.h"
 #include "XMediaEncode.h"
+#include "Pipeline.h"
+#include "PacketPtr.h"
+#include "SessionManager.h"
+#include "SegmentTranscoder.h"
+
+
+/**
+ * @brief 创建从解码线程按时间戳取帧的数据源函数
+ * 
+ * 推流时由 FramePacer 休眠到帧到期再送出，写本地文件时不等待。时间戳超过120秒时数据源结束。
+ * @param video_provider 已启动的视频提供者
+ * @param is_local_file 是否写本地文件
+ * @return SourceStage<FramePtrWrapper>::Func 数据源函数，以第一帧送出的时刻作为开始时间
+ */
+static SourceStage<FramePtrWrapper>::Func make_frame_source(VideoProvider* video_provider, bool is_local_file)
+{
+    std::shared_ptr<FramePacer> pacer(is_local_file ? nullptr : new FramePacer());
+    return [video_provider, pacer](std::vector<FramePtrWrapper> &frames) -> bool {
+        FramePtrWrapper video_data_wraper;
+        if(!video_provider->popDue(video_data_wraper, pacer.get()))
+            return false;
+        // 如果视频时间戳超过120秒，结束数据源
+        if(video_data_wraper.getTimestamp() >= 120*1000000)
+            return false;
+        frames.push_back(std::move(video_data_wraper));
+        return true;
+    };
+}
 
 
 /**
@@ -22,32 +61,40 @@ int filevideo_to_flvfile()
     std::unique_ptr<VideoProvider> video_provider(new FileVideoProvider("720p60hz.mp4"));
     // 设置视频帧间隔
     video_provider->setFrameInterval(2);
+    // 解码线程输出引用计数的多平面帧，不再经过RGB24
+    video_provider->setOutputMode(VideoProvider::NativeFrame);
     // char outUrl[] = "0.mp4";
     // char outUrl[] = "rtsp://192.168.31.8:8554/live2";
     // 定义输出流的URL，这里是RTMP服务器地址
     char outUrl[] = "rtmp://192.168.31.8/live/stream1";
+    // 推流的同时录制到本地文件
+    char recordUrl[] = "record.mp4";
     // 标记是否为本地文件
     bool is_local_file = false;
 
-    // 初始化并启动视频解析线程
+    // 初始化视频解析
     video_provider->init();
+    // 解码线程直接缩放到输出尺寸（原视频的一半）并转换为编码器需要的YUV420P
+    video_provider->setOutputSize(video_provider->getSourceWidth() / 2, video_provider->getSourceHeight() / 2);
+    video_provider->setOutputPixelFormat(AV_PIX_FMT_YUV420P);
+    // 启动视频解析线程
     video_provider->start();
     
     // 视频缩放配置
-    // 获取视频编码实例
-    XMediaEncode* xe = XMediaEncode::getInstance();
+    // 创建独立的视频编码实例
+    std::unique_ptr<XMediaEncode> encoder(XMediaEncode::create());
+    XMediaEncode* xe = encoder.get();
     // 设置编码器的帧率为视频提供者的帧率
     xe->fps = video_provider->getFps();
     
-    // 设置编码器输入视频的高度
+    // 解码线程已经输出最终尺寸，编码器的输入输出尺寸相同，无需再缩放
     xe->inHeight = video_provider->getHeight();
-    // 设置编码器输出视频的高度为输入高度的一半
-    xe->outHeight = video_provider->getHeight() / 2;
-    // 设置编码器输入视频的宽度
+    xe->outHeight = video_provider->getHeight();
     xe->inWidth = video_provider->getWidth();
-    // 设置编码器输出视频的宽度为输入宽度的一半
-    xe->outWidth = video_provider->getWidth() / 2;
+    xe->outWidth = video_provider->getWidth();
     
+    // 压缩后每秒视频的比特位大小 200 kB
+    xe->bitrate = 200 * 1024 * 8;
     // 设置输入像素大小
     xe->inPixSize = 3;
 
@@ -65,17 +112,21 @@ int filevideo_to_flvfile()
     
 
     // 输出封装器和流配置
-    // a 创建输出封装器上下文
-    // 获取RTM实例
-    XRtmp* xr = XRtmp::getInstance(0);
-    // 初始化RTMP实例，传入输出URL（本地文件或者RTMP流）
-    if(!xr->init(outUrl)){
+    // 一次编码，数据包按引用分发给多路输出：推流的同时录制到本地文件
+    std::unique_ptr<XFanout> xr(XFanout::create());
+    // a 为每路输出创建封装器上下文（本地文件或者RTMP流），每路输出有独立的写入线程和队列：
+    // 推流超出字节预算时丢弃整个GOP，写本地文件时阻塞等待不丢数据
+    if(-1 == xr->addOutput(outUrl, 4 * 1024 * 1024, is_local_file ? XRtmp::BlockProducer : XRtmp::DropGop)){
         std::cerr << "init error:" << xr->getLastError() << std::endl;
         return -1;
     }
+    // 录制失败不影响推流，只输出错误信息。各输出在封装线程上依次入队，录制不能阻塞推流，
+    // 使用更大的字节预算吸收磁盘写入的抖动，磁盘持续跟不上时才丢弃整个GOP
+    if(!is_local_file && -1 == xr->addOutput(recordUrl, 64 * 1024 * 1024, XRtmp::DropGop))
+        std::cerr << "init record error:" << xr->getLastError() << std::endl;
     // b 添加视频流
     int video_stream_index = -1;
-    // 向RTMP实例添加视频流
+    // 向所有输出添加视频流
     video_stream_index = xr->addStream(xe->vc);
     if(-1 == video_stream_index) {
         std::cerr << "addStream error:" << xr->getLastError() << std::endl;
@@ -83,82 +134,370 @@ int filevideo_to_flvfile()
     }
         
     // 打开rtmp 的网络输出IO
-    // 写入封装头
+    // 写入封装头，打开失败的输出被停用
     if(!xr->sendHead()){
         std::cerr << "sendHead error:" << xr->getLastError() << std::endl;
         return -1;
     }
     std::cout << "b1" << std::endl;
-    int ret = 0;
-    int64_t video_timestamp = 0;
-    try
-    {
-        // 获取当前时间作为开始时间
-        int64_t begintime = Utils::get_curtime();
-        
-        // 当视频提供者正在运行时，循环处理视频帧
-        while(video_provider->isRunning())
-        {
-            // 获取视频帧数据包装器
-            auto video_data_wraper = video_provider->top();
-            // 获取视频帧数据大小
-            int video_data_size = video_data_wraper.getByteSize();
-            // 获取视频帧时间戳
-            int64_t tmp_video_timestemp = video_data_wraper.getTimestamp();
-  
-            // 计算当前时间与开始时间的差值
-            int64_t curTime = Utils::get_curtime() - begintime;
-            // 判断是否需要推送视频帧
-            bool is_push = is_local_file || tmp_video_timestemp <= curTime;
-            if(0 != video_data_size && is_push)
-            {
-                // 移除当前视频帧
-                video_provider->pop();
-                // 获取视频帧数据指针
-                char* video_data = (char*)video_data_wraper.getDataPtr();
-                // 更新视频时间戳
-                video_timestamp = video_data_wraper.getTimestamp();
-
-                // 将RGB格式的视频数据转换为YUV格式
-                AVFrame* yuv = xe->rgb2yuv(video_data);
-                if(!yuv) {
-                    std::cout << "rgb2yuv error" << std::endl;
-                    continue;
-                }
-                // 对YUV格式的视频帧进行编码
-                AVPacket* pkt = xe->encodeVideo(yuv, video_timestamp);
-                if(!pkt) {
-                    std::cout << "encode video error" << std::endl;
-                    continue;
-                }
-                    
-                // 推流
-                std::cout << "video_timestamp:" << video_timestamp << std::endl;
-                // 如果视频时间戳超过120秒，退出循环
-                if(video_timestamp >= 120*1000000) {
-                    break;
-                }
-                // 发送编码后的视频帧到RTMP服务器
-                bool rer_val = xr->sendFrame(pkt, video_stream_index);
-                if(rer_val)
-                    std::cout << "@V@" << std::endl;
-                
+
+    // 解码、编码、封装各自运行在独立的线程上，阶段之间通过有界队列连接，
+    // 整体吞吐量取决于最慢的阶段。编码器和封装器不是线程安全的，对应阶段只使用一个线程。
+    auto decoded_frames = std::make_shared<BlockingQueue<FramePtrWrapper>>(4);
+    auto encoded_packets = std::make_shared<BlockingQueue<PacketPtr>>(16);
+    Pipeline pipeline;
+    // 按时间戳从解码线程取帧，推流时等到帧到期再送入流水线
+    pipeline.addStage(std::unique_ptr<PipelineStage>(new SourceStage<FramePtrWrapper>(
+        "decode", decoded_frames, make_frame_source(video_provider.get(), is_local_file))));
+
+    // 将视频帧转换为编码器需要的YUV格式并编码，取出编码器已经输出的全部数据包。
+    // 颜色空间转换使用编码器的缩放上下文和输出帧，与编码在同一个线程上执行
+    std::vector<AVPacket*> packets;
+    auto wrap_packets = [&](std::vector<PacketPtr> &out) {
+        for(AVPacket* pkt : packets)
+            out.emplace_back(pkt);
+        packets.clear();
+    };
+    auto encode_stage = new TransformStage<FramePtrWrapper, PacketPtr>(
+        "encode", decoded_frames, encoded_packets,
+        [&](FramePtrWrapper &frame, std::vector<PacketPtr> &out) -> bool {
+            AVFrame* yuv = xe->toYuv(frame);
+            if(!yuv) {
+                std::cout << "toYuv error:" << xe->getLastError() << std::endl;
+                return false;
             }
+            bool ok = xe->encodeVideo(yuv, frame.getTimestamp(), packets);
+            wrap_packets(out);
+            if(!ok)
+                std::cout << "encode video error:" << xe->getLastError() << std::endl;
+            return ok;
+        });
+    // 冲刷编码器，发送缓存在编码器内部的最后几帧
+    encode_stage->setFlushFunction([&](std::vector<PacketPtr> &out) -> bool {
+        bool ok = xe->flushVideo(packets);
+        wrap_packets(out);
+        if(!ok)
+            std::cerr << "flushVideo error:" << xe->getLastError() << std::endl;
+        return ok;
+    });
+    pipeline.addStage(std::unique_ptr<PipelineStage>(encode_stage));
 
-        }
-    }
-    // 捕获异常并输出错误信息
-    catch(std::exception& ex)
-    {
-        std::cerr << ex.what() << std::endl;
+    // 发送编码后的视频帧到RTMP服务器或写入文件
+    pipeline.addStage(std::unique_ptr<PipelineStage>(new SinkStage<PacketPtr>(
+        "mux", encoded_packets,
+        [&](PacketPtr &pkt) -> bool {
+            // 热路径上不输出日志，写入统计通过指标导出
+            return xr->sendFrame(pkt.get(), video_stream_index);
+        })));
+
+    if(!pipeline.start()) {
+        std::cerr << "pipeline start error" << std::endl;
+        return -1;
     }
+    // 导出各环节的耗时、队列深度和丢帧统计
+    int metrics_id = MetricsRegistry::instance().addCollector([&](MetricsWriter& writer) {
+        MetricsWriter::Labels labels = {{"stream", "main"}};
+        video_provider->collectMetrics(writer, labels);
+        pipeline.collectMetrics(writer, labels);
+        EncoderMetrics::collectEncoder(writer, labels, *xe);
+        for(int i = 0; i < xr->getOutputCount(); ++i)
+            EncoderMetrics::collectWriter(writer, {{"stream", "main"}, {"output", xr->getOutputUrl(i)}}, xr->getOutputStats(i));
+    });
+    // 等待数据源结束且所有帧都已编码并发送
+    pipeline.wait();
+    MetricsRegistry::instance().removeCollector(metrics_id);
+    pipeline.printStats(std::cout);
 
+    // 输出解码队列的丢帧和阻塞统计
+    auto queue_stats = video_provider->getQueueStats();
+    std::cout << "decoded frames:" << queue_stats.pushed_frames
+              << " dropped frames:" << queue_stats.dropped_frames
+              << " decoder stall(us):" << queue_stats.stall_time_us << std::endl;
+    std::cout << "encoder latency(us):" << xe->getLastLatency() << std::endl;
     // 停止视频解析线程
     video_provider->stop();
     // 关闭视频编码器
     xe->close();
-    // 关闭RTMP实例
+    // 关闭所有输出，写完队列中剩余的数据包
     xr->close();
+    // 输出每路输出写入线程的延迟和丢包统计
+    for(int i = 0; i < xr->getOutputCount(); ++i) {
+        auto writer_stats = xr->getOutputStats(i);
+        std::cout << "output:" << xr->getOutputUrl(i)
+                  << " active:" << xr->isOutputActive(i)
+                  << " written packets:" << writer_stats.written_packets
+                  << " dropped packets:" << writer_stats.dropped_packets
+                  << " dropped gops:" << writer_stats.dropped_gops
+                  << " write errors:" << writer_stats.write_errors
+                  << " max write latency(us):" << writer_stats.max_write_latency_us
+                  << " peak queue bytes:" << writer_stats.peak_queue_bytes << std::endl;
+        if(!xr->isOutputActive(i))
+            std::cout << "output error:" << xr->getOutputError(i) << std::endl;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief 码率阶梯中的一路输出
+ */
+struct Rendition
+{
+    const char* name; ///< 名称，用于阶段名和日志
+    int height;       ///< 输出高度，宽度按视频源的宽高比计算
+    int bitrate;      ///< 码率（bps）
+    const char* url;  ///< 输出地址
+};
+
+/**
+ * @brief 一次解码，同时编码多路不同分辨率和码率的输出（自适应码率阶梯）
+ * 
+ * 解码线程以原始尺寸输出帧，分发阶段把每一帧的引用交给各路分支，
+ * 每路分支在自己的线程中从共享的解码帧缩放并编码，再由各自的封装器写出。
+ * 
+ * @return int 函数执行结果，0表示成功，负数表示失败
+ */
+int filevideo_to_abr_ladder()
+{
+    std::unique_ptr<VideoProvider> video_provider(new FileVideoProvider("720p60hz.mp4"));
+    video_provider->setFrameInterval(2);
+    video_provider->setOutputMode(VideoProvider::NativeFrame);
+    // 标记是否为本地文件
+    bool is_local_file = false;
+    const Rendition ladder[] = {
+        {"1080p", 1080, 5000000, "rtmp://192.168.31.8/live/stream_1080p"},
+        {"720p", 720, 2500000, "rtmp://192.168.31.8/live/stream_720p"},
+        {"360p", 360, 800000, "rtmp://192.168.31.8/live/stream_360p"},
+    };
+    const int rendition_count = sizeof(ladder) / sizeof(ladder[0]);
+
+    // 初始化视频解析，只解码一次并以原始尺寸输出YUV420P，各路分支共享解码帧
+    if(!video_provider->init()) {
+        std::cerr << "video provider init error" << std::endl;
+        return -1;
+    }
+    video_provider->setOutputPixelFormat(AV_PIX_FMT_YUV420P);
+    const int src_width = video_provider->getWidth();
+    const int src_height = video_provider->getHeight();
+
+    std::vector<std::unique_ptr<XMediaEncode>> encoders;
+    std::vector<std::unique_ptr<XRtmp>> muxers;
+    std::vector<int> stream_indexes;
+    std::vector<const Rendition*> renditions;
+    // 各档位的编码器同时运行，平分解码器之外的编解码线程配额，避免先打开的档位占满配额
+    const int encoder_threads = std::max(1, (TaskScheduler::instance().getCodecThreadBudget()
+                                             - CodecThreads::default_decoder_threads()) / rendition_count);
+    for(int i = 0; i < rendition_count; ++i)
+    {
+        const Rendition& r = ladder[i];
+        // 不放大：高于视频源的档位跳过
+        if(r.height > src_height)
+        {
+            std::cout << "skip rendition " << r.name << ", source height:" << src_height << std::endl;
+            continue;
+        }
+        std::unique_ptr<XMediaEncode> encoder(XMediaEncode::create());
+        XMediaEncode* xe = encoder.get();
+        xe->fps = video_provider->getFps();
+        xe->inWidth = src_width;
+        xe->inHeight = src_height;
+        // 宽高取偶数以适配YUV420
+        xe->outHeight = r.height & ~1;
+        xe->outWidth = (int)((int64_t)src_width * r.height / src_height) & ~1;
+        xe->bitrate = r.bitrate;
+        xe->inPixSize = 3;
+        xe->codecThreads = encoder_threads;
+        if(!xe->initScale() || !xe->initVideoCodec()) {
+            std::cerr << r.name << " encoder error:" << xe->getLastError() << std::endl;
+            return -1;
+        }
+
+        // 每路输出使用独立的异步封装器，一路网络变慢不影响其他档位
+        std::unique_ptr<XRtmp> xr(XRtmp::create());
+        int stream_index = -1;
+        if(!xr->init(r.url) || -1 == (stream_index = xr->addStream(xe->vc)) || !xr->sendHead()
+           || !xr->startAsync(4 * 1024 * 1024, is_local_file ? XRtmp::BlockProducer : XRtmp::DropGop)) {
+            std::cerr << r.name << " muxer error:" << xr->getLastError() << std::endl;
+            return -1;
+        }
+        encoders.push_back(std::move(encoder));
+        muxers.push_back(std::move(xr));
+        stream_indexes.push_back(stream_index);
+        renditions.push_back(&r);
+    }
+    if(encoders.empty()) {
+        std::cerr << "no rendition to encode" << std::endl;
+        return -1;
+    }
+    // 启动视频解析线程
+    video_provider->start();
+
+    Pipeline pipeline;
+    auto decoded_frames = std::make_shared<BlockingQueue<FramePtrWrapper>>(4);
+    std::vector<std::shared_ptr<BlockingQueue<FramePtrWrapper>>> branch_frames;
+    for(size_t i = 0; i < encoders.size(); ++i)
+        branch_frames.push_back(std::make_shared<BlockingQueue<FramePtrWrapper>>(4));
+
+    pipeline.addStage(std::unique_ptr<PipelineStage>(new SourceStage<FramePtrWrapper>(
+        "decode", decoded_frames, make_frame_source(video_provider.get(), is_local_file))));
+    // 每一帧只增加引用计数分发给各路分支
+    pipeline.addStage(std::unique_ptr<PipelineStage>(new BroadcastStage<FramePtrWrapper>(
+        "broadcast", decoded_frames, branch_frames)));
+
+    for(size_t i = 0; i < encoders.size(); ++i)
+    {
+        XMediaEncode* xe = encoders[i].get();
+        XRtmp* xr = muxers[i].get();
+        const int stream_index = stream_indexes[i];
+        const std::string name = renditions[i]->name;
+        auto packets = std::make_shared<BlockingQueue<PacketPtr>>(16);
+
+        // 缩放和编码在同一个线程中完成，各档位之间并行
+        auto encode_stage = new TransformStage<FramePtrWrapper, PacketPtr>(
+            "encode_" + name, branch_frames[i], packets,
+            [xe](FramePtrWrapper &frame, std::vector<PacketPtr> &out) -> bool {
+                AVFrame* yuv = xe->toYuv(frame);
+                if(!yuv)
+                    return false;
+                std::vector<AVPacket*> encoded;
+                bool ok = xe->encodeVideo(yuv, frame.getTimestamp(), encoded);
+                // 出错前已经取出的数据包同样交给输出队列，由 PacketPtr 释放
+                for(AVPacket* pkt : encoded)
+                    out.emplace_back(pkt);
+                return ok;
+            });
+        encode_stage->setFlushFunction([xe](std::vector<PacketPtr> &out) -> bool {
+            std::vector<AVPacket*> encoded;
+            bool ok = xe->flushVideo(encoded);
+            for(AVPacket* pkt : encoded)
+                out.emplace_back(pkt);
+            return ok;
+        });
+        pipeline.addStage(std::unique_ptr<PipelineStage>(encode_stage));
+        pipeline.addStage(std::unique_ptr<PipelineStage>(new SinkStage<PacketPtr>(
+            "mux_" + name, packets,
+            [xr, stream_index](PacketPtr &pkt) -> bool {
+                return xr->sendFrame(pkt.get(), stream_index);
+            })));
+    }
+
+    if(!pipeline.start()) {
+        std::cerr << "pipeline start error" << std::endl;
+        return -1;
+    }
+    int metrics_id = MetricsRegistry::instance().addCollector([&](MetricsWriter& writer) {
+        MetricsWriter::Labels labels = {{"stream", "ladder"}};
+        video_provider->collectMetrics(writer, labels);
+        pipeline.collectMetrics(writer, labels);
+        for(size_t i = 0; i < encoders.size(); ++i)
+        {
+            MetricsWriter::Labels rendition_labels = {{"stream", "ladder"}, {"rendition", renditions[i]->name}};
+            EncoderMetrics::collectEncoder(writer, rendition_labels, *encoders[i]);
+            EncoderMetrics::collectWriter(writer, rendition_labels, muxers[i]->getWriterStats());
+        }
+    });
+    // 等待数据源结束且所有档位都已编码并发送
+    pipeline.wait();
+    MetricsRegistry::instance().removeCollector(metrics_id);
+    pipeline.printStats(std::cout);
+
+    video_provider->stop();
+    for(size_t i = 0; i < encoders.size(); ++i)
+    {
+        encoders[i]->close();
+        muxers[i]->close();
+        auto writer_stats = muxers[i]->getWriterStats();
+        std::cout << "rendition:" << renditions[i]->name
+                  << " size:" << encoders[i]->outWidth << "x" << encoders[i]->outHeight
+                  << " written packets:" << writer_stats.written_packets
+                  << " dropped packets:" << writer_stats.dropped_packets
+                  << " max write latency(us):" << writer_stats.max_write_latency_us << std::endl;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief 在同一进程中运行多路转推会话
+ * 
+ * 每路会话独立拥有视频提供者、编码器和封装器，运行时可以增加和删除。
+ * 每秒输出一次各会话的统计，所有会话结束后返回。
+ * 
+ * @param session_count 会话数
+ * @return int 函数执行结果，0表示成功，负数表示失败
+ */
+int run_session_server(int session_count)
+{
+    const CpuTopology::Topology& topo = CpuTopology::get();
+    std::cout << "usable cpus:" << topo.usable_cpus
+              << " logical cpus:" << topo.cpus.size()
+              << " physical cores:" << topo.physical_cores
+              << " numa nodes:" << topo.nodes.size()
+              << " cgroup quota:" << topo.cpu_quota << std::endl;
+
+    SessionManager manager(session_count);
+    // 多个 NUMA 节点时每路会话固定在一个节点上
+    manager.setNumaBalancing(topo.nodes.size() > 1);
+    for(int i = 0; i < session_count; ++i)
+    {
+        StreamSession::Config config;
+        config.input_url = "720p60hz.mp4";
+        config.output_url = "rtmp://192.168.31.8/live/session" + std::to_string(i);
+        config.frame_interval = 2;
+        config.bitrate = 1000000;
+        if(!manager.addSession("session" + std::to_string(i), config))
+            std::cerr << "addSession error:" << manager.getLastError() << std::endl;
+    }
+    if(0 == manager.getSessionCount())
+        return -1;
+
+    while(manager.getSessionCount() > 0)
+    {
+        av_usleep(1000000);
+        for(const std::string& id : manager.getSessionIds())
+        {
+            StreamSession::Stats stats;
+            if(!manager.getSessionStats(id, stats))
+                continue;
+            std::cout << "session:" << id
+                      << " state:" << stats.state
+                      << " passthrough:" << stats.passthrough
+                      << " encoded frames:" << stats.encoded_frames
+                      << " late frames:" << stats.late_frames
+                      << " written packets:" << stats.written_packets
+                      << " dropped packets:" << stats.dropped_packets << std::endl;
+        }
+        // 输入结束的会话写完封装尾后删除
+        manager.removeFinishedSessions();
+    }
+    return 0;
+}
+
+
+/**
+ * @brief 分段并行转码一个本地文件
+ * 
+ * 在关键帧处把输入分成多段，各段在各自的一组 CPU 上同时转码，完成后拼接成一个输出文件。
+ * 
+ * @param input 输入的本地文件
+ * @param output 输出文件
+ * @param segments 分段数，0表示按CPU数自动选择
+ * @return int 函数执行结果，0表示成功，负数表示失败
+ */
+int run_segment_transcode(const char* input, const char* output, int segments)
+{
+    SegmentTranscoder::Config config;
+    config.input_url = input;
+    config.output_url = output;
+    config.segments = segments;
+    config.bitrate = 2000000;
+    config.preset = "veryfast";
+    SegmentTranscoder transcoder(config);
+    if(!transcoder.run())
+    {
+        std::cerr << "segment transcode error:" << transcoder.getLastError() << std::endl;
+        return -1;
+    }
     return 0;
 }
 
@@ -168,7 +507,24 @@ int main(int argc, char* argv[])
 {
     
     std::cout << "begin--------" << std::endl;
-    filevideo_to_flvfile();
+    // 指标每5秒写入一次文件，可以配合 node_exporter 的 textfile collector 抓取
+    MetricsExporter exporter;
+    exporter.startFile("metrics.prom", 5000);
+    // 参数为 ladder 时一次解码输出多档分辨率，为 server [会话数] 时运行多路会话，
+    // 为 segment <输入> <输出> [段数] 时分段并行转码本地文件，否则输出单路
+    if(argc > 1 && std::string(argv[1]) == "ladder")
+        filevideo_to_abr_ladder();
+    else if(argc > 1 && std::string(argv[1]) == "server")
+    {
+        // 多路会话时同时提供 HTTP 抓取接口
+        if(!exporter.startHttp(9464))
+            std::cerr << "metrics http error:" << exporter.getLastError() << std::endl;
+        run_session_server(argc > 2 ? atoi(argv[2]) : 4);
+    }
+    else if(argc > 3 && std::string(argv[1]) == "segment")
+        return run_segment_transcode(argv[2], argv[3], argc > 4 ? atoi(argv[4]) : 0) == 0 ? 0 : 1;
+    else
+        filevideo_to_flvfile();
     return 0;
 }
 
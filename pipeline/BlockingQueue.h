@@ -0,0 +1,202 @@
+#ifndef BLOCKINGQUEUE_H
+#define BLOCKINGQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+/**
+ * @class BlockingQueue
+ * @brief 流水线各阶段之间传递数据的有界队列，支持多个生产者和多个消费者。
+ *
+ * 与 ThreadProvider 的数据队列类似，队列满时按背压策略阻塞生产者或丢弃最早的元素。
+ * 生产者全部结束后调用 close()，消费者取完剩余元素后 pop() 返回 false，以此把“数据结束”沿流水线向下传递；
+ * abort() 会同时丢弃队列中的元素并唤醒所有等待者，用于提前停止整条流水线。
+ *
+ * @tparam T 元素类型，需要支持移动
+ */
+template <typename T>
+class BlockingQueue
+{
+public:
+    /**
+     * @brief 队列满时的背压策略
+     */
+    enum OverflowPolicy
+    {
+        BlockProducer = 0, ///< 阻塞生产者直到有空位，不丢数据
+        DropOldest,        ///< 丢弃队首的元素，保证延迟有界
+    };
+
+    /**
+     * @brief 队列统计信息
+     */
+    struct Stats
+    {
+        int64_t pushed = 0;        ///< 入队元素数
+        int64_t dropped = 0;       ///< 丢弃的元素数
+        int64_t push_wait_us = 0;  ///< 生产者等待空位的累计时间（微秒）
+        int64_t pop_wait_us = 0;   ///< 消费者等待数据的累计时间（微秒）
+        int size = 0;              ///< 当前队列长度
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * @param capacity 队列最大长度，小于 1 时按 1 处理
+     * @param policy 队列满时的背压策略
+     */
+    explicit BlockingQueue(int capacity = 8, OverflowPolicy policy = BlockProducer)
+        : capacity(capacity < 1 ? 1 : capacity), policy(policy)
+    {
+    }
+
+    BlockingQueue(const BlockingQueue &) = delete;
+    BlockingQueue &operator=(const BlockingQueue &) = delete;
+
+    /**
+     * @brief 入队一个元素
+     *
+     * @param value 要入队的元素，成功时被移动走
+     * @return bool 队列已关闭返回 false
+     */
+    bool push(T &&value)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if ((int)items.size() >= capacity && !is_closed)
+        {
+            if (DropOldest == policy)
+            {
+                items.pop_front();
+                ++dropped;
+            }
+            else
+            {
+                auto begin = std::chrono::steady_clock::now();
+                not_full.wait(lock, [this]() { return (int)items.size() < capacity || is_closed; });
+                push_wait_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now() - begin).count();
+            }
+        }
+        if (is_closed)
+            return false;
+        items.push_back(std::move(value));
+        ++pushed;
+        lock.unlock();
+        not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 出队一个元素，队列为空时阻塞等待
+     *
+     * @param value 输出参数，接收队首元素
+     * @return bool 成功取出返回 true，队列已关闭且为空时返回 false
+     */
+    bool pop(T &value)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.empty() && !is_closed)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            not_empty.wait(lock, [this]() { return !items.empty() || is_closed; });
+            pop_wait_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - begin).count();
+        }
+        if (items.empty())
+            return false;
+        value = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        not_full.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 关闭队列，之后的 push() 失败，消费者取完剩余元素后 pop() 返回 false
+     */
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            is_closed = true;
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    /**
+     * @brief 关闭队列并丢弃其中的元素
+     */
+    void abort()
+    {
+        std::deque<T> discarded;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            is_closed = true;
+            dropped += (int64_t)items.size();
+            discarded.swap(items);
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    /**
+     * @brief 判断队列是否已关闭
+     */
+    bool isClosed() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return is_closed;
+    }
+
+    /**
+     * @brief 获取当前队列长度
+     */
+    int size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (int)items.size();
+    }
+
+    /**
+     * @brief 获取队列最大长度
+     */
+    int getCapacity() const
+    {
+        return capacity;
+    }
+
+    /**
+     * @brief 获取队列的统计信息
+     */
+    Stats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats stats;
+        stats.pushed = pushed;
+        stats.dropped = dropped;
+        stats.push_wait_us = push_wait_us;
+        stats.pop_wait_us = pop_wait_us;
+        stats.size = (int)items.size();
+        return stats;
+    }
+
+private:
+    const int capacity;
+    const OverflowPolicy policy;
+    std::deque<T> items;
+    mutable std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    bool is_closed = false;
+    int64_t pushed = 0;
+    int64_t dropped = 0;
+    int64_t push_wait_us = 0;
+    int64_t pop_wait_us = 0;
+};
+
+#endif // BLOCKINGQUEUE_H
@@ -0,0 +1,27 @@
+#ifndef PACKETPTR_H
+#define PACKETPTR_H
+
+#include <memory>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * @brief 释放 AVPacket 的删除器
+ */
+struct AVPacketDeleter
+{
+    void operator()(AVPacket *pkt) const
+    {
+        av_packet_free(&pkt);
+    }
+};
+
+/**
+ * @brief 独占所有权的 AVPacket 指针，用于在流水线阶段之间传递编码后的数据包
+ */
+typedef std::unique_ptr<AVPacket, AVPacketDeleter> PacketPtr;
+
+#endif // PACKETPTR_H
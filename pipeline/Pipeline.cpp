@@ -0,0 +1,101 @@
+#include "Pipeline.h"
+
+#include <ostream>
+
+Pipeline::~Pipeline()
+{
+    stop();
+}
+
+PipelineStage *Pipeline::addStage(std::unique_ptr<PipelineStage> stage)
+{
+    stages.push_back(std::move(stage));
+    return stages.back().get();
+}
+
+bool Pipeline::start()
+{
+    // 先启动消费者，数据源产生的第一个数据就能被立即处理
+    for (auto it = stages.rbegin(); it != stages.rend(); ++it)
+    {
+        if (!(*it)->start())
+        {
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void Pipeline::wait()
+{
+    // 数据结束标志沿队列向下游传递，按数据流动方向依次等待即可
+    for (auto &stage : stages)
+        stage->join();
+}
+
+void Pipeline::stop()
+{
+    for (auto &stage : stages)
+        stage->stop();
+}
+
+bool Pipeline::isRunning() const
+{
+    for (auto &stage : stages)
+    {
+        if (stage->isRunning())
+            return true;
+    }
+    return false;
+}
+
+int Pipeline::getStageCount() const
+{
+    return (int)stages.size();
+}
+
+PipelineStage *Pipeline::getStage(int index) const
+{
+    if (index < 0 || index >= (int)stages.size())
+        return nullptr;
+    return stages[index].get();
+}
+
+void Pipeline::printStats(std::ostream &os) const
+{
+    for (auto &stage : stages)
+    {
+        PipelineStage::Stats stats = stage->getStats();
+        os << "stage:" << stage->getName()
+           << " threads:" << stage->getThreadCount()
+           << " processed:" << stats.processed
+           << " errors:" << stats.errors
+           << " busy(us):" << stats.busy_time_us
+           << " cpu(us):" << stats.cpu_time_us;
+        LatencyHistogram::Snapshot latency = stage->getLatency();
+        os << " p50(us):" << latency.percentile(0.5)
+           << " p99(us):" << latency.percentile(0.99)
+           << " max(us):" << latency.max_us << std::endl;
+    }
+}
+
+void Pipeline::collectMetrics(MetricsWriter &writer, const MetricsWriter::Labels &labels) const
+{
+    for (auto &stage : stages)
+    {
+        MetricsWriter::Labels stage_labels = labels;
+        stage_labels.emplace_back("stage", stage->getName());
+        PipelineStage::Stats stats = stage->getStats();
+        writer.counter("video_pipeline_processed_total", "Items processed by a pipeline stage.", stage_labels,
+                       (double)stats.processed);
+        writer.counter("video_pipeline_errors_total", "Items a pipeline stage failed to process.", stage_labels,
+                       (double)stats.errors);
+        writer.histogram("video_pipeline_stage_latency_seconds", "Time a pipeline stage spent on each item.",
+                         stage_labels, stage->getLatency());
+        int depth = stage->getInputQueueDepth();
+        if (depth >= 0)
+            writer.gauge("video_pipeline_queue_depth", "Items waiting in the input queue of a pipeline stage.",
+                         stage_labels, depth);
+    }
+}
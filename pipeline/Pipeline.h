@@ -0,0 +1,90 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+#include "PipelineStage.h"
+#include "MetricsRegistry.h"
+
+/**
+ * @class Pipeline
+ * @brief 由若干阶段组成的流水线，负责按顺序启动、等待和停止各阶段。
+ *
+ * 各阶段并行运行，整体吞吐量取决于最慢的阶段，而不是各阶段耗时之和。
+ * 阶段按数据流动的方向添加（数据源在前，终点在后）。
+ */
+class Pipeline
+{
+public:
+    Pipeline() = default;
+
+    /**
+     * @brief 析构函数，停止所有仍在运行的阶段
+     */
+    ~Pipeline();
+
+    Pipeline(const Pipeline &) = delete;
+    Pipeline &operator=(const Pipeline &) = delete;
+
+    /**
+     * @brief 添加一个阶段，流水线接管其所有权
+     *
+     * @param stage 阶段对象
+     * @return PipelineStage* 添加的阶段
+     */
+    PipelineStage *addStage(std::unique_ptr<PipelineStage> stage);
+
+    /**
+     * @brief 启动所有阶段，下游阶段先于上游阶段启动
+     *
+     * @return bool 任一阶段启动失败时停止已启动的阶段并返回 false
+     */
+    bool start();
+
+    /**
+     * @brief 等待数据源结束且所有数据流过全部阶段
+     */
+    void wait();
+
+    /**
+     * @brief 提前停止所有阶段，队列中未处理的数据被丢弃
+     */
+    void stop();
+
+    /**
+     * @brief 判断是否还有阶段在运行
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 获取阶段个数
+     */
+    int getStageCount() const;
+
+    /**
+     * @brief 获取指定序号的阶段
+     */
+    PipelineStage *getStage(int index) const;
+
+    /**
+     * @brief 输出每个阶段的处理个数、失败次数、忙碌时间和耗时分位数
+     *
+     * @param os 输出流
+     */
+    void printStats(std::ostream &os) const;
+
+    /**
+     * @brief 把每个阶段的处理个数、失败次数、耗时直方图和输入队列深度写入指标
+     *
+     * @param writer 指标输出
+     * @param labels 附加在每个样本上的标签，例如流名称
+     */
+    void collectMetrics(MetricsWriter &writer, const MetricsWriter::Labels &labels) const;
+
+private:
+    std::vector<std::unique_ptr<PipelineStage>> stages;
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,98 @@
+#include "PipelineStage.h"
+#include "CpuTopology.h"
+#include "Utils.h"
+
+PipelineStage::PipelineStage(const std::string &name, int thread_count)
+    : name(name), thread_count(thread_count < 1 ? 1 : thread_count)
+{
+}
+
+PipelineStage::~PipelineStage()
+{
+    join();
+}
+
+bool PipelineStage::start()
+{
+    if (!threads.empty())
+        return false;
+    is_exit = false;
+    active_workers = thread_count;
+    for (int i = 0; i < thread_count; ++i)
+        threads.emplace_back(&PipelineStage::workerMain, this, i);
+    return true;
+}
+
+void PipelineStage::stop()
+{
+    is_exit = true;
+    abortQueues();
+    join();
+}
+
+void PipelineStage::join()
+{
+    for (auto &t : threads)
+    {
+        if (t.joinable())
+            t.join();
+    }
+    threads.clear();
+}
+
+bool PipelineStage::isRunning() const
+{
+    return active_workers > 0;
+}
+
+const std::string &PipelineStage::getName() const
+{
+    return name;
+}
+
+int PipelineStage::getThreadCount() const
+{
+    return thread_count;
+}
+
+PipelineStage::Stats PipelineStage::getStats() const
+{
+    Stats stats;
+    stats.processed = processed;
+    stats.errors = errors;
+    stats.busy_time_us = busy_time_us;
+    stats.cpu_time_us = cpu_time_us;
+    return stats;
+}
+
+void PipelineStage::setCpuAffinity(const std::vector<int> &cpus)
+{
+    cpu_affinity = cpus;
+}
+
+LatencyHistogram::Snapshot PipelineStage::getLatency() const
+{
+    return latency.snapshot();
+}
+
+void PipelineStage::recordItem(std::chrono::steady_clock::time_point begin, bool ok)
+{
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - begin).count();
+    busy_time_us += elapsed;
+    latency.observe(elapsed);
+    if (ok)
+        ++processed;
+    else
+        ++errors;
+}
+
+void PipelineStage::workerMain(int worker_index)
+{
+    CpuTopology::pin_current_thread(cpu_affinity);
+    run(worker_index);
+    cpu_time_us += Utils::thread_cpu_time_us();
+    // 最后一个退出的工作线程负责收尾，此时其他工作线程的结果都已交付
+    if (0 == --active_workers)
+        onFinished();
+}
@@ -0,0 +1,497 @@
+#ifndef PIPELINESTAGE_H
+#define PIPELINESTAGE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BlockingQueue.h"
+#include "LatencyHistogram.h"
+
+/**
+ * @class PipelineStage
+ * @brief 流水线中的一个阶段，拥有一个或多个工作线程。
+ *
+ * 与 ThreadProvider 类似，派生类在 run() 中实现线程逻辑；不同的是阶段之间通过有类型的 BlockingQueue 连接，
+ * 上游阶段的输出队列就是下游阶段的输入队列。最后一个工作线程退出时调用 onFinished()，
+ * 派生类在其中关闭输出队列，把“数据结束”传递给下游。
+ */
+class PipelineStage
+{
+public:
+    /**
+     * @brief 阶段的统计信息
+     */
+    struct Stats
+    {
+        int64_t processed = 0;    ///< 处理的数据个数
+        int64_t errors = 0;       ///< 处理函数返回失败的次数
+        int64_t busy_time_us = 0; ///< 所有工作线程执行处理函数的累计时间（微秒）
+        int64_t cpu_time_us = 0;  ///< 已退出的工作线程使用的 CPU 时间（微秒），包括等待队列以外的全部开销
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * @param name 阶段名称，用于输出统计信息
+     * @param thread_count 工作线程数，小于 1 时按 1 处理
+     */
+    PipelineStage(const std::string &name, int thread_count = 1);
+
+    /**
+     * @brief 析构函数，派生类需要在自己的析构函数中调用 stop()
+     */
+    virtual ~PipelineStage();
+
+    PipelineStage(const PipelineStage &) = delete;
+    PipelineStage &operator=(const PipelineStage &) = delete;
+
+    /**
+     * @brief 启动全部工作线程
+     *
+     * @return bool 已经在运行时返回 false
+     */
+    bool start();
+
+    /**
+     * @brief 请求提前停止：中止输入输出队列并等待工作线程退出，队列中未处理的数据被丢弃
+     */
+    void stop();
+
+    /**
+     * @brief 等待全部工作线程处理完输入队列中的数据后退出
+     */
+    void join();
+
+    /**
+     * @brief 判断是否还有工作线程在运行
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 获取阶段名称
+     */
+    const std::string &getName() const;
+
+    /**
+     * @brief 获取工作线程数
+     */
+    int getThreadCount() const;
+
+    /**
+     * @brief 获取阶段的统计信息
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief 设置工作线程绑定的 CPU，需要在 start() 前调用
+     *
+     * @param cpus 逻辑 CPU 编号，为空表示不绑定
+     */
+    void setCpuAffinity(const std::vector<int> &cpus);
+
+    /**
+     * @brief 获取处理函数每次执行耗时的直方图
+     */
+    LatencyHistogram::Snapshot getLatency() const;
+
+    /**
+     * @brief 获取输入队列中等待处理的数据个数，没有输入队列（数据源）时返回 -1
+     */
+    virtual int getInputQueueDepth() const { return -1; }
+
+protected:
+    /**
+     * @brief 工作线程执行的核心函数，派生类必须实现
+     *
+     * @param worker_index 工作线程序号，从 0 开始
+     */
+    virtual void run(int worker_index) = 0;
+
+    /**
+     * @brief 中止该阶段的输入输出队列，唤醒阻塞在队列上的工作线程
+     */
+    virtual void abortQueues() = 0;
+
+    /**
+     * @brief 最后一个工作线程退出前调用，派生类在其中冲刷剩余数据并关闭输出队列
+     */
+    virtual void onFinished() {}
+
+    /**
+     * @brief 记录一次处理函数的执行结果
+     *
+     * @param begin 处理开始的时间点
+     * @param ok 处理是否成功
+     */
+    void recordItem(std::chrono::steady_clock::time_point begin, bool ok);
+
+    /**
+     * @brief 判断是否已经请求停止
+     */
+    inline bool isStopping() const { return is_exit; }
+
+private:
+    /**
+     * @brief 工作线程入口，执行 run() 并在最后一个线程退出时调用 onFinished()
+     */
+    void workerMain(int worker_index);
+
+    std::string name;
+    int thread_count;
+    std::vector<std::thread> threads;
+    std::vector<int> cpu_affinity;
+    std::atomic<int> active_workers{0};
+    std::atomic<bool> is_exit{false};
+    std::atomic<int64_t> processed{0};
+    std::atomic<int64_t> errors{0};
+    std::atomic<int64_t> busy_time_us{0};
+    std::atomic<int64_t> cpu_time_us{0};
+    LatencyHistogram latency;
+};
+
+/**
+ * @class SourceStage
+ * @brief 流水线的起点，反复调用生成函数产生数据，直到生成函数返回 false。
+ *
+ * @tparam Out 输出数据类型
+ */
+template <typename Out>
+class SourceStage : public PipelineStage
+{
+public:
+    /**
+     * @brief 生成函数，把产生的数据追加到参数中，数据源结束时返回 false
+     */
+    typedef std::function<bool(std::vector<Out> &)> Func;
+
+    SourceStage(const std::string &name, std::shared_ptr<BlockingQueue<Out>> output, Func fn)
+        : PipelineStage(name, 1), output(std::move(output)), fn(std::move(fn))
+    {
+    }
+
+    ~SourceStage()
+    {
+        stop();
+    }
+
+protected:
+    void run(int) override
+    {
+        std::vector<Out> outputs;
+        bool more = true;
+        while (more && !isStopping())
+        {
+            outputs.clear();
+            auto begin = std::chrono::steady_clock::now();
+            more = fn(outputs);
+            if (!outputs.empty())
+                recordItem(begin, true);
+            for (auto &item : outputs)
+            {
+                if (!output->push(std::move(item)))
+                    return;
+            }
+        }
+    }
+
+    void abortQueues() override
+    {
+        output->abort();
+    }
+
+    void onFinished() override
+    {
+        output->close();
+    }
+
+private:
+    std::shared_ptr<BlockingQueue<Out>> output;
+    Func fn;
+};
+
+/**
+ * @class TransformStage
+ * @brief 流水线的中间阶段，从输入队列取出数据，处理后把零个或多个结果放入输出队列。
+ *
+ * 多个工作线程时，ordered 为 true 则按输入顺序输出（工作线程处理完后按序号依次交付），
+ * 适合下游对顺序敏感的场景，例如编码器要求帧按时间顺序送入。
+ *
+ * @tparam In 输入数据类型，需要可默认构造
+ * @tparam Out 输出数据类型
+ */
+template <typename In, typename Out>
+class TransformStage : public PipelineStage
+{
+public:
+    /**
+     * @brief 处理函数，把结果追加到第二个参数中，失败时返回 false（该输入被跳过）
+     */
+    typedef std::function<bool(In &, std::vector<Out> &)> Func;
+    /**
+     * @brief 冲刷函数，输入结束后调用一次，把缓存在内部的结果追加到参数中
+     */
+    typedef std::function<bool(std::vector<Out> &)> FlushFunc;
+
+    TransformStage(const std::string &name,
+                   std::shared_ptr<BlockingQueue<In>> input,
+                   std::shared_ptr<BlockingQueue<Out>> output,
+                   Func fn, int thread_count = 1, bool ordered = true)
+        : PipelineStage(name, thread_count), input(std::move(input)), output(std::move(output)),
+          fn(std::move(fn)), ordered(ordered && thread_count > 1)
+    {
+    }
+
+    ~TransformStage()
+    {
+        stop();
+    }
+
+    /**
+     * @brief 设置冲刷函数，需要在 start() 前调用
+     */
+    void setFlushFunction(FlushFunc flush_fn)
+    {
+        this->flush_fn = std::move(flush_fn);
+    }
+
+    int getInputQueueDepth() const override
+    {
+        return input->size();
+    }
+
+protected:
+    void run(int) override
+    {
+        In item;
+        std::vector<Out> outputs;
+        while (!isStopping())
+        {
+            int64_t seq = 0;
+            {
+                // 取数据和分配序号必须是原子的，否则序号和输入顺序不一致
+                std::lock_guard<std::mutex> lock(pop_mutex);
+                if (!input->pop(item))
+                    break;
+                seq = next_input_seq++;
+            }
+            outputs.clear();
+            auto begin = std::chrono::steady_clock::now();
+            bool ok = fn(item, outputs);
+            recordItem(begin, ok);
+            // 尽早释放输入数据（例如归还帧缓冲区）
+            item = In();
+            if (!deliver(seq, outputs))
+            {
+                // 下游已经停止，同时让上游停止
+                input->abort();
+                break;
+            }
+        }
+    }
+
+    void abortQueues() override
+    {
+        input->abort();
+        output->abort();
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order_cv.notify_all();
+    }
+
+    void onFinished() override
+    {
+        if (flush_fn && !isStopping())
+        {
+            std::vector<Out> outputs;
+            auto begin = std::chrono::steady_clock::now();
+            recordItem(begin, flush_fn(outputs));
+            for (auto &item : outputs)
+            {
+                if (!output->push(std::move(item)))
+                    break;
+            }
+        }
+        output->close();
+    }
+
+private:
+    /**
+     * @brief 把一个输入的处理结果放入输出队列，有序模式下等待轮到该序号
+     *
+     * @return bool 输出队列已关闭或已请求停止时返回 false
+     */
+    bool deliver(int64_t seq, std::vector<Out> &outputs)
+    {
+        std::unique_lock<std::mutex> lock(order_mutex, std::defer_lock);
+        if (ordered)
+        {
+            lock.lock();
+            order_cv.wait(lock, [&]() { return next_output_seq == seq || isStopping(); });
+            if (isStopping())
+                return false;
+        }
+        bool ok = true;
+        for (auto &item : outputs)
+        {
+            if (!output->push(std::move(item)))
+            {
+                ok = false;
+                break;
+            }
+        }
+        if (ordered)
+        {
+            ++next_output_seq;
+            lock.unlock();
+            order_cv.notify_all();
+        }
+        return ok;
+    }
+
+    std::shared_ptr<BlockingQueue<In>> input;
+    std::shared_ptr<BlockingQueue<Out>> output;
+    Func fn;
+    FlushFunc flush_fn;
+    const bool ordered;
+    std::mutex pop_mutex;
+    int64_t next_input_seq = 0;
+    std::mutex order_mutex;
+    std::condition_variable order_cv;
+    int64_t next_output_seq = 0;
+};
+
+/**
+ * @class BroadcastStage
+ * @brief 把输入队列中的每个数据复制到多个输出队列，例如一次解码的帧分发给多个编码分支。
+ *
+ * 数据通过拷贝构造分发，FramePtrWrapper 等引用计数类型只增加引用，不拷贝像素数据。
+ * 某个输出队列被中止时只停止向该分支分发，所有分支都停止后才让上游停止。
+ *
+ * @tparam T 数据类型，需要可拷贝、可默认构造
+ */
+template <typename T>
+class BroadcastStage : public PipelineStage
+{
+public:
+    BroadcastStage(const std::string &name,
+                   std::shared_ptr<BlockingQueue<T>> input,
+                   std::vector<std::shared_ptr<BlockingQueue<T>>> outputs)
+        : PipelineStage(name, 1), input(std::move(input)), outputs(std::move(outputs))
+    {
+    }
+
+    ~BroadcastStage()
+    {
+        stop();
+    }
+
+    int getInputQueueDepth() const override
+    {
+        return input->size();
+    }
+
+protected:
+    void run(int) override
+    {
+        std::vector<bool> alive(outputs.size(), true);
+        size_t alive_count = outputs.size();
+        T item;
+        while (alive_count > 0 && !isStopping() && input->pop(item))
+        {
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < outputs.size(); ++i)
+            {
+                if (!alive[i])
+                    continue;
+                T copy(item);
+                if (!outputs[i]->push(std::move(copy)))
+                {
+                    alive[i] = false;
+                    --alive_count;
+                }
+            }
+            recordItem(begin, alive_count > 0);
+            item = T();
+        }
+        if (0 == alive_count)
+            input->abort();
+    }
+
+    void abortQueues() override
+    {
+        input->abort();
+        for (auto &output : outputs)
+            output->abort();
+    }
+
+    void onFinished() override
+    {
+        for (auto &output : outputs)
+            output->close();
+    }
+
+private:
+    std::shared_ptr<BlockingQueue<T>> input;
+    std::vector<std::shared_ptr<BlockingQueue<T>>> outputs;
+};
+
+/**
+ * @class SinkStage
+ * @brief 流水线的终点，从输入队列取出数据并消费。
+ *
+ * @tparam In 输入数据类型，需要可默认构造
+ */
+template <typename In>
+class SinkStage : public PipelineStage
+{
+public:
+    /**
+     * @brief 消费函数，失败时返回 false（只计数，不停止）
+     */
+    typedef std::function<bool(In &)> Func;
+
+    SinkStage(const std::string &name, std::shared_ptr<BlockingQueue<In>> input, Func fn, int thread_count = 1)
+        : PipelineStage(name, thread_count), input(std::move(input)), fn(std::move(fn))
+    {
+    }
+
+    ~SinkStage()
+    {
+        stop();
+    }
+
+    int getInputQueueDepth() const override
+    {
+        return input->size();
+    }
+
+protected:
+    void run(int) override
+    {
+        In item;
+        while (!isStopping() && input->pop(item))
+        {
+            auto begin = std::chrono::steady_clock::now();
+            recordItem(begin, fn(item));
+            item = In();
+        }
+    }
+
+    void abortQueues() override
+    {
+        input->abort();
+    }
+
+private:
+    std::shared_ptr<BlockingQueue<In>> input;
+    Func fn;
+};
+
+#endif // PIPELINESTAGE_H
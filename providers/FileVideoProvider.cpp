@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include "FileVideoProvider.h"
 #include "Utils.h"
+#include "CodecThreads.h"
 
 const std::map<std::string, std::string> FileVideoProvider::decoder_map = {
     {"h264", "h264_rkmpp"},
@@ -14,6 +17,10 @@ const std::map<std::string, std::string> FileVideoProvider::decoder_map = {
 FileVideoProvider::FileVideoProvider(const char *url) : url(url), VideoProvider(VideoType::File)
 {
     max_queue_len = 100;
+    // 本地文件不丢帧，网络流丢弃最旧的帧以保证延迟有界
+    std::string prefix = this->url.substr(0, 4);
+    bool is_network = prefix == "rtsp" || prefix == "rtmp" || prefix == "http" || prefix == "udp:" || prefix == "srt:";
+    backpressure_policy = is_network ? DropOldest : BlockProducer;
 }
 
 // 初始化操作
@@ -96,7 +103,15 @@ bool FileVideoProvider::init()
         std::cerr << "Failed to allocate codec context." << std::endl;
         return false;
     }
-    codecCtx->thread_count = use_hard_decoder ? 1 : Utils::core_count();
+    const int threads = decoder_threads > 0 ? decoder_threads : CodecThreads::default_decoder_threads();
+    codec_threads = CodecThreads::configure(codecCtx, threads, use_hard_decoder);
+    if (keyframe_only)
+    {
+        // 只有关键帧时相邻的输出帧之间隔着整个 GOP：不需要重排序缓存，帧级多线程也会把输出推迟若干个 GOP
+        codecCtx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        codecCtx->thread_type = FF_THREAD_SLICE;
+        codecCtx->skip_frame = AVDISCARD_NONKEY;
+    }
     // 配置解码器上下文
     if (avcodec_parameters_to_context(codecCtx, formatCtx->streams[videoStreamIndex]->codecpar) < 0)
     {
@@ -118,9 +133,144 @@ bool FileVideoProvider::init()
     std::cout << "decoding video width:" << width << std::endl;
     std::cout << "decoding video height:" << height << std::endl;
     std::cout << "decoding video fps:" << fps << std::endl;
+
+    // 抽帧按时间戳换算出的帧序号进行，使用不取整的帧率
+    AVStream *stream = formatCtx->streams[videoStreamIndex];
+    AVRational rate = stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate : codecCtx->framerate;
+    frames_per_tick = rate.num > 0 && rate.den > 0 ? av_q2d(rate) * av_q2d(stream->time_base) : 0;
+    pts_anchor = AV_NOPTS_VALUE != stream->start_time ? stream->start_time : 0;
+
+    if (keyframe_only)
+    {
+        // 支持的解封装器（如 MP4）按索引直接跳过非关键帧，不读取其数据
+        stream->discard = AVDISCARD_NONKEY;
+        keyframe_fps = probeKeyframeRate();
+    }
+
+    // 从开始时间之前最近的关键帧开始解码
+    const AVRational us = {1, 1000000};
+    range_start = INT64_MIN == range_start_us ? INT64_MIN : av_rescale_q(range_start_us, us, stream->time_base);
+    range_end = INT64_MAX == range_end_us ? INT64_MAX : av_rescale_q(range_end_us, us, stream->time_base);
+    if (INT64_MIN != range_start && av_seek_frame(formatCtx, videoStreamIndex, range_start, AVSEEK_FLAG_BACKWARD) < 0)
+    {
+        std::cerr << "Failed to seek to " << range_start_us << "us." << std::endl;
+        return false;
+    }
     return true;
 }
 
+bool FileVideoProvider::setTimeRange(int64_t start_us, int64_t end_us)
+{
+    if (isRunning() || start_us >= end_us)
+        return false;
+    range_start_us = start_us;
+    range_end_us = end_us;
+    return true;
+}
+
+bool FileVideoProvider::setDecoderThreads(int threads)
+{
+    if (isRunning() || threads < 0)
+        return false;
+    decoder_threads = threads;
+    return true;
+}
+
+double FileVideoProvider::probeKeyframeRate()
+{
+    if (!formatCtx->pb || !(formatCtx->pb->seekable & AVIO_SEEKABLE_NORMAL))
+        return 0;
+    // 取几个 GOP 的平均长度，最多读取有限个数据包
+    const int max_keyframes = 5;
+    const int max_packets = 5000;
+    std::vector<int64_t> key_pts;
+    AVPacket *pkt = av_packet_alloc();
+    for (int i = 0; i < max_packets && (int)key_pts.size() < max_keyframes; ++i)
+    {
+        if (av_read_frame(formatCtx, pkt) < 0)
+            break;
+        if (pkt->stream_index == videoStreamIndex && (pkt->flags & AV_PKT_FLAG_KEY) && AV_NOPTS_VALUE != pkt->pts)
+            key_pts.push_back(pkt->pts);
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+    if (av_seek_frame(formatCtx, videoStreamIndex, pts_anchor, AVSEEK_FLAG_BACKWARD) < 0)
+        std::cerr << "Failed to seek back after probing keyframes." << std::endl;
+    if (key_pts.size() < 2)
+        return 0;
+    std::sort(key_pts.begin(), key_pts.end());
+    double interval = (key_pts.back() - key_pts.front()) * av_q2d(formatCtx->streams[videoStreamIndex]->time_base) /
+                      (key_pts.size() - 1);
+    return interval > 0 ? 1.0 / interval : 0;
+}
+
+bool FileVideoProvider::isWantedFrame(int64_t pts) const
+{
+    if (frame_interval <= 1 || AV_NOPTS_VALUE == pts || frames_per_tick <= 0)
+        return true;
+    int64_t index = llround((pts - pts_anchor) * frames_per_tick);
+    // 起始时间之前的帧（如开放 GOP 的前导 B 帧）序号为负数
+    return 0 == (index % frame_interval + frame_interval) % frame_interval;
+}
+
+const AVStream *FileVideoProvider::getVideoStream() const
+{
+    return formatCtx && videoStreamIndex >= 0 ? formatCtx->streams[videoStreamIndex] : nullptr;
+}
+
+bool FileVideoProvider::enablePassthrough()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!formatCtx || isRunning())
+        return false;
+    // 直通不需要解码器，硬件解码器的资源和解码线程配额留给其他会话
+    if (codecCtx)
+        avcodec_free_context(&codecCtx);
+    CodecThreads::release(codec_threads);
+    passthrough = true;
+    read_errors = 0;
+    return true;
+}
+
+bool FileVideoProvider::readPacket(AVPacket *pkt, FramePacer *pacer)
+{
+    while (!stop_requested)
+    {
+        AVRational time_base;
+        {
+            // stop() 持有同一把锁释放 formatCtx，需要的字段都在锁内复制
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!passthrough || !formatCtx)
+                return false;
+            av_packet_unref(pkt);
+            int64_t begin = av_gettime_relative();
+            int ret = av_read_frame(formatCtx, pkt);
+            demux_latency.observe(av_gettime_relative() - begin);
+            if (AVERROR_EOF == ret)
+                return false;
+            if (0 != ret)
+            {
+                if (++read_errors > 100)
+                    return false;
+                continue;
+            }
+            read_errors = 0;
+            if (pkt->stream_index != videoStreamIndex)
+                continue;
+            time_base = formatCtx->streams[videoStreamIndex]->time_base;
+        }
+        int64_t ts = AV_NOPTS_VALUE != pkt->dts ? pkt->dts : pkt->pts;
+        if (!pacer || AV_NOPTS_VALUE == ts)
+            return true;
+        // 按解码顺序的时间戳节拍转发，迟到的数据包也照常送出
+        int64_t timestamp_us = av_rescale_q(ts, time_base, AVRational{1, 1000000});
+        if (FramePacer::Cancelled != pacer->wait(timestamp_us, &stop_requested))
+            return true;
+    }
+    av_packet_unref(pkt);
+    return false;
+}
+
 void FileVideoProvider::stop()
 {
     VideoProvider::stop();
@@ -129,6 +279,7 @@ void FileVideoProvider::stop()
     {
         avcodec_free_context(&codecCtx);
     }
+    CodecThreads::release(codec_threads);
     if (formatCtx)
     {
         avformat_close_input(&formatCtx);
@@ -145,33 +296,29 @@ void FileVideoProvider::stop()
 
 void FileVideoProvider::run()
 {
+    if (passthrough)
+        return;
     AVPacket *pkt = av_packet_alloc();
     AVFrame *frame = av_frame_alloc();
-    AVFrame *rgbFrame = av_frame_alloc();
-    uint8_t *buffer = nullptr;
-
-    // 设置输出RGB格式的帧
-    int numBytes = av_image_get_buffer_size(AV_PIX_FMT_RGB24, width, height, 1);
-    buffer = (uint8_t *)av_malloc(numBytes * sizeof(uint8_t));
-    av_image_fill_arrays(rgbFrame->data, rgbFrame->linesize, buffer, AV_PIX_FMT_RGB24, width, height, 1);
-
-    // 使用 SwsContext 将 YUV 转为 RGB
-    swsCtx = sws_getContext(width, height, codecCtx->pix_fmt,
-                            width, height, AV_PIX_FMT_RGB24,
-                            SWS_BICUBIC, nullptr, nullptr, nullptr);
+    AVFrame *dstFrame = av_frame_alloc();
+    AVFrame *swFrame = av_frame_alloc();
+
     int try_time = 0;
     int ret = -1;
     std::cout << "a1" << std::endl;
     int64_t frame_count = 0;
-    while (!is_exit)
+    bool range_done = false;
+    while (!is_exit && !range_done)
     {
         av_packet_unref(pkt);
         // 发送数据包给解码器
+        int64_t begin = av_gettime_relative();
         ret = av_read_frame(formatCtx, pkt);
+        demux_latency.observe(av_gettime_relative() - begin);
         if (AVERROR_EOF == ret)
         {
-            ret = avcodec_send_packet(codecCtx, NULL);
-            if (0 != ret)
+            // 文件结束后冲刷解码器，取出缓存在解码器中的剩余帧；再次冲刷返回错误时结束
+            if (0 != avcodec_send_packet(codecCtx, NULL))
                 break;
         }
         else if (0 != ret)
@@ -181,58 +328,193 @@ void FileVideoProvider::run()
                 break;
             continue;
         }
-        try_time = 0;
-        if (pkt->stream_index != videoStreamIndex)
-            continue;
-
-        if (avcodec_send_packet(codecCtx, pkt) < 0)
+        else
         {
-            std::cerr << "Error sending packet to decoder" << std::endl;
-            continue;
+            try_time = 0;
+            if (pkt->stream_index != videoStreamIndex)
+                continue;
+
+            if (keyframe_only)
+            {
+                // 只解码关键帧时非关键帧不送入解码器
+                if (!(pkt->flags & AV_PKT_FLAG_KEY))
+                {
+                    ++skipped_packets;
+                    continue;
+                }
+            }
+            else
+            {
+                // 抽帧时不输出的帧：没有其他帧参考它（可丢弃）时直接不送入解码器，
+                // 否则让解码器跳过其中的非参考帧，参考帧仍需解码以保证后续帧正确
+                bool wanted = isWantedFrame(pkt->pts);
+#ifdef AV_PKT_FLAG_DISPOSABLE
+                if (!wanted && (pkt->flags & AV_PKT_FLAG_DISPOSABLE))
+                {
+                    ++skipped_packets;
+                    continue;
+                }
+#endif
+                codecCtx->skip_frame = wanted ? AVDISCARD_DEFAULT : AVDISCARD_NONREF;
+            }
+
+            begin = av_gettime_relative();
+            if (avcodec_send_packet(codecCtx, pkt) < 0)
+            {
+                std::cerr << "Error sending packet to decoder" << std::endl;
+                continue;
+            }
         }
-        // 获取解码后的帧
+        // 取出解码器当前已经输出的全部帧
         while (!is_exit)
         {
             int ret = avcodec_receive_frame(codecCtx, frame);
             if (0 != ret)
                 break;
+            // 解码耗时包括送入数据包和取出帧
+            decode_latency.observe(av_gettime_relative() - begin);
+            ++decoded_frames;
 
             frame_count += 1;
-            if (frame_count % frame_interval != 0)
+            int64_t pts = frame->best_effort_timestamp;
+            // 解码器按显示顺序输出，第一帧到达结束时间后后续的帧都在范围之外
+            if (AV_NOPTS_VALUE != pts && (pts < range_start || pts >= range_end))
             {
                 av_frame_unref(frame);
-                break;
+                if (pts >= range_end)
+                {
+                    range_done = true;
+                    break;
+                }
+                begin = av_gettime_relative();
+                continue;
             }
-
-            // 转换为 RGB 格式
-            int len = sws_scale(swsCtx, frame->data, frame->linesize, 0, height, rgbFrame->data, rgbFrame->linesize);
-            if (len <= 0)
+            // 只解码关键帧时全部输出；时间戳未知时退化为按解码帧的序号抽帧
+            bool wanted = keyframe_only ||
+                          (AV_NOPTS_VALUE != pts && frames_per_tick > 0 ? isWantedFrame(pts)
+                                                                         : 0 == frame_count % frame_interval);
+            if (!wanted)
             {
                 av_frame_unref(frame);
+                begin = av_gettime_relative();
                 continue;
             }
 
             // 计算时间戳，转换为微秒
-            int64_t pts = frame->best_effort_timestamp;
             int64_t timestamp_us = av_q2d(formatCtx->streams[videoStreamIndex]->time_base) * 1000000.0 * pts;
             if (timestamp_us == 0)
             {
                 timestamp_us = frame_count * 1000000.0 / fps;
             }
 
-            while (!is_exit && data_queue.size() > max_queue_len / 3 * 2)
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            push(FramePtrWrapper(rgbFrame->data[0], height * width * 3, timestamp_us));
+            AVFrame *src = frame;
+            if (frame->hw_frames_ctx)
+            {
+                // 硬件帧先下载到内存，同时归还解码器有限的硬件缓冲区
+                av_frame_unref(swFrame);
+                if (av_hwframe_transfer_data(swFrame, frame, 0) < 0)
+                {
+                    av_frame_unref(frame);
+                    begin = av_gettime_relative();
+                    continue;
+                }
+                src = swFrame;
+            }
+
+            FramePtrWrapper out_frame;
+            begin = av_gettime_relative();
+            bool converted = convertFrame(src, dstFrame, out_frame);
+            convert_latency.observe(av_gettime_relative() - begin);
+            if (!converted)
+            {
+                av_frame_unref(swFrame);
+                av_frame_unref(frame);
+                continue;
+            }
+            av_frame_unref(swFrame);
+
+            // 队列满时的处理由背压策略决定
+            out_frame.setTimestamp(timestamp_us);
+#ifdef AV_FRAME_FLAG_KEY
+            out_frame.setKeyFrame(frame->flags & AV_FRAME_FLAG_KEY);
+#else
+            out_frame.setKeyFrame(frame->key_frame);
+#endif
+            push(std::move(out_frame));
 
             // 清理帧数据
             av_frame_unref(frame);
-            break;
+            begin = av_gettime_relative();
         }
     }
 
     // 清理资源
+    av_packet_free(&pkt);
     av_frame_free(&frame);
-    av_frame_free(&rgbFrame);
-    av_freep(&buffer);
+    av_frame_free(&dstFrame);
+    av_frame_free(&swFrame);
     is_exit = true;
 }
+
+bool FileVideoProvider::convertFrame(AVFrame *src, AVFrame *dst, FramePtrWrapper &out)
+{
+    const int dst_width = getWidth();
+    const int dst_height = getHeight();
+    int dst_format = AV_PIX_FMT_RGB24;
+    if (NativeFrame == output_mode)
+    {
+        dst_format = out_pix_fmt >= 0 ? out_pix_fmt : src->format;
+        // 格式和尺寸都一致，只增加引用计数，不做转换和拷贝
+        if (dst_format == src->format && dst_width == src->width && dst_height == src->height)
+        {
+            out = FramePtrWrapper(src);
+            return NULL != out.getDataPtr();
+        }
+    }
+
+    // 唯一的一次缩放和颜色空间转换，直接输出最终的尺寸和格式
+    swsCtx = sws_getCachedContext(swsCtx, src->width, src->height, (AVPixelFormat)src->format,
+                                  dst_width, dst_height, (AVPixelFormat)dst_format,
+                                  SWS_BICUBIC, nullptr, nullptr, nullptr);
+    if (!swsCtx)
+        return false;
+
+    // PackedRGB24 模式保持紧密排列，NativeFrame 模式按 32 字节对齐每一行
+    const int align = PackedRGB24 == output_mode ? 1 : 32;
+    int numBytes = av_image_get_buffer_size((AVPixelFormat)dst_format, dst_width, dst_height, align);
+    if (numBytes <= 0)
+        return false;
+    if (numBytes != frame_pool.getByteSize())
+        frame_pool.reset(numBytes, max_queue_len + POOL_SLACK);
+
+    av_frame_unref(dst);
+    dst->buf[0] = frame_pool.acquire();
+    if (!dst->buf[0])
+        return false;
+    av_image_fill_arrays(dst->data, dst->linesize, dst->buf[0]->data, (AVPixelFormat)dst_format, dst_width, dst_height, align);
+    dst->format = dst_format;
+    dst->width = dst_width;
+    dst->height = dst_height;
+
+    int len = sws_scale(swsCtx, src->data, src->linesize, 0, src->height, dst->data, dst->linesize);
+    if (len <= 0)
+    {
+        av_frame_unref(dst);
+        return false;
+    }
+
+    if (PackedRGB24 == output_mode)
+    {
+        // 缓冲池中的缓冲区直接交给 FramePtrWrapper，保持打包数据的接口
+        out = FramePtrWrapper();
+        out.bindBuffer(dst->buf[0]);
+        dst->buf[0] = nullptr;
+        out.setImageInfo(dst_format, dst_width, dst_height);
+    }
+    else
+    {
+        out = FramePtrWrapper(dst);
+    }
+    av_frame_unref(dst);
+    return NULL != out.getDataPtr();
+}
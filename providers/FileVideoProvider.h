@@ -2,6 +2,7 @@
 #define FILEVIDEOPROVIDER_H
 
 #include "VideoProvider.h"
+#include "FramePacer.h"
 
 extern "C"
 {
@@ -9,9 +10,11 @@ extern "C"
 #include <libavcodec/avcodec.h>
 #include <libavutil/avutil.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/hwcontext.h>
 #include <libswscale/swscale.h>
 }
 
+#include <cstdint>
 #include <string>
 #include <map>
 
@@ -37,6 +40,10 @@ private:
      * @brief FFmpeg编解码器上下文，用于处理视频帧的编解码操作。
      */
     AVCodecContext *codecCtx = nullptr;
+    /**
+     * @brief 从共享调度器申请到的解码线程配额，释放解码器时归还。
+     */
+    int codec_threads = 0;
     /**
      * @brief FFmpeg编解码器指针，指向具体的视频编解码器。
      */
@@ -45,6 +52,32 @@ private:
      * @brief 视频流在格式上下文中的索引，用于标识视频流。
      */
     int videoStreamIndex = -1;
+    /**
+     * @brief 直通模式下连续读取失败的次数。
+     */
+    int read_errors = 0;
+    /**
+     * @brief 视频流时间基准下每个时间单位对应的源视频帧数，用于把时间戳换算成帧序号，帧率未知时为 0。
+     */
+    double frames_per_tick = 0;
+    /**
+     * @brief 帧序号的起点（视频流时间基准），取视频流的起始时间。
+     */
+    int64_t pts_anchor = 0;
+    /**
+     * @brief 只输出显示时间在该范围内的帧（微秒），默认不限制。
+     */
+    int64_t range_start_us = INT64_MIN;
+    int64_t range_end_us = INT64_MAX;
+    /**
+     * @brief 换算到视频流时间基准的输出范围，init() 时计算。
+     */
+    int64_t range_start = INT64_MIN;
+    int64_t range_end = INT64_MAX;
+    /**
+     * @brief 软件解码器期望的线程数，0 表示使用 CodecThreads::default_decoder_threads()。
+     */
+    int decoder_threads = 0;
     /**
      * @brief FFmpeg图像缩放上下文，用于在不同像素格式和尺寸之间转换视频帧。
      */
@@ -56,6 +89,39 @@ private:
      */
     static const std::map<std::string, std::string> decoder_map;
 
+    /**
+     * @brief 按输出模式、尺寸和像素格式转换一帧解码后的图像。
+     * 
+     * 格式和尺寸都与目标一致时直接引用原帧，否则用一次 sws_scale 转换到缓冲池中的缓冲区。
+     * 
+     * @param src 解码后的图像帧（内存帧）
+     * @param dst 转换时使用的临时帧
+     * @param out 输出参数，转换后的帧
+     * @return bool 成功返回true，失败返回false。
+     */
+    bool convertFrame(AVFrame *src, AVFrame *dst, FramePtrWrapper &out);
+
+    /**
+     * @brief 判断时间戳为 pts 的帧在按 frame_interval 抽帧后是否需要输出。
+     * 
+     * 按时间戳换算出源视频的帧序号，序号是 frame_interval 整数倍的帧才输出。
+     * 只依赖时间戳，解封装时（解码顺序）和解码后（显示顺序）对同一帧的判断一致，
+     * 因此可以在送入解码器之前跳过不输出的帧。
+     * 
+     * @param pts 视频流时间基准下的时间戳
+     * @return bool 需要输出返回true；时间戳或帧率未知时无法判断，返回true。
+     */
+    bool isWantedFrame(int64_t pts) const;
+
+    /**
+     * @brief 预读开头的若干个关键帧，估计关键帧的频率，之后回到文件开头。
+     * 
+     * 只在可以回退的输入（本地文件）上预读，网络流无法估计。
+     * 
+     * @return double 每秒的关键帧数，无法估计时返回0。
+     */
+    double probeKeyframeRate();
+
 public:
     /**
      * @brief 构造函数，初始化文件视频提供者。
@@ -73,6 +139,53 @@ public:
      * @brief 停止视频提供线程，释放相关资源。
      */
     void stop();
+    /**
+     * @brief 设置只输出的时间范围，用于把一个文件分成多段并行处理。
+     * 
+     * 需要在 init() 之前调用。init() 时定位到 start_us 之前最近的关键帧，之前的帧解码后丢弃；
+     * 解码出第一个显示时间不早于 end_us 的帧后结束，因此开放 GOP 中属于本段的前导帧也能正确解码。
+     * 两个范围首尾相接时，每一帧恰好属于其中一个范围。
+     * 
+     * @param start_us 开始时间（微秒，包含），INT64_MIN 表示从头开始
+     * @param end_us 结束时间（微秒，不包含），INT64_MAX 表示到文件结束
+     * @return bool 设置成功返回true，参数非法或线程正在运行时返回false。
+     */
+    bool setTimeRange(int64_t start_us, int64_t end_us);
+    /**
+     * @brief 设置软件解码器期望的线程数，实际线程数受进程内共享的线程配额限制。
+     * 
+     * 需要在 init() 之前调用。
+     * 
+     * @param threads 线程数，0 表示使用 CodecThreads::default_decoder_threads()
+     * @return bool 设置成功返回true，线程正在运行时返回false。
+     */
+    bool setDecoderThreads(int threads);
+    /**
+     * @brief 获取输入的视频流，用于判断能否直通以及向封装器添加相同参数的流。
+     * 
+     * @return const AVStream* 视频流，init() 成功之前返回nullptr。
+     */
+    const AVStream *getVideoStream() const;
+    /**
+     * @brief 切换到直通模式，释放解码器并归还解码线程配额。
+     * 
+     * 需要在 init() 之后、start() 之前调用。之后不再启动解码线程，
+     * 由调用者通过 readPacket() 读取视频数据包，直接交给封装器，不解码也不重新编码。
+     * 
+     * @return bool 成功返回true，尚未初始化或线程正在运行时返回false。
+     */
+    bool enablePassthrough();
+    /**
+     * @brief 直通模式下读取下一个视频数据包。
+     * 
+     * 跳过其他流的数据包。pacer 不为空时按数据包的解码时间戳节拍返回，用于按原始速率转发；
+     * 数据包不能丢弃，pacer 应当构造为从不丢帧。等待期间调用 stop() 会使该方法及时返回。
+     * 
+     * @param pkt 输出参数，接收数据包，时间戳以 getVideoStream() 的时间基为单位
+     * @param pacer 节拍定时器，为空表示尽快读取
+     * @return bool 读到数据包返回true，输入结束、读取出错或已调用 stop() 时返回false。
+     */
+    bool readPacket(AVPacket *pkt, FramePacer *pacer);
     /**
      * @brief 线程执行的主要方法，使用FFmpeg不断解码视频流并获取时间戳，将解码后的帧放入队列。
      */
@@ -1,4 +1,6 @@
 #include "ThreadProvider.h"
+#include "CpuTopology.h"
+#include "Utils.h"
 #include <iostream>
 #include <chrono>
 
@@ -7,9 +9,78 @@ int ThreadProvider::getMaxQueueLength() const
     return max_queue_len;
 }
 
-void ThreadProvider::setMaxQueueLength(int value)
+bool ThreadProvider::setMaxQueueLength(int value)
 {
+    // 环形队列的容量在 start() 时按最大长度分配，运行中修改会使生产者和消费者看到不一致的长度
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!is_exit || value <= 0)
+        return false;
     max_queue_len = value;
+    frame_pool.setCapacity(value + POOL_SLACK);
+    return true;
+}
+
+ThreadProvider::QueueBackend ThreadProvider::getQueueBackend() const
+{
+    return queue_backend;
+}
+
+bool ThreadProvider::setQueueBackend(QueueBackend backend)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!is_exit)
+        return false;
+    queue_backend = backend;
+    return true;
+}
+
+ThreadProvider::BackpressurePolicy ThreadProvider::getBackpressurePolicy() const
+{
+    return backpressure_policy.load();
+}
+
+void ThreadProvider::setBackpressurePolicy(BackpressurePolicy policy)
+{
+    backpressure_policy = policy;
+}
+
+void ThreadProvider::setCpuAffinity(const std::vector<int> &cpus)
+{
+    cpu_affinity = cpus;
+}
+
+ThreadProvider::QueueStats ThreadProvider::getQueueStats() const
+{
+    QueueStats stats;
+    stats.pushed_frames = pushed_frames;
+    stats.dropped_frames = dropped_frames;
+    stats.stall_time_us = stall_time_us;
+    stats.producer_cpu_us = producer_cpu_us;
+    stats.queue_size = getQueueSize();
+    return stats;
+}
+
+void ThreadProvider::collectMetrics(MetricsWriter &writer, const MetricsWriter::Labels &labels) const
+{
+    QueueStats stats = getQueueStats();
+    writer.gauge("video_decode_queue_depth", "Frames waiting in the decode queue.", labels, stats.queue_size);
+    writer.gauge("video_decode_queue_capacity", "Maximum length of the decode queue.", labels, max_queue_len);
+    writer.counter("video_decoded_frames_total", "Frames pushed into the decode queue.", labels, (double)stats.pushed_frames);
+    writer.counter("video_decode_dropped_frames_total", "Frames dropped by the decode queue backpressure policy.", labels,
+                   (double)stats.dropped_frames);
+    writer.counter("video_decode_stall_seconds_total", "Time the decode thread spent waiting for queue space.", labels,
+                   stats.stall_time_us / 1e6);
+}
+
+int ThreadProvider::getQueueSize() const
+{
+    if (RingQueue == queue_backend)
+    {
+        // 扣除已请求但消费者尚未执行的丢帧
+        int size = (int)ring_queue.size() - pending_drop_frames;
+        return size > 0 ? size : 0;
+    }
+    return curQueueSize;
 }
 
 ThreadProvider::~ThreadProvider()
@@ -18,75 +89,348 @@ ThreadProvider::~ThreadProvider()
 }
 
 void ThreadProvider::push(const FramePtrWrapper &d)
+{
+    // 拷贝只增加引用计数
+    push(FramePtrWrapper(d));
+}
+
+void ThreadProvider::push(FramePtrWrapper &&d)
 {
     if (is_exit)
         return;
-    std::lock_guard<std::mutex> lock(mutex);
-    while (curQueueSize >= max_queue_len)
+    ++pushed_frames;
+    // 前面的帧所在的 GOP 已被整体丢弃，等到下一个关键帧再恢复入队
+    if (skip_to_keyframe)
     {
-        data_queue.pop_front();
-        --curQueueSize;
+        if (!d.isKeyFrame())
+        {
+            ++dropped_frames;
+            return;
+        }
+        skip_to_keyframe = false;
+    }
+    const BackpressurePolicy policy = backpressure_policy;
+    if (BlockProducer == policy && !waitForSpace(max_queue_len - 1))
+        return;
+
+    if (RingQueue == queue_backend)
+    {
+        // 环形队列只有消费者能出队，从队首丢帧的操作交给消费者执行
+        bool request_drop = false;
+        if (getQueueSize() >= max_queue_len)
+        {
+            if (DropNewest == policy)
+            {
+                ++dropped_frames;
+                return;
+            }
+            else if (DropOldest == policy)
+            {
+                ++pending_drop_frames;
+                request_drop = true;
+            }
+            else if (DropGop == policy && 0 == pending_drop_gops)
+            {
+                ++pending_drop_gops;
+                if (!d.isKeyFrame() && frames_since_keyframe >= getQueueSize())
+                {
+                    // 队列中只有一个 GOP，消费者会丢弃整个队列，新帧属于已丢弃的 GOP
+                    ++dropped_frames;
+                    skip_to_keyframe = true;
+                    return;
+                }
+            }
+        }
+        const bool key_frame = d.isKeyFrame();
+        if (!ring_queue.tryPush(std::move(d)))
+        {
+            // 消费者长时间没有执行丢帧导致物理空间耗尽，只能丢弃新帧
+            if (request_drop)
+                --pending_drop_frames;
+            ++dropped_frames;
+            return;
+        }
+        frames_since_keyframe = key_frame ? 1 : frames_since_keyframe + 1;
+        notifyConsumer();
+        return;
     }
-    data_queue.emplace_back(d);
-    ++curQueueSize;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (curQueueSize >= max_queue_len && DropNewest == policy)
+        {
+            ++dropped_frames;
+            return;
+        }
+        if (curQueueSize >= max_queue_len && DropGop == policy)
+        {
+            dropOldestGop();
+            if (0 == curQueueSize && !d.isKeyFrame())
+            {
+                // 队列被清空且新帧不是关键帧，新帧属于已丢弃的 GOP
+                ++dropped_frames;
+                skip_to_keyframe = true;
+                return;
+            }
+        }
+        while (curQueueSize >= max_queue_len)
+        {
+            data_queue.pop_front();
+            --curQueueSize;
+            ++dropped_frames;
+        }
+        data_queue.emplace_back(std::move(d));
+        ++curQueueSize;
+    }
+    notifyConsumer();
 }
 
-void ThreadProvider::push(FramePtrWrapper &&d)
+void ThreadProvider::dropOldestGop()
 {
-    if (is_exit)
+    if (data_queue.empty())
         return;
-    std::lock_guard<std::mutex> lock(mutex);
-    while (curQueueSize >= max_queue_len)
+    data_queue.pop_front();
+    --curQueueSize;
+    ++dropped_frames;
+    while (!data_queue.empty() && !data_queue.front().isKeyFrame())
     {
         data_queue.pop_front();
         --curQueueSize;
+        ++dropped_frames;
     }
-    data_queue.emplace_back(d);
-    ++curQueueSize;
 }
 
-FramePtrWrapper ThreadProvider::pop()
+void ThreadProvider::applyPendingDrops()
 {
-    if (is_exit)
-        return FramePtrWrapper();
-    std::lock_guard<std::mutex> lock(mutex);
-    if (data_queue.empty())
+    int drops = pending_drop_frames.exchange(0);
+    bool dropped = false;
+    while (drops-- > 0 && ring_queue.discard())
     {
-        return FramePtrWrapper();
+        ++dropped_frames;
+        dropped = true;
     }
+    if (pending_drop_gops.exchange(0) > 0 && ring_queue.discard())
+    {
+        ++dropped_frames;
+        dropped = true;
+        FramePtrWrapper *front = nullptr;
+        while ((front = ring_queue.front()) && !front->isKeyFrame())
+        {
+            ring_queue.discard();
+            ++dropped_frames;
+        }
+    }
+    if (dropped)
+        notifyProducer();
+}
+
+FramePtrWrapper ThreadProvider::pop()
+{
     FramePtrWrapper d;
-    d.swap(data_queue.front());
-    data_queue.pop_front();
-    --curQueueSize;
+    pop(d);
     return d;
 }
 
 FramePtrWrapper ThreadProvider::top()
 {
-    if (is_exit)
+    if (stop_requested)
         return FramePtrWrapper();
+    if (RingQueue == queue_backend)
+    {
+        applyPendingDrops();
+        FramePtrWrapper *front = ring_queue.front();
+        return front ? FramePtrWrapper(*front) : FramePtrWrapper();
+    }
     std::lock_guard<std::mutex> lock(mutex);
     if (data_queue.empty())
     {
         return FramePtrWrapper();
     }
+    // 拷贝只增加引用计数，不会复制像素数据
     FramePtrWrapper d(data_queue.front());
     return d;
 }
 
+bool ThreadProvider::peek(FrameInfo &info)
+{
+    info = FrameInfo();
+    if (stop_requested)
+        return false;
+    if (RingQueue == queue_backend)
+    {
+        applyPendingDrops();
+        FramePtrWrapper *front = ring_queue.front();
+        if (!front)
+            return false;
+        info.timestamp = front->getTimestamp();
+        info.byte_size = front->getByteSize();
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (data_queue.empty())
+        return false;
+    const FramePtrWrapper &front = data_queue.front();
+    info.timestamp = front.getTimestamp();
+    info.byte_size = front.getByteSize();
+    return true;
+}
+
+bool ThreadProvider::pop(FramePtrWrapper &d)
+{
+    if (stop_requested)
+        return false;
+    if (RingQueue == queue_backend)
+    {
+        applyPendingDrops();
+        if (!ring_queue.tryPop(d))
+            return false;
+        notifyProducer();
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (data_queue.empty())
+            return false;
+        d = std::move(data_queue.front());
+        data_queue.pop_front();
+        --curQueueSize;
+    }
+    notifyProducer();
+    return true;
+}
+
+bool ThreadProvider::waitForData(int timeout_ms)
+{
+    if (getQueueSize() > 0)
+        return true;
+    std::unique_lock<std::mutex> lock(wait_mutex);
+    ++consumer_waiters;
+    // 与 notifyConsumer 中的内存屏障配对：要么这里看到新数据，要么生产者看到等待者
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto ready = [this]() { return is_exit || getQueueSize() > 0; };
+    if (timeout_ms < 0)
+        not_empty.wait(lock, ready);
+    else
+        not_empty.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+    --consumer_waiters;
+    return !is_exit && getQueueSize() > 0;
+}
+
+bool ThreadProvider::popDue(FramePtrWrapper &d, FramePacer *pacer)
+{
+    while (!stop_requested)
+    {
+        // 先读结束标志再取帧：生产者在结束前入队的帧一定能取到
+        const bool finished = is_exit;
+        if (!pop(d))
+        {
+            if (finished)
+                break;
+            // 队列为空时阻塞等待解码线程送来新帧，stop() 会唤醒等待
+            waitForData(100);
+            continue;
+        }
+        if (!pacer)
+            return true;
+        // 取出后再休眠到期，等待期间解码线程可以继续填充队列
+        switch (pacer->wait(d.getTimestamp(), &stop_requested))
+        {
+        case FramePacer::Send:
+            return true;
+        case FramePacer::Drop:
+            continue;
+        case FramePacer::Cancelled:
+            break;
+        }
+    }
+    d = FramePtrWrapper();
+    return false;
+}
+
+bool ThreadProvider::waitForSpace(int limit)
+{
+    if (limit < 0)
+        limit = 0;
+    if (getQueueSize() <= limit)
+        return !is_exit;
+    auto begin = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(wait_mutex);
+        ++producer_waiters;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        not_full.wait(lock, [this, limit]() { return is_exit || getQueueSize() <= limit; });
+        --producer_waiters;
+    }
+    stall_time_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    return !is_exit;
+}
+
+void ThreadProvider::notifyConsumer()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (0 == consumer_waiters.load(std::memory_order_relaxed))
+        return;
+    // 可能有多个等待者，各自等待的条件不同，全部唤醒后由其自行检查
+    std::lock_guard<std::mutex> lock(wait_mutex);
+    not_empty.notify_all();
+}
+
+void ThreadProvider::notifyProducer()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (0 == producer_waiters.load(std::memory_order_relaxed))
+        return;
+    std::lock_guard<std::mutex> lock(wait_mutex);
+    not_full.notify_all();
+}
+
+void ThreadProvider::clearQueue()
+{
+    data_queue.clear();
+    curQueueSize = 0;
+    pending_drop_frames = 0;
+    pending_drop_gops = 0;
+    skip_to_keyframe = false;
+    frames_since_keyframe = 0;
+    // 预留一倍余量，丢帧请求尚未被消费者执行时生产者仍可入队
+    ring_queue.reset(RingQueue == queue_backend ? max_queue_len * 2 : 0);
+}
+
 void ThreadProvider::start()
 {
     std::lock_guard<std::mutex> lock(mutex);
+    clearQueue();
+    pushed_frames = 0;
+    dropped_frames = 0;
+    stall_time_us = 0;
+    producer_cpu_us = 0;
+    stop_requested = false;
     is_exit = false;
-    m_thread = std::thread(&ThreadProvider::run, this);
+    m_thread = std::thread([this]() {
+        CpuTopology::pin_current_thread(cpu_affinity);
+        run();
+        producer_cpu_us = Utils::thread_cpu_time_us();
+    });
 }
 
 void ThreadProvider::stop()
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    is_exit = true;
-    if (m_thread.joinable())
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop_requested = true;
+        is_exit = true;
+    }
+    // 唤醒所有阻塞在队列上的线程，使其能够检查退出标志
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+    if (m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id())
         m_thread.join();
+    // 不能在这里重建环形队列，消费者可能仍在访问它
+    std::lock_guard<std::mutex> lock(mutex);
     data_queue.clear();
     curQueueSize = 0;
+    pending_drop_frames = 0;
+    pending_drop_gops = 0;
 }
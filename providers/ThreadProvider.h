@@ -4,7 +4,14 @@
 #include <thread>
 #include <list>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <vector>
 #include "FramePtrWrapper.h"
+#include "FrameBufferPool.h"
+#include "SpscRingBuffer.h"
+#include "FramePacer.h"
+#include "MetricsRegistry.h"
 
 /**
  * @brief 线程提供者基类
@@ -12,10 +19,55 @@
  * 该类提供了一个基于线程的数据提供机制，用于管理数据队列的操作，
  * 如数据的入队、出队，以及线程的启动和停止等功能。
  * 派生类需要实现 run 方法来定义线程的具体执行逻辑。
+ *
+ * 队列有两种实现：默认的链表加互斥锁，以及单生产者单消费者的无锁环形队列。
+ * 两种实现下生产者和消费者都可以通过条件变量阻塞等待，而不是轮询休眠。
  */
 class ThreadProvider
 {
 public:
+    /**
+     * @brief 数据队列的实现方式
+     */
+    enum QueueBackend
+    {
+        ListQueue = 0, // std::list 加互斥锁，允许多个线程出入队
+        RingQueue      // 无锁环形队列，只允许一个生产者线程和一个消费者线程
+    };
+
+    /**
+     * @brief 队列满时的背压策略
+     */
+    enum BackpressurePolicy
+    {
+        BlockProducer = 0, // 阻塞生产者直到队列有空位，不丢帧（离线转码）
+        DropOldest,        // 丢弃队首最旧的帧（实时流，延迟有界）
+        DropNewest,        // 丢弃新到达的帧
+        DropGop            // 丢弃队首最旧的一整个 GOP，保证队列总是从关键帧开始
+    };
+
+    /**
+     * @brief 队列的统计信息
+     */
+    struct QueueStats
+    {
+        int64_t pushed_frames = 0;  // 生产者提交的帧数
+        int64_t dropped_frames = 0; // 因背压策略丢弃的帧数
+        int64_t stall_time_us = 0;  // 生产者阻塞等待空位的累计时间（微秒）
+        int64_t producer_cpu_us = 0; // 生产者线程退出时已使用的 CPU 时间（微秒），线程运行中为 0
+        int queue_size = 0;         // 当前队列长度
+    };
+
+    /**
+     * @brief 队首帧的元信息
+     * 用于在不拷贝像素数据的情况下查看队首帧的时间戳和大小。
+     */
+    struct FrameInfo
+    {
+        int64_t timestamp = -1; // 帧的时间戳，-1 表示无效
+        int byte_size = 0;      // 帧数据的字节大小，0 表示队列为空
+    };
+
     /**
      * @brief 默认构造函数
      * 显式要求编译器生成 ThreadProvider 类的默认构造函数，
@@ -37,10 +89,104 @@ public:
      *
      * 该方法用于修改数据队列允许存储的最大元素数量。
      * 调用此方法后，`data_queue` 队列在达到新的最大长度后可能会有相应的处理逻辑（如阻塞入队操作）。
+     * 帧缓冲池的容量会随之调整为 `value + POOL_SLACK`。需要在 `start()` 之前调用。
      *
      * @param value 要设置的队列最大长度值
+     * @return bool 设置成功返回true，线程正在运行或长度不大于0时返回false。
      */
-    void setMaxQueueLength(int value);
+    bool setMaxQueueLength(int value);
+
+    /**
+     * @brief 获取数据队列的实现方式
+     *
+     * @return QueueBackend 当前使用的队列实现
+     */
+    QueueBackend getQueueBackend() const;
+
+    /**
+     * @brief 设置数据队列的实现方式
+     *
+     * 只能在线程启动前调用。使用 `RingQueue` 时，`push` 只能由一个生产者线程调用，
+     * `pop`、`peek`、`top` 只能由一个消费者线程调用；此时需要从队首丢帧的策略由消费者在下一次出队时执行。
+     *
+     * @param backend 队列实现方式
+     * @return bool 设置成功返回 `true`，线程正在运行时返回 `false`
+     */
+    bool setQueueBackend(QueueBackend backend);
+
+    /**
+     * @brief 获取队列满时的背压策略
+     *
+     * @return BackpressurePolicy 当前的背压策略
+     */
+    BackpressurePolicy getBackpressurePolicy() const;
+
+    /**
+     * @brief 设置队列满时的背压策略
+     *
+     * 建议在线程启动前调用。离线文件转码使用 `BlockProducer` 保证不丢帧，
+     * 实时流使用丢帧策略保证延迟有界。
+     *
+     * @param policy 背压策略
+     */
+    void setBackpressurePolicy(BackpressurePolicy policy);
+
+    /**
+     * @brief 获取队列的统计信息
+     *
+     * @return QueueStats 入队帧数、丢帧数、生产者阻塞时间和当前队列长度
+     */
+    QueueStats getQueueStats() const;
+
+    /**
+     * @brief 把队列统计写入指标
+     *
+     * 输出队列深度、入队帧数、丢帧数和生产者阻塞时间，派生类可以追加自己的指标。
+     *
+     * @param writer 指标输出
+     * @param labels 附加在每个样本上的标签，例如流名称
+     */
+    virtual void collectMetrics(MetricsWriter &writer, const MetricsWriter::Labels &labels) const;
+
+    /**
+     * @brief 获取数据队列中当前的元素个数
+     *
+     * @return int 队列中的元素个数
+     */
+    int getQueueSize() const;
+
+    /**
+     * @brief 等待数据队列中有数据
+     *
+     * 消费者调用该方法阻塞等待，直到队列非空、线程退出或超时，生产者入队时会唤醒等待者。
+     *
+     * @param timeout_ms 超时时间（毫秒），小于 0 表示一直等待
+     * @return bool 队列非空返回 `true`，超时或线程已退出返回 `false`
+     */
+    bool waitForData(int timeout_ms = -1);
+
+    /**
+     * @brief 按时间戳取出到期的队首帧
+     *
+     * 队列为空时阻塞等待解码线程送来新帧。pacer 不为空时取出队首帧后由 pacer 休眠到该帧到期，
+     * 用于按原始帧率推流，迟到过多被 pacer 丢弃的帧不会返回；pacer 为空时不等待，用于离线转码。
+     * 等待期间调用 `stop()` 会使该方法及时返回；生产者线程自行结束时先返回队列中剩余的帧，取完后返回 `false`。
+     *
+     * @param d 输出参数，接收队首帧
+     * @param pacer 节拍定时器，为空表示不按时间戳节拍取帧
+     * @return bool 取出一帧返回 `true`，已调用 `stop()` 或生产者已结束且队列为空时返回 `false`
+     */
+    bool popDue(FramePtrWrapper &d, FramePacer *pacer);
+
+    /**
+     * @brief 设置生产者线程绑定的 CPU
+     *
+     * 需要在 `start()` 前调用，线程启动后先绑定到这些 CPU 再执行 `run()`。
+     * 通常传入 CpuTopology::node_cpus() 的结果，使解码线程与同一路的其他线程留在同一个 NUMA 节点。
+     *
+     * @param cpus 逻辑 CPU 编号，为空表示不绑定
+     */
+    void setCpuAffinity(const std::vector<int> &cpus);
 
     /**
      * @brief 线程提供者类的析构函数
@@ -91,6 +237,28 @@ public:
      */
     virtual FramePtrWrapper top();
 
+    /**
+     * @brief 查看数据队列中最早放入的数据的元信息
+     *
+     * 该方法只读取队首帧的时间戳和字节大小，不会拷贝或引用像素数据，
+     * 适合在等待帧到期的循环中频繁调用。
+     *
+     * @param info 输出参数，队首帧的元信息
+     * @return bool 队列非空返回 `true`，否则返回 `false`
+     */
+    virtual bool peek(FrameInfo &info);
+
+    /**
+     * @brief 从数据队列中取出最早放入的数据
+     *
+     * 与 `pop()` 相同，但通过移动语义把队首帧的缓冲区转移到 `d` 中，
+     * 并通过返回值区分队列为空的情况。
+     *
+     * @param d 输出参数，接收队首帧
+     * @return bool 成功取出返回 `true`，队列为空或线程已退出返回 `false`
+     */
+    virtual bool pop(FramePtrWrapper &d);
+
     /**
      * @brief 启动线程
      *
@@ -103,6 +271,8 @@ public:
      * @brief 停止线程并等待线程退出
      *
      * 该方法会请求线程退出，并阻塞当前线程直到目标线程完全退出。
+     * 消费者此时可能仍在 pop()/top() 中访问环形队列，所以这里只清空链表队列，
+     * 环形队列中剩余的帧在下一次 start() 或析构时释放。
      * 派生类可以重写此方法以实现自定义的线程停止逻辑。
      */
     virtual void stop();
@@ -124,11 +294,57 @@ public:
     inline const bool isRunning() const { return is_exit == false; }
 
 protected:
+    /**
+     * @brief 等待数据队列中的元素个数不超过 limit
+     *
+     * 生产者调用该方法阻塞等待，直到队列长度不超过 limit 或线程退出，消费者出队时会唤醒等待者。
+     *
+     * @param limit 队列长度上限
+     * @return bool 线程仍在运行返回 `true`，线程已退出返回 `false`
+     */
+    bool waitForSpace(int limit);
+
+    /**
+     * @brief 环形队列模式下由消费者执行生产者请求的丢帧操作
+     */
+    void applyPendingDrops();
+
+    /**
+     * @brief 链表模式下丢弃队首的一个 GOP（调用者需持有 mutex）
+     */
+    void dropOldestGop();
+
+    /**
+     * @brief 唤醒等待数据的消费者（如果有）
+     */
+    void notifyConsumer();
+
+    /**
+     * @brief 唤醒等待空位的生产者（如果有）
+     */
+    void notifyProducer();
+
+    /**
+     * @brief 清空数据队列并按当前实现方式重建环形队列
+     * 调用时不能有其他线程访问队列，因此只在 start() 中调用。
+     */
+    void clearQueue();
+
+    /**
+     * @brief 缓冲池相对队列长度的余量
+     * 除了队列中的帧，生产者正在填充的帧和消费者正在处理的帧也会占用缓冲区。
+     */
+    static const int POOL_SLACK = 4;
+
     /**
      * @brief 线程对象
      * 用于执行 `run` 方法中定义的线程逻辑，派生类需要实现 `run` 方法以确定线程的具体行为。
      */
     std::thread m_thread;
+    /**
+     * @brief 生产者线程绑定的 CPU，为空表示不绑定
+     */
+    std::vector<int> cpu_affinity;
     /**
      * @brief 存放交互数据的队列，采用先进先出（FIFO）策略
      * 该队列用于存储 `FramePtrWrapper` 类型的数据，新数据会被添加到队列尾部，
@@ -141,22 +357,76 @@ protected:
      * 避免数据竞争和不一致的问题。
      */
     std::mutex mutex;
+    /**
+     * @brief 无锁环形队列
+     * 当 `queue_backend` 为 `RingQueue` 时代替 `data_queue` 使用，容量在 `start()` 时按 `max_queue_len` 分配。
+     */
+    SpscRingBuffer<FramePtrWrapper> ring_queue;
+    /**
+     * @brief 数据队列的实现方式
+     */
+    QueueBackend queue_backend = ListQueue;
+    /**
+     * @brief 队列满时的背压策略
+     */
+    std::atomic<BackpressurePolicy> backpressure_policy{DropOldest};
+    /**
+     * @brief 队列统计计数
+     * 分别记录入队帧数、丢帧数和生产者阻塞时间（微秒）。
+     */
+    std::atomic<int64_t> pushed_frames{0};
+    std::atomic<int64_t> dropped_frames{0};
+    std::atomic<int64_t> stall_time_us{0};
+    std::atomic<int64_t> producer_cpu_us{0};
+    // 只由 stop() 置位。生产者自行结束（如读到文件末尾）时 is_exit 为 true 但该标志仍为 false，
+    // 消费者可以继续取完队列中剩余的帧
+    std::atomic<bool> stop_requested{false};
+    /**
+     * @brief 环形队列模式下生产者请求、由消费者执行的丢帧数和丢 GOP 数
+     */
+    std::atomic<int> pending_drop_frames{0};
+    std::atomic<int> pending_drop_gops{0};
+    /**
+     * @brief 丢弃了整个队列后，新到达的帧在遇到关键帧前都要丢弃
+     * 只由生产者读写（clearQueue() 在生产者线程启动前调用）。
+     */
+    std::atomic<bool> skip_to_keyframe{false};
+    /**
+     * @brief 环形队列模式下最近一个入队的关键帧之后（含该关键帧）已入队的帧数
+     * 只由生产者维护。不小于队列长度时说明队列中只有一个 GOP，丢弃最旧的 GOP 会清空整个队列。
+     */
+    size_t frames_since_keyframe = 0;
     /**
      * @brief 当前数据队列的大小
      * 记录 `data_queue` 中当前存储的 `FramePtrWrapper` 对象的数量，方便监控队列状态。
      */
-    int curQueueSize = 0;
+    std::atomic<int> curQueueSize{0};
+    /**
+     * @brief 生产者、消费者阻塞等待使用的互斥锁和条件变量
+     * 只有存在等待者时入队、出队操作才会加锁通知，正常情况下不增加额外开销。
+     */
+    std::mutex wait_mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::atomic<int> consumer_waiters{0}; // 阻塞在 not_empty 上的线程数
+    std::atomic<int> producer_waiters{0}; // 阻塞在 not_full 上的线程数
     /**
      * @brief 数据队列的最大长度
      * 限制 `data_queue` 中能够存储的 `FramePtrWrapper` 对象的最大数量，默认值为 100。
      */
     int max_queue_len = 100;
+    /**
+     * @brief 帧缓冲池
+     * 派生类在确定帧大小后调用 `frame_pool.reset()`，之后从池中获取缓冲区构造 `FramePtrWrapper`，
+     * 避免每帧分配内存。容量随 `max_queue_len` 自动调整。
+     */
+    FrameBufferPool frame_pool;
     /**
      * @brief 线程退出标志
      * 用于控制线程的运行状态，当 `is_exit` 为 `true` 时，表示线程需要退出；
      * 为 `false` 时，表示线程正在运行。
      */
-    bool is_exit = true;
+    std::atomic<bool> is_exit{true};
 };
 
 #endif // THREADPROVIDER_H
@@ -1,4 +1,6 @@
 #include "VideoProvider.h"
+#include <algorithm>
+#include <cmath>
 #include <exception>
 
 VideoProvider::VideoProvider(VideoProvider::VideoType type) : type(type)
@@ -12,19 +14,54 @@ VideoProvider::~VideoProvider()
 
 int VideoProvider::getFps() const
 {
+    // 关键帧频率常常低于每秒一帧，编码器需要至少 1 的帧率
+    if (keyframe_only)
+        return std::max(1, (int)std::lround(keyframe_fps));
     return fps / frame_interval;
 }
 
 int VideoProvider::getHeight() const
 {
-    return height;
+    return out_height > 0 ? out_height : height;
 }
 
 int VideoProvider::getWidth() const
+{
+    return out_width > 0 ? out_width : width;
+}
+
+int VideoProvider::getSourceHeight() const
+{
+    return height;
+}
+
+int VideoProvider::getSourceWidth() const
 {
     return width;
 }
 
+bool VideoProvider::setOutputSize(int width, int height)
+{
+    if (isRunning() || width < 0 || height < 0)
+        return false;
+    out_width = width & ~1;
+    out_height = height & ~1;
+    return true;
+}
+
+int VideoProvider::getOutputPixelFormat() const
+{
+    return out_pix_fmt;
+}
+
+bool VideoProvider::setOutputPixelFormat(int pix_fmt)
+{
+    if (isRunning())
+        return false;
+    out_pix_fmt = pix_fmt;
+    return true;
+}
+
 int VideoProvider::getFrameInterval() const
 {
     return frame_interval;
@@ -37,3 +74,72 @@ bool VideoProvider::setFrameInterval(const int interval)
     frame_interval = interval;
     return true;
 }
+
+
+VideoProvider::OutputMode VideoProvider::getOutputMode() const
+{
+    return output_mode;
+}
+
+bool VideoProvider::setOutputMode(OutputMode mode)
+{
+    if (isRunning())
+        return false;
+    output_mode = mode;
+    return true;
+}
+
+bool VideoProvider::isKeyframeOnly() const
+{
+    return keyframe_only;
+}
+
+bool VideoProvider::setKeyframeOnly(bool enable)
+{
+    if (isRunning())
+        return false;
+    keyframe_only = enable;
+    return true;
+}
+
+VideoProvider::LatencyStats VideoProvider::getLatencyStats() const
+{
+    LatencyStats stats;
+    stats.demux = demux_latency.snapshot();
+    stats.decode = decode_latency.snapshot();
+    stats.convert = convert_latency.snapshot();
+    return stats;
+}
+
+VideoProvider::DecodeStats VideoProvider::getDecodeStats() const
+{
+    DecodeStats stats;
+    stats.decoded_frames = decoded_frames;
+    stats.skipped_packets = skipped_packets;
+    stats.passthrough = passthrough;
+    stats.keyframe_fps = keyframe_fps;
+    return stats;
+}
+
+void VideoProvider::collectMetrics(MetricsWriter &writer, const MetricsWriter::Labels &labels) const
+{
+    ThreadProvider::collectMetrics(writer, labels);
+    const char *name = "video_stage_latency_seconds";
+    const char *help = "Time spent in each processing step per frame or packet.";
+    LatencyStats stats = getLatencyStats();
+    MetricsWriter::Labels stage_labels = labels;
+    stage_labels.emplace_back("stage", "demux");
+    writer.histogram(name, help, stage_labels, stats.demux);
+    stage_labels.back().second = "decode";
+    writer.histogram(name, help, stage_labels, stats.decode);
+    stage_labels.back().second = "convert";
+    writer.histogram(name, help, stage_labels, stats.convert);
+    DecodeStats decode_stats = getDecodeStats();
+    writer.counter("video_decoder_output_frames_total", "Frames output by the decoder.", labels,
+                   (double)decode_stats.decoded_frames);
+    writer.counter("video_decoder_skipped_packets_total", "Packets not sent to the decoder because frame decimation drops them.",
+                   labels, (double)decode_stats.skipped_packets);
+    if (keyframe_only)
+        writer.gauge("video_decoder_keyframe_rate", "Estimated keyframes per second when only keyframes are decoded.", labels,
+                     decode_stats.keyframe_fps);
+}
@@ -23,12 +23,36 @@ public:
         File         // 文件视频源
     };
 
+    /**
+     * @brief 定义输出帧的格式
+     * 
+     * PackedRGB24 输出紧密排列的 RGB24 数据；NativeFrame 直接输出解码器的原生像素格式帧（如 YUV420P、NV12），
+     * 以引用计数的多平面 FramePtrWrapper 交给下游，不做颜色空间转换和拷贝。
+     */
+    enum OutputMode
+    {
+        PackedRGB24 = 0, // 转换为打包的 RGB24
+        NativeFrame      // 保持解码器输出的原生格式
+    };
+
 protected:
-    int width = 0;         // 视频帧的宽度
-    int height = 0;        // 视频帧的高度
+    int width = 0;         // 视频源的宽度
+    int height = 0;        // 视频源的高度
+    int out_width = 0;     // 输出帧的宽度，0 表示与视频源相同
+    int out_height = 0;    // 输出帧的高度，0 表示与视频源相同
+    int out_pix_fmt = -1;  // NativeFrame 模式下输出帧的像素格式，-1 表示保持解码器的原生格式
     int fps = 0;           // 视频的帧率
     int frame_interval = 1;// 视频帧的间隔
+    bool keyframe_only = false; // 是否只解码关键帧
+    double keyframe_fps = 0;    // 只解码关键帧时估计的关键帧频率（每秒），0 表示未知
+    std::atomic<bool> passthrough{false}; // 是否处于直通模式：不解码，由调用者直接读取视频数据包
     VideoType type = Camera; // 视频源的类型，默认为摄像头
+    OutputMode output_mode = PackedRGB24; // 输出帧的格式，默认为 RGB24
+    LatencyHistogram demux_latency;   // 读取一个数据包的耗时
+    LatencyHistogram decode_latency;  // 送入数据包并取出解码帧的耗时
+    LatencyHistogram convert_latency; // 缩放和颜色空间转换（sws）的耗时
+    std::atomic<int64_t> decoded_frames{0};  // 解码器输出的帧数
+    std::atomic<int64_t> skipped_packets{0}; // 抽帧时不送入解码器的数据包数
 
 public:
     /**
@@ -57,24 +81,75 @@ public:
     /**
      * @brief 获取视频的帧率
      * 
+     * 即消费者从队列中取到的帧的帧率：按 frame_interval 抽帧后的帧率；只解码关键帧时为关键帧的频率，
+     * 取整且至少为 1，用于配置下游的编码器。
+     * 
      * @return int 视频的帧率
      */
     int getFps() const;
 
     /**
-     * @brief 获取视频帧的高度
+     * @brief 获取输出视频帧的高度
      * 
-     * @return int 视频帧的高度
+     * 即消费者从队列中取到的帧的高度，设置了输出尺寸时为输出尺寸，否则与视频源相同。
+     * 
+     * @return int 输出视频帧的高度
      */
     int getHeight() const;
 
     /**
-     * @brief 获取视频帧的宽度
+     * @brief 获取输出视频帧的宽度
+     * 
+     * 即消费者从队列中取到的帧的宽度，设置了输出尺寸时为输出尺寸，否则与视频源相同。
      * 
-     * @return int 视频帧的宽度
+     * @return int 输出视频帧的宽度
      */
     int getWidth() const;
 
+    /**
+     * @brief 获取视频源的高度
+     * 
+     * @return int 视频源的高度
+     */
+    int getSourceHeight() const;
+
+    /**
+     * @brief 获取视频源的宽度
+     * 
+     * @return int 视频源的宽度
+     */
+    int getSourceWidth() const;
+
+    /**
+     * @brief 设置输出视频帧的尺寸
+     * 
+     * 解码线程在唯一一次 sws_scale 中直接缩放到该尺寸，下游无需再缩放。
+     * 尺寸会向下取整为偶数以适配 YUV420 色度抽样。只能在线程启动前调用。
+     * 
+     * @param width 输出宽度，0 表示与视频源相同
+     * @param height 输出高度，0 表示与视频源相同
+     * @return bool 设置成功返回 true，参数非法或线程正在运行时返回 false
+     */
+    bool setOutputSize(int width, int height);
+
+    /**
+     * @brief 获取 NativeFrame 模式下输出帧的像素格式
+     * 
+     * @return int 像素格式（AVPixelFormat），-1 表示保持解码器的原生格式
+     */
+    int getOutputPixelFormat() const;
+
+    /**
+     * @brief 设置 NativeFrame 模式下输出帧的像素格式
+     * 
+     * 解码器输出的格式和尺寸都与目标一致时直接引用解码帧，否则做一次转换。
+     * PackedRGB24 模式总是输出 RGB24，不受该设置影响。只能在线程启动前调用。
+     * 
+     * @param pix_fmt 像素格式（AVPixelFormat），-1 表示保持解码器的原生格式
+     * @return bool 设置成功返回 true，线程正在运行时返回 false
+     */
+    bool setOutputPixelFormat(int pix_fmt);
+
     /**
      * @brief 获取视频帧的间隔
      * 
@@ -89,6 +164,84 @@ public:
      * @return bool 设置成功返回 true，失败返回 false
      */
     bool setFrameInterval(int interval);
+
+    /**
+     * @brief 获取输出帧的格式
+     * 
+     * @return OutputMode 输出帧的格式
+     */
+    OutputMode getOutputMode() const;
+
+    /**
+     * @brief 设置输出帧的格式
+     * 
+     * 只能在线程启动前调用。
+     * 
+     * @param mode 输出帧的格式
+     * @return bool 设置成功返回 true，线程正在运行时返回 false
+     */
+    bool setOutputMode(OutputMode mode);
+
+    /**
+     * @brief 判断是否只解码关键帧
+     * 
+     * @return bool 只解码关键帧时返回 true
+     */
+    bool isKeyframeOnly() const;
+
+    /**
+     * @brief 设置是否只解码关键帧
+     * 
+     * 用于预览墙、缩略图等低帧率场景：非关键帧在解封装时丢弃，不送入解码器，每个 GOP 只输出一帧，
+     * 此时忽略 frame_interval。需要在 init() 之前调用，init() 会据此估计关键帧的频率作为 getFps() 的返回值。
+     * 
+     * @param enable 是否只解码关键帧
+     * @return bool 设置成功返回 true，线程正在运行时返回 false
+     */
+    bool setKeyframeOnly(bool enable);
+
+    /**
+     * @brief 解码线程各环节的耗时统计
+     */
+    struct LatencyStats
+    {
+        LatencyHistogram::Snapshot demux;   // 解封装
+        LatencyHistogram::Snapshot decode;  // 解码
+        LatencyHistogram::Snapshot convert; // 缩放和颜色空间转换
+    };
+
+    /**
+     * @brief 解码器的帧数统计
+     *
+     * frame_interval 大于 1 时不需要输出的非参考帧在送入解码器前跳过或由解码器丢弃，
+     * decoded_frames 与源视频帧数的差即为节省的解码量。
+     */
+    struct DecodeStats
+    {
+        int64_t decoded_frames = 0;  // 解码器输出的帧数
+        int64_t skipped_packets = 0; // 未送入解码器的数据包数
+        bool passthrough = false;    // 是否处于直通模式，此时解码器已释放
+        double keyframe_fps = 0;     // 只解码关键帧时估计的关键帧频率（每秒），0 表示未知
+    };
+
+    /**
+     * @brief 获取解码器的帧数统计
+     *
+     * @return DecodeStats 解码帧数、跳过的数据包数和当前的解码模式
+     */
+    DecodeStats getDecodeStats() const;
+
+    /**
+     * @brief 获取解码线程各环节的耗时统计
+     *
+     * @return LatencyStats 解封装、解码、转换的耗时直方图
+     */
+    LatencyStats getLatencyStats() const;
+
+    /**
+     * @brief 在队列统计之外输出解码线程各环节的耗时直方图
+     */
+    void collectMetrics(MetricsWriter &writer, const MetricsWriter::Labels &labels) const override;
 };
 
 #endif // VIDEOPROVIDER_H
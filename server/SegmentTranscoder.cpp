@@ -0,0 +1,309 @@
+#include "SegmentTranscoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "FileVideoProvider.h"
+#include "XMediaEncode.h"
+#include "XRtmp.h"
+#include "CpuTopology.h"
+
+/**
+ * @brief 读取输入文件中视频关键帧的显示时间（微秒，升序）和文件时长
+ *
+ * 只保留第一个视频流的关键帧，与 FileVideoProvider 选择的视频流相同。支持的解封装器（如 MP4）
+ * 按索引跳过非关键帧和其他流的数据，只读取关键帧。
+ */
+static bool read_keyframes(const std::string &url, std::vector<int64_t> &keyframes_us, int64_t &duration_us)
+{
+    AVFormatContext *ctx = NULL;
+    if (avformat_open_input(&ctx, url.c_str(), NULL, NULL) != 0)
+        return false;
+    if (avformat_find_stream_info(ctx, NULL) < 0)
+    {
+        avformat_close_input(&ctx);
+        return false;
+    }
+    int index = -1;
+    for (unsigned int i = 0; i < ctx->nb_streams; ++i)
+    {
+        if (-1 == index && ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+            index = i;
+        else
+            ctx->streams[i]->discard = AVDISCARD_ALL;
+    }
+    if (-1 == index)
+    {
+        avformat_close_input(&ctx);
+        return false;
+    }
+    AVStream *stream = ctx->streams[index];
+    stream->discard = AVDISCARD_NONKEY;
+    duration_us = ctx->duration > 0 ? ctx->duration : 0;
+
+    const AVRational us = {1, 1000000};
+    AVPacket *pkt = av_packet_alloc();
+    while (pkt && av_read_frame(ctx, pkt) >= 0)
+    {
+        if (pkt->stream_index == index && (pkt->flags & AV_PKT_FLAG_KEY) && AV_NOPTS_VALUE != pkt->pts)
+            keyframes_us.push_back(av_rescale_q(pkt->pts, stream->time_base, us));
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+    avformat_close_input(&ctx);
+    std::sort(keyframes_us.begin(), keyframes_us.end());
+    return true;
+}
+
+SegmentTranscoder::SegmentTranscoder(const Config &config) : config(config)
+{
+}
+
+bool SegmentTranscoder::run()
+{
+    err_msg.clear();
+    if (!planSegments())
+        return false;
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (Segment &segment : segments)
+        workers.emplace_back(&SegmentTranscoder::transcodeSegment, this, std::ref(segment));
+    for (std::thread &worker : workers)
+        worker.join();
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        const Segment &segment = segments[i];
+        std::cout << "segment " << i << " frames:" << segment.encoded_frames << " time:" << segment.wall_s << "s"
+                  << std::endl;
+        if (!segment.error.empty() && err_msg.empty())
+            err_msg = "segment " + std::to_string(i) + " failed: " + segment.error;
+    }
+
+    bool ok = err_msg.empty() && concatSegments();
+    removeSegmentFiles();
+    std::cout << "segment transcode " << (ok ? "finished" : "failed") << " in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() << "s" << std::endl;
+    return ok;
+}
+
+const std::vector<SegmentTranscoder::Segment> &SegmentTranscoder::getSegments() const
+{
+    return segments;
+}
+
+const std::string &SegmentTranscoder::getLastError() const
+{
+    return err_msg;
+}
+
+bool SegmentTranscoder::planSegments()
+{
+    segments.clear();
+    if (config.input_url.find("://") != std::string::npos)
+    {
+        err_msg = "segment transcoding requires a local file: " + config.input_url;
+        return false;
+    }
+    std::vector<int64_t> keyframes;
+    int64_t duration_us = 0;
+    if (!read_keyframes(config.input_url, keyframes, duration_us))
+    {
+        err_msg = "open input failed: " + config.input_url;
+        return false;
+    }
+
+    // 段数：CPU 分组数，较短的文件按最短时长减少
+    const CpuTopology::Topology &topo = CpuTopology::get();
+    const int cpus_per_segment = std::max(1, config.cpus_per_segment);
+    int64_t count = config.segments > 0 ? config.segments : std::max(1, topo.usable_cpus / cpus_per_segment);
+    if (config.min_segment_us > 0)
+        count = std::min(count, std::max<int64_t>(1, duration_us / config.min_segment_us));
+
+    // 分段点取均分时间点之后的第一个关键帧，关键帧稀疏时相邻的分段点可能重合，只保留一个
+    std::vector<int64_t> bounds;
+    const int64_t first = keyframes.empty() ? 0 : keyframes.front();
+    for (int64_t i = 1; i < count; ++i)
+    {
+        auto it = std::lower_bound(keyframes.begin(), keyframes.end(), first + duration_us * i / count);
+        if (it == keyframes.end())
+            break;
+        if (*it > (bounds.empty() ? first : bounds.back()))
+            bounds.push_back(*it);
+    }
+
+    // 每段绑定一组相邻的 CPU，CPU 不够分时各段共用
+    std::vector<int> cpus;
+    for (const CpuTopology::CpuInfo &info : topo.cpus)
+        cpus.push_back(info.cpu);
+    segments.resize(bounds.size() + 1);
+    const size_t group = std::max<size_t>(1, cpus.size() / segments.size());
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        Segment &segment = segments[i];
+        segment.start_us = i > 0 ? bounds[i - 1] : INT64_MIN;
+        segment.end_us = i < bounds.size() ? bounds[i] : INT64_MAX;
+        for (size_t j = 0; j < group && !cpus.empty(); ++j)
+            segment.cpus.push_back(cpus[(i * group + j) % cpus.size()]);
+        segment.path = config.output_url + ".part" + std::to_string(i) + ".mp4";
+        std::cout << "segment " << i << " start:" << (i > 0 ? segment.start_us : 0) << "us cpus:" << segment.cpus.size()
+                  << std::endl;
+    }
+    return true;
+}
+
+void SegmentTranscoder::transcodeSegment(Segment &segment)
+{
+    auto begin = std::chrono::steady_clock::now();
+    // 解码器和编码器的内部线程在本线程中创建，继承该段的 CPU 绑定
+    CpuTopology::pin_current_thread(segment.cpus);
+    // 解码的开销远小于编码，每段的 CPU 大部分留给编码器
+    const int cpu_count = std::max(1, (int)segment.cpus.size());
+    const int decoder_threads = std::max(1, cpu_count / 4);
+
+    FileVideoProvider provider(config.input_url.c_str());
+    provider.setOutputMode(VideoProvider::NativeFrame);
+    provider.setBackpressurePolicy(ThreadProvider::BlockProducer);
+    provider.setMaxQueueLength(8);
+    provider.setCpuAffinity(segment.cpus);
+    provider.setDecoderThreads(decoder_threads);
+    provider.setTimeRange(segment.start_us, segment.end_us);
+    if (!provider.init())
+    {
+        segment.error = "open input failed";
+        provider.stop();
+        return;
+    }
+    provider.setOutputPixelFormat(AV_PIX_FMT_YUV420P);
+
+    // 每段的编码器从 IDR 帧开始，使用封闭 GOP，段与段之间的码流互不依赖
+    std::unique_ptr<XMediaEncode> encoder(XMediaEncode::create());
+    encoder->fps = provider.getFps();
+    encoder->inWidth = encoder->outWidth = provider.getWidth();
+    encoder->inHeight = encoder->outHeight = provider.getHeight();
+    encoder->bitrate = config.bitrate;
+    encoder->preset = config.preset;
+    encoder->codecThreads = std::max(1, cpu_count - decoder_threads);
+    encoder->scaleThreads = 1;
+    encoder->closedGop = true;
+    std::unique_ptr<XRtmp> muxer(XRtmp::create());
+    int stream_index = -1;
+    if (!encoder->initScale() || !encoder->initVideoCodec())
+        segment.error = "init encoder failed: " + encoder->getLastError();
+    else if (!muxer->init(segment.path.c_str()) || -1 == (stream_index = muxer->addStream(encoder->vc)) ||
+             !muxer->sendHead())
+        segment.error = "open segment file failed: " + muxer->getLastError();
+    if (!segment.error.empty())
+    {
+        provider.stop();
+        muxer->close();
+        encoder->close();
+        return;
+    }
+
+    provider.start();
+    FramePtrWrapper frame;
+    std::vector<AVPacket *> packets;
+    bool ok = true;
+    bool flushed = false;
+    while (ok && !flushed)
+    {
+        if (provider.popDue(frame, nullptr))
+        {
+            if (0 == segment.encoded_frames)
+                segment.first_frame_us = frame.getTimestamp();
+            AVFrame *yuv = encoder->toYuv(frame);
+            ok = yuv && encoder->encodeVideo(yuv, frame.getTimestamp(), packets);
+            if (ok)
+                ++segment.encoded_frames;
+        }
+        else
+        {
+            // 输入结束，取出编码器缓存的帧
+            ok = encoder->flushVideo(packets);
+            flushed = true;
+        }
+        for (AVPacket *pkt : packets)
+        {
+            ok = muxer->sendFrame(pkt, stream_index) && ok;
+            av_packet_free(&pkt);
+        }
+        packets.clear();
+    }
+    provider.stop();
+    muxer->close();
+    if (!ok)
+        segment.error = "encode failed: " + encoder->getLastError();
+    else if (0 == segment.encoded_frames)
+        segment.error = "no frames decoded";
+    encoder->close();
+    segment.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+bool SegmentTranscoder::concatSegments()
+{
+    std::unique_ptr<XRtmp> muxer(XRtmp::create());
+    int stream_index = -1;
+    AVRational out_time_base = {1, 1000000}; // 第一段文件的时间基，各段的数据包都换算到该时间基
+    const AVRational us = {1, 1000000};
+    AVPacket *pkt = av_packet_alloc();
+    bool ok = pkt != NULL;
+    for (size_t i = 0; ok && i < segments.size(); ++i)
+    {
+        FileVideoProvider reader(segments[i].path.c_str());
+        if (!reader.init() || !reader.enablePassthrough())
+        {
+            err_msg = "open segment file failed: " + segments[i].path;
+            ok = false;
+            break;
+        }
+        const AVStream *stream = reader.getVideoStream();
+        if (0 == i)
+        {
+            // 各段的编码参数相同，输出流的参数取自第一段
+            out_time_base = stream->time_base;
+            if (!muxer->init(config.output_url.c_str()) || -1 == (stream_index = muxer->addStream(stream)) ||
+                !muxer->sendHead())
+            {
+                err_msg = "open output failed: " + muxer->getLastError();
+                ok = false;
+                break;
+            }
+        }
+        // 段文件的第一个数据包是编码的第一帧（IDR 帧），据此把时间戳平移回输入文件的时间，
+        // pts 和 dts 平移相同的量，各段编码延迟相同，拼接处的 dts 仍然单调递增
+        int64_t offset = 0;
+        bool first = true;
+        while (ok && reader.readPacket(pkt, nullptr))
+        {
+            av_packet_rescale_ts(pkt, stream->time_base, out_time_base);
+            if (first && AV_NOPTS_VALUE != pkt->pts)
+                offset = av_rescale_q(segments[i].first_frame_us, us, out_time_base) - pkt->pts;
+            first = false;
+            if (AV_NOPTS_VALUE != pkt->pts)
+                pkt->pts += offset;
+            if (AV_NOPTS_VALUE != pkt->dts)
+                pkt->dts += offset;
+            if (!muxer->sendFrame(pkt, stream_index))
+            {
+                err_msg = "write output failed: " + muxer->getLastError();
+                ok = false;
+            }
+        }
+        reader.stop();
+    }
+    av_packet_free(&pkt);
+    muxer->close();
+    return ok;
+}
+
+void SegmentTranscoder::removeSegmentFiles()
+{
+    for (const Segment &segment : segments)
+        remove(segment.path.c_str());
+}
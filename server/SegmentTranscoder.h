@@ -0,0 +1,100 @@
+#ifndef SEGMENTTRANSCODER_H
+#define SEGMENTTRANSCODER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class SegmentTranscoder
+ * @brief 分段并行转码本地文件：在关键帧处把输入分成若干段，各段同时转码后拼接成一个输出文件。
+ *
+ * 单路转码时解码和编码都是顺序执行的，一个长文件只能用到少数几个核。分段后每段独立定位到起始关键帧，
+ * 拥有自己的解码器和编码器，所有线程绑定到该段的一组 CPU 上；编码器使用封闭 GOP，每段从 IDR 帧开始，
+ * 各段的码流互不依赖。所有段完成后按顺序转发各段的数据包，时间戳换算回输入文件的时间，输出连续。
+ *
+ * 每段先写入输出文件旁边的临时 MP4 文件，拼接完成后删除。只适用于可以随机访问的本地文件。
+ */
+class SegmentTranscoder
+{
+public:
+    /**
+     * @brief 转码配置
+     */
+    struct Config
+    {
+        std::string input_url;            ///< 输入的本地文件
+        std::string output_url;           ///< 输出文件
+        int bitrate = 2000000;            ///< 输出码率（bps）
+        std::string preset;               ///< 软件编码器的预设，为空时使用编码器默认值
+        int segments = 0;                 ///< 分段数，0 表示按可用 CPU 数和 cpus_per_segment 自动选择
+        int cpus_per_segment = 4;         ///< 每段使用的 CPU 数
+        int64_t min_segment_us = 10000000; ///< 每段的最短时长（微秒），较短的文件少分几段
+    };
+
+    /**
+     * @brief 一段的范围和结果
+     */
+    struct Segment
+    {
+        int64_t start_us = INT64_MIN;     ///< 开始时间（微秒，包含），第一段为 INT64_MIN
+        int64_t end_us = INT64_MAX;       ///< 结束时间（微秒，不包含），最后一段为 INT64_MAX
+        std::vector<int> cpus;            ///< 该段的线程绑定到的 CPU
+        std::string path;                 ///< 该段的临时文件
+        int64_t first_frame_us = 0;       ///< 该段编码的第一帧的时间戳（微秒）
+        int64_t encoded_frames = 0;       ///< 编码的帧数
+        double wall_s = 0;                ///< 该段转码的耗时（秒）
+        std::string error;                ///< 失败原因，成功时为空
+    };
+
+    /**
+     * @brief 构造函数，只保存配置
+     *
+     * @param config 转码配置
+     */
+    explicit SegmentTranscoder(const Config &config);
+
+    /**
+     * @brief 执行转码，阻塞到输出文件写完
+     *
+     * @return bool 成功返回 true，失败时通过 getLastError() 获取原因
+     */
+    bool run();
+
+    /**
+     * @brief 获取各段的范围和结果，run() 返回后有效
+     */
+    const std::vector<Segment> &getSegments() const;
+
+    /**
+     * @brief 获取最后一次发生的错误信息
+     */
+    const std::string &getLastError() const;
+
+private:
+    /**
+     * @brief 读取输入的关键帧时间，选出分段点并为每段分配 CPU
+     */
+    bool planSegments();
+
+    /**
+     * @brief 转码一段并写入临时文件，在该段自己的线程中执行
+     */
+    void transcodeSegment(Segment &segment);
+
+    /**
+     * @brief 按顺序把各段临时文件的数据包写入输出文件
+     */
+    bool concatSegments();
+
+    /**
+     * @brief 删除各段的临时文件
+     */
+    void removeSegmentFiles();
+
+    const Config config;
+    std::vector<Segment> segments;
+    std::string err_msg;
+};
+
+#endif // SEGMENTTRANSCODER_H
@@ -0,0 +1,148 @@
+#include "SessionManager.h"
+#include "CpuTopology.h"
+
+SessionManager::SessionManager(int max_sessions) : max_sessions(max_sessions > 0 ? max_sessions : 1)
+{
+}
+
+SessionManager::~SessionManager()
+{
+    removeAllSessions();
+}
+
+bool SessionManager::addSession(const std::string &id, const StreamSession::Config &config)
+{
+    StreamSession::Config session_config = config;
+    if (session_config.name.empty())
+        session_config.name = id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sessions.count(id) || starting_ids.count(id))
+        {
+            err_msg = "session already exists: " + id;
+            return false;
+        }
+        if ((int)(sessions.size() + starting_ids.size()) >= max_sessions)
+        {
+            err_msg = "too many sessions";
+            return false;
+        }
+        // 先占用标识和名额，连接输入输出在锁外进行
+        starting_ids.insert(id);
+        if (numa_balancing && session_config.cpu_node < 0)
+            session_config.cpu_node = CpuTopology::node_for_index(next_node_index++);
+    }
+
+    std::shared_ptr<StreamSession> session(new StreamSession(session_config));
+    bool ok = session->start();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    starting_ids.erase(id);
+    if (!ok)
+    {
+        err_msg = id + ": " + session->getLastError();
+        return false;
+    }
+    sessions[id] = session;
+    return true;
+}
+
+bool SessionManager::removeSession(const std::string &id)
+{
+    std::shared_ptr<StreamSession> session;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = sessions.find(id);
+        if (it == sessions.end())
+        {
+            err_msg = "session not found: " + id;
+            return false;
+        }
+        session = it->second;
+        sessions.erase(it);
+    }
+    // 等待会话的线程退出可能耗时，在锁外执行
+    session->stop();
+    return true;
+}
+
+int SessionManager::removeFinishedSessions()
+{
+    std::vector<std::shared_ptr<StreamSession>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = sessions.begin(); it != sessions.end();)
+        {
+            if (StreamSession::Running != it->second->getState())
+            {
+                finished.push_back(it->second);
+                it = sessions.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    for (auto &session : finished)
+        session->stop();
+    return (int)finished.size();
+}
+
+void SessionManager::removeAllSessions()
+{
+    std::map<std::string, std::shared_ptr<StreamSession>> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        removed.swap(sessions);
+    }
+    for (auto &item : removed)
+        item.second->stop();
+}
+
+int SessionManager::getSessionCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)sessions.size();
+}
+
+int SessionManager::getMaxSessions() const
+{
+    return max_sessions;
+}
+
+std::vector<std::string> SessionManager::getSessionIds() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> ids;
+    ids.reserve(sessions.size());
+    for (auto &item : sessions)
+        ids.push_back(item.first);
+    return ids;
+}
+
+bool SessionManager::getSessionStats(const std::string &id, StreamSession::Stats &stats) const
+{
+    std::shared_ptr<StreamSession> session;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = sessions.find(id);
+        if (it == sessions.end())
+            return false;
+        session = it->second;
+    }
+    stats = session->getStats();
+    return true;
+}
+
+void SessionManager::setNumaBalancing(bool enable)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    numa_balancing = enable;
+}
+
+std::string SessionManager::getLastError() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return err_msg;
+}
@@ -0,0 +1,116 @@
+#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "StreamSession.h"
+
+/**
+ * @class SessionManager
+ * @brief 管理同一进程中的多路转推会话，支持运行时增加、删除会话。
+ *
+ * 所有方法都是线程安全的。会话的启动和停止（连接网络、等待线程退出）在锁外执行，
+ * 一路会话连接缓慢不会阻塞其他会话的增删和查询。会话数受 max_sessions 限制。
+ */
+class SessionManager
+{
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param max_sessions 同时存在的最大会话数
+     */
+    explicit SessionManager(int max_sessions = 256);
+
+    /**
+     * @brief 析构函数，停止所有会话
+     */
+    ~SessionManager();
+
+    SessionManager(const SessionManager &) = delete;
+    SessionManager &operator=(const SessionManager &) = delete;
+
+    /**
+     * @brief 创建并启动一路会话
+     *
+     * @param id 会话标识，不能与已有会话重复
+     * @param config 会话配置
+     * @return bool 启动成功返回 true；标识重复、超过会话数上限或启动失败返回 false
+     */
+    bool addSession(const std::string &id, const StreamSession::Config &config);
+
+    /**
+     * @brief 停止并删除一路会话
+     *
+     * @param id 会话标识
+     * @return bool 会话不存在时返回 false
+     */
+    bool removeSession(const std::string &id);
+
+    /**
+     * @brief 删除所有输入已经结束的会话
+     *
+     * @return int 删除的会话数
+     */
+    int removeFinishedSessions();
+
+    /**
+     * @brief 停止并删除所有会话
+     */
+    void removeAllSessions();
+
+    /**
+     * @brief 获取当前的会话数
+     */
+    int getSessionCount() const;
+
+    /**
+     * @brief 获取最大会话数
+     */
+    int getMaxSessions() const;
+
+    /**
+     * @brief 获取所有会话的标识
+     */
+    std::vector<std::string> getSessionIds() const;
+
+    /**
+     * @brief 获取一路会话的统计信息
+     *
+     * @param id 会话标识
+     * @param stats 输出参数，会话统计信息
+     * @return bool 会话不存在时返回 false
+     */
+    bool getSessionStats(const std::string &id, StreamSession::Stats &stats) const;
+
+    /**
+     * @brief 设置是否把会话轮流绑定到各 NUMA 节点
+     *
+     * 开启后，配置中 cpu_node 小于 0 的会话按创建顺序轮流分配 NUMA 节点，
+     * 一路会话的线程不会在节点之间迁移。只影响之后创建的会话。
+     *
+     * @param enable 是否开启
+     */
+    void setNumaBalancing(bool enable);
+
+    /**
+     * @brief 获取最后一次发生的错误信息
+     */
+    std::string getLastError() const;
+
+private:
+    const int max_sessions;
+    bool numa_balancing = false;
+    int next_node_index = 0;            // 下一路会话分配 NUMA 节点的序号
+    mutable std::mutex mutex;
+    std::map<std::string, std::shared_ptr<StreamSession>> sessions;
+    std::set<std::string> starting_ids; // 正在启动、尚未加入 sessions 的会话
+    std::string err_msg;
+};
+
+#endif // SESSIONMANAGER_H
@@ -0,0 +1,321 @@
+#include "StreamSession.h"
+
+#include <vector>
+
+#include "FileVideoProvider.h"
+#include "XMediaEncode.h"
+#include "XRtmp.h"
+#include "Pipeline.h"
+#include "PacketPtr.h"
+#include "CpuTopology.h"
+#include "FramePacer.h"
+#include "EncoderMetrics.h"
+
+/**
+ * @brief 判断输入的视频流能否不经转码直接转发到输出
+ *
+ * 输出与转码时相同：H.264、尺寸不变、码率不超过配置；抽帧和只解码关键帧需要解码，不能直通。
+ * 输入码率未知（如 RTSP 摄像头）时按可以接受处理。
+ */
+static bool can_passthrough(const StreamSession::Config &config, const AVStream *stream)
+{
+    if (!config.allow_passthrough || config.frame_interval > 1 || config.keyframe_only || !stream)
+        return false;
+    const AVCodecParameters *par = stream->codecpar;
+    if (AV_CODEC_ID_H264 != par->codec_id)
+        return false;
+    if ((config.output_width > 0 && config.output_width != par->width) ||
+        (config.output_height > 0 && config.output_height != par->height))
+        return false;
+    return par->bit_rate <= 0 || par->bit_rate <= config.bitrate;
+}
+
+StreamSession::StreamSession(const Config &config) : config(config)
+{
+}
+
+StreamSession::~StreamSession()
+{
+    stop();
+}
+
+bool StreamSession::start()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (Idle != state)
+    {
+        err_msg = "session already started";
+        return false;
+    }
+    state = Failed;
+
+    // 同一路的所有线程留在同一个 NUMA 节点上，帧数据不跨节点访问
+    std::vector<int> cpus;
+    if (config.cpu_node >= 0)
+        cpus = CpuTopology::node_cpus(config.cpu_node);
+
+    // 输入：网络输入是实时的，队列满时丢弃整个 GOP；文件输入阻塞解码线程，不丢帧
+    const bool live_input = config.input_url.find("://") != std::string::npos;
+    FileVideoProvider *file_provider = new FileVideoProvider(config.input_url.c_str());
+    provider.reset(file_provider);
+    provider->setFrameInterval(config.frame_interval);
+    provider->setKeyframeOnly(config.keyframe_only);
+    provider->setOutputMode(VideoProvider::NativeFrame);
+    provider->setMaxQueueLength(config.decode_queue_len);
+    provider->setBackpressurePolicy(live_input ? ThreadProvider::DropGop : ThreadProvider::BlockProducer);
+    provider->setCpuAffinity(cpus);
+    if (!provider->init())
+    {
+        err_msg = "open input failed: " + config.input_url;
+        release();
+        return false;
+    }
+    // 输入与输出兼容时直通：释放解码器，不创建编码器
+    const AVStream *input_stream = file_provider->getVideoStream();
+    passthrough = can_passthrough(config, input_stream) && file_provider->enablePassthrough();
+    if (!passthrough)
+    {
+        // 解码线程直接输出编码器需要的尺寸和像素格式
+        provider->setOutputSize(config.output_width, config.output_height);
+        provider->setOutputPixelFormat(AV_PIX_FMT_YUV420P);
+
+        // 编码器：输入输出尺寸相同，编码线程数受配置限制
+        encoder.reset(XMediaEncode::create());
+        encoder->fps = provider->getFps();
+        encoder->inWidth = encoder->outWidth = provider->getWidth();
+        encoder->inHeight = encoder->outHeight = provider->getHeight();
+        encoder->bitrate = config.bitrate;
+        encoder->codecThreads = config.codec_threads;
+        encoder->scaleThreads = 1;
+        if (!encoder->initScale() || !encoder->initVideoCodec())
+        {
+            err_msg = "init encoder failed: " + encoder->getLastError();
+            release();
+            return false;
+        }
+    }
+
+    // 封装器：独立的写入线程，网络变慢时按字节预算丢弃整个 GOP
+    muxer.reset(XRtmp::create());
+    muxer->setWriterAffinity(cpus);
+    if (!muxer->init(config.output_url.c_str()) ||
+        -1 == (stream_index = passthrough ? muxer->addStream(input_stream) : muxer->addStream(encoder->vc)) ||
+        !muxer->sendHead() ||
+        !muxer->startAsync(config.output_queue_bytes, config.realtime ? XRtmp::DropGop : XRtmp::BlockProducer))
+    {
+        err_msg = "open output failed: " + muxer->getLastError();
+        release();
+        return false;
+    }
+
+    pipeline.reset(new Pipeline());
+    if (passthrough)
+        buildPassthrough(file_provider);
+    else
+        buildTranscode();
+
+    for (int i = 0; i < pipeline->getStageCount(); ++i)
+        pipeline->getStage(i)->setCpuAffinity(cpus);
+    if (!pipeline->start())
+    {
+        err_msg = "start pipeline failed";
+        release();
+        return false;
+    }
+    // 采集函数在 release() 中先于各组件注销
+    metrics_id = MetricsRegistry::instance().addCollector([this](MetricsWriter &writer) { collectMetrics(writer); });
+    state = Running;
+    return true;
+}
+
+void StreamSession::buildTranscode()
+{
+    provider->start();
+
+    VideoProvider *video_provider = provider.get();
+    XMediaEncode *xe = encoder.get();
+    XRtmp *xr = muxer.get();
+    const int index = stream_index;
+    pacer.reset(config.realtime ? new FramePacer() : nullptr);
+    FramePacer *frame_pacer = pacer.get();
+    auto frames = std::make_shared<BlockingQueue<FramePtrWrapper>>(2);
+    auto packets = std::make_shared<BlockingQueue<PacketPtr>>(16);
+
+    pipeline->addStage(std::unique_ptr<PipelineStage>(new SourceStage<FramePtrWrapper>(
+        "decode", frames,
+        [video_provider, frame_pacer](std::vector<FramePtrWrapper> &out) -> bool {
+            FramePtrWrapper frame;
+            if (!video_provider->popDue(frame, frame_pacer))
+                return false;
+            out.push_back(std::move(frame));
+            return true;
+        })));
+
+    auto encode = new TransformStage<FramePtrWrapper, PacketPtr>(
+        "encode", frames, packets,
+        [xe](FramePtrWrapper &frame, std::vector<PacketPtr> &out) -> bool {
+            AVFrame *yuv = xe->toYuv(frame);
+            if (!yuv)
+                return false;
+            std::vector<AVPacket *> encoded;
+            bool ok = xe->encodeVideo(yuv, frame.getTimestamp(), encoded);
+            // 出错前已经取出的数据包同样交给输出队列，由 PacketPtr 释放
+            for (AVPacket *pkt : encoded)
+                out.emplace_back(pkt);
+            return ok;
+        });
+    encode->setFlushFunction([xe](std::vector<PacketPtr> &out) -> bool {
+        std::vector<AVPacket *> encoded;
+        bool ok = xe->flushVideo(encoded);
+        for (AVPacket *pkt : encoded)
+            out.emplace_back(pkt);
+        return ok;
+    });
+    output_stage = pipeline->addStage(std::unique_ptr<PipelineStage>(encode));
+
+    pipeline->addStage(std::unique_ptr<PipelineStage>(new SinkStage<PacketPtr>(
+        "mux", packets,
+        [xr, index](PacketPtr &pkt) -> bool {
+            return xr->sendFrame(pkt.get(), index);
+        })));
+}
+
+void StreamSession::buildPassthrough(FileVideoProvider *file_provider)
+{
+    XRtmp *xr = muxer.get();
+    const int index = stream_index;
+    // 数据包不能丢弃，迟到时也要送出
+    pacer.reset(config.realtime ? new FramePacer(0) : nullptr);
+    FramePacer *frame_pacer = pacer.get();
+    auto packets = std::make_shared<BlockingQueue<PacketPtr>>(16);
+
+    pipeline->addStage(std::unique_ptr<PipelineStage>(new SourceStage<PacketPtr>(
+        "demux", packets,
+        [file_provider, frame_pacer](std::vector<PacketPtr> &out) -> bool {
+            PacketPtr pkt(av_packet_alloc());
+            if (!pkt || !file_provider->readPacket(pkt.get(), frame_pacer))
+                return false;
+            out.push_back(std::move(pkt));
+            return true;
+        })));
+
+    output_stage = pipeline->addStage(std::unique_ptr<PipelineStage>(new SinkStage<PacketPtr>(
+        "mux", packets,
+        [xr, index](PacketPtr &pkt) -> bool {
+            return xr->sendFrame(pkt.get(), index);
+        })));
+}
+
+void StreamSession::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (Running == state)
+        state = pipeline->isRunning() ? Stopped : Finished;
+    release();
+}
+
+StreamSession::State StreamSession::getState() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // 流水线全部结束说明输入已经处理完
+    if (Running == state && !pipeline->isRunning())
+        return Finished;
+    return state;
+}
+
+StreamSession::Stats StreamSession::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // 资源释放后返回释放前的统计
+    Stats stats = provider ? collectStats() : last_stats;
+    stats.output_fps = provider ? fps_meter.update(stats.encoded_frames) : 0;
+    stats.state = state;
+    if (Running == state && !pipeline->isRunning())
+        stats.state = Finished;
+    return stats;
+}
+
+const StreamSession::Config &StreamSession::getConfig() const
+{
+    return config;
+}
+
+std::string StreamSession::getLastError() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return err_msg;
+}
+
+StreamSession::Stats StreamSession::collectStats() const
+{
+    Stats stats;
+    if (provider)
+    {
+        ThreadProvider::QueueStats queue_stats = provider->getQueueStats();
+        stats.decoded_frames = queue_stats.pushed_frames;
+        stats.dropped_frames = queue_stats.dropped_frames;
+    }
+    if (pacer)
+        stats.late_frames = pacer->getStats().dropped_frames;
+    stats.passthrough = passthrough;
+    if (output_stage)
+    {
+        PipelineStage::Stats stage_stats = output_stage->getStats();
+        stats.encoded_frames = stage_stats.processed;
+        stats.encode_errors = stage_stats.errors;
+    }
+    if (muxer)
+    {
+        XRtmp::WriterStats writer_stats = muxer->getWriterStats();
+        stats.written_packets = writer_stats.written_packets;
+        stats.dropped_packets = writer_stats.dropped_packets;
+        stats.write_errors = writer_stats.write_errors;
+    }
+    return stats;
+}
+
+void StreamSession::collectMetrics(MetricsWriter &writer) const
+{
+    // 在 MetricsRegistry 的锁内调用，不能再获取 mutex；release() 注销采集函数之后才释放组件
+    MetricsWriter::Labels labels;
+    labels.emplace_back("stream", config.name.empty() ? config.output_url : config.name);
+    provider->collectMetrics(writer, labels);
+    pipeline->collectMetrics(writer, labels);
+    if (encoder)
+        EncoderMetrics::collectEncoder(writer, labels, *encoder);
+    EncoderMetrics::collectWriter(writer, labels, muxer->getWriterStats());
+    if (pacer)
+        writer.counter("video_late_frames_total", "Frames dropped by real-time pacing for arriving too late.", labels,
+                       (double)pacer->getStats().dropped_frames);
+    writer.gauge("video_passthrough", "1 if packets are relayed without decoding and re-encoding.", labels,
+                 passthrough ? 1 : 0);
+    if (output_stage)
+        writer.gauge("video_output_fps", "Encoded or relayed frames per second since the previous scrape.", labels,
+                     metrics_fps.update(output_stage->getStats().processed));
+}
+
+void StreamSession::release()
+{
+    if (metrics_id)
+    {
+        MetricsRegistry::instance().removeCollector(metrics_id);
+        metrics_id = 0;
+    }
+    // 先停止输入，数据源不再等待新帧，再停止流水线
+    if (provider)
+        provider->stop();
+    if (pipeline)
+        pipeline->stop();
+    if (encoder)
+        encoder->close();
+    if (muxer)
+        muxer->close();
+    if (provider)
+        last_stats = collectStats();
+    pipeline.reset();
+    output_stage = nullptr;
+    pacer.reset();
+    encoder.reset();
+    muxer.reset();
+    provider.reset();
+}
@@ -0,0 +1,175 @@
+#ifndef STREAMSESSION_H
+#define STREAMSESSION_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "MetricsRegistry.h"
+
+class VideoProvider;
+class FileVideoProvider;
+class XMediaEncode;
+class XRtmp;
+class Pipeline;
+class PipelineStage;
+class FramePacer;
+
+/**
+ * @class StreamSession
+ * @brief 一路转推会话：拉取一路输入（摄像头 RTSP 或文件），编码后推流到一个输出地址。
+ *
+ * 每个会话独立拥有自己的视频提供者、编码器、封装器和流水线，不共享任何全局实例，
+ * 多个会话可以在同一进程中并发运行、随时创建和销毁。队列长度、写入字节预算和编码线程数
+ * 都由配置限定，单个会话占用的内存和线程是有界的。
+ * 输入已经是符合输出要求的 H.264 时自动切换为直通：直接转发输入的数据包，不解码也不重新编码。
+ */
+class StreamSession
+{
+public:
+    /**
+     * @brief 会话配置
+     */
+    struct Config
+    {
+        std::string name;                           ///< 会话名称，作为指标的 stream 标签，为空时使用输出地址
+        std::string input_url;                      ///< 输入地址，本地文件或 RTSP/RTMP 地址
+        std::string output_url;                     ///< 输出地址，RTMP/RTSP 地址或本地文件
+        int output_width = 0;                       ///< 输出宽度，0 表示与输入相同
+        int output_height = 0;                      ///< 输出高度，0 表示与输入相同
+        int bitrate = 2000000;                      ///< 输出码率（bps）
+        int frame_interval = 1;                     ///< 每隔多少帧取一帧
+        bool keyframe_only = false;                 ///< 只解码关键帧，用于低帧率预览，此时 frame_interval 不生效
+        int decode_queue_len = 8;                   ///< 解码队列的最大长度
+        int64_t output_queue_bytes = 2 * 1024 * 1024; ///< 写入队列的字节预算
+        int codec_threads = 1;                      ///< 软件编码器的线程数
+        bool realtime = true;                       ///< 按时间戳节拍推送；false 时尽快处理（离线转码）
+        int cpu_node = -1;                          ///< 解码、编码、封装线程绑定到的 NUMA 节点，-1 表示不绑定
+        bool allow_passthrough = true;              ///< 输入已是兼容的 H.264 时直接转发数据包，不解码也不重新编码
+    };
+
+    /**
+     * @brief 会话状态
+     */
+    enum State
+    {
+        Idle = 0, ///< 尚未启动
+        Running,  ///< 正在运行
+        Finished, ///< 输入结束，所有数据已处理完
+        Failed,   ///< 启动失败
+        Stopped,  ///< 被主动停止
+    };
+
+    /**
+     * @brief 会话统计信息
+     */
+    struct Stats
+    {
+        State state = Idle;
+        int64_t decoded_frames = 0;  ///< 解码线程入队的帧数
+        int64_t dropped_frames = 0;  ///< 解码队列丢弃的帧数
+        int64_t late_frames = 0;     ///< 实时推流时迟到过多被丢弃的帧数
+        bool passthrough = false;    ///< 是否直通转发输入的数据包
+        int64_t encoded_frames = 0;  ///< 编码成功的帧数，直通时为转发的视频数据包数
+        int64_t encode_errors = 0;   ///< 编码失败的帧数，直通时为转发失败的数据包数
+        double output_fps = 0;       ///< 最近两次获取统计之间的编码帧率
+        int64_t written_packets = 0; ///< 写入成功的数据包数
+        int64_t dropped_packets = 0; ///< 写入队列丢弃的数据包数
+        int64_t write_errors = 0;    ///< 写入失败的次数
+    };
+
+    /**
+     * @brief 构造函数，只保存配置，不分配资源
+     *
+     * @param config 会话配置
+     */
+    explicit StreamSession(const Config &config);
+
+    /**
+     * @brief 析构函数，停止会话并释放资源
+     */
+    ~StreamSession();
+
+    StreamSession(const StreamSession &) = delete;
+    StreamSession &operator=(const StreamSession &) = delete;
+
+    /**
+     * @brief 打开输入和输出并启动会话的所有线程
+     *
+     * 连接输入和输出可能耗时较长，调用者不应持有全局锁。
+     *
+     * @return bool 启动成功返回 true，失败时通过 getLastError() 获取原因
+     */
+    bool start();
+
+    /**
+     * @brief 停止会话，丢弃未处理的数据并关闭输入输出
+     */
+    void stop();
+
+    /**
+     * @brief 获取会话状态
+     */
+    State getState() const;
+
+    /**
+     * @brief 获取会话统计信息
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief 获取会话配置
+     */
+    const Config &getConfig() const;
+
+    /**
+     * @brief 获取最后一次发生的错误信息
+     */
+    std::string getLastError() const;
+
+private:
+    /**
+     * @brief 从各组件收集统计信息（调用者需持有 mutex）
+     */
+    Stats collectStats() const;
+
+    /**
+     * @brief 把会话各组件的统计写入指标，由 MetricsRegistry 在导出时调用
+     */
+    void collectMetrics(MetricsWriter &writer) const;
+
+    /**
+     * @brief 创建转码流水线：解码 → 编码 → 封装，并启动解码线程（调用者需持有 mutex）
+     */
+    void buildTranscode();
+
+    /**
+     * @brief 创建直通流水线：读取数据包 → 封装（调用者需持有 mutex）
+     */
+    void buildPassthrough(FileVideoProvider *file_provider);
+
+    /**
+     * @brief 按顺序关闭流水线、输入、编码器和封装器
+     */
+    void release();
+
+    const Config config;
+    std::unique_ptr<VideoProvider> provider;
+    std::unique_ptr<XMediaEncode> encoder;
+    std::unique_ptr<XRtmp> muxer;
+    std::unique_ptr<Pipeline> pipeline;
+    std::unique_ptr<FramePacer> pacer; // 实时推流的节拍定时器，离线转码时为空
+    int metrics_id = 0;                // 在 MetricsRegistry 中注册的采集函数，0 表示未注册
+    mutable RateMeter fps_meter;       // getStats() 使用的帧率计算
+    mutable RateMeter metrics_fps;     // 指标采集使用的帧率计算
+    PipelineStage *output_stage = nullptr; // 统计输出帧数的阶段：转码时为编码阶段，直通时为封装阶段
+    bool passthrough = false;
+    int stream_index = -1;
+    State state = Idle;
+    Stats last_stats; // 资源释放前的最后一次统计
+    mutable std::mutex mutex; // 保护 state、err_msg 和资源的创建与释放
+    std::string err_msg;
+};
+
+#endif // STREAMSESSION_H
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <memory>
+
+#include "EncoderMetrics.h"
+#include "FileVideoProvider.h"
+#include "MetricsRegistry.h"
+#include "Pipeline.h"
+#include "XMediaEncode.h"
+
+/**
+ * @brief 检查一次抓取中没有重复的样本
+ *
+ * 与 main.cpp 的采集函数相同，同一组标签下写入解码端、流水线、编码器和输出的全部指标。
+ * 名称和标签都相同的样本会使 Prometheus 拒绝整次抓取。
+ */
+static bool check_stream_metrics()
+{
+    FileVideoProvider provider("test.mp4");
+    Pipeline pipeline;
+    std::unique_ptr<XMediaEncode> encoder(XMediaEncode::create());
+
+    MetricsWriter writer;
+    MetricsWriter::Labels labels = {{"stream", "test"}};
+    provider.collectMetrics(writer, labels);
+    pipeline.collectMetrics(writer, labels);
+    EncoderMetrics::collectEncoder(writer, labels, *encoder);
+    EncoderMetrics::collectWriter(writer, {{"stream", "test"}, {"output", "test.flv"}}, XRtmp::WriterStats());
+
+    for (const std::string &name : writer.getDuplicates())
+        std::cerr << "duplicate metric: " << name << std::endl;
+    return writer.getDuplicates().empty() && !writer.str().empty();
+}
+
+/**
+ * @brief 检查 MetricsWriter 能发现重复的样本和类型冲突
+ */
+static bool check_duplicate_detection()
+{
+    MetricsWriter writer;
+    MetricsWriter::Labels labels = {{"stream", "test"}};
+    writer.counter("test_frames_total", "Frames.", labels, 1);
+    writer.counter("test_frames_total", "Frames.", {{"stream", "other"}}, 1);
+    writer.counter("test_frames_total", "Other frames.", labels, 2);
+    writer.gauge("test_frames_total", "Frames.", {{"stream", "third"}}, 3);
+    return 2 == writer.getDuplicates().size() && std::string::npos == writer.str().find("Other frames.");
+}
+
+int main()
+{
+    bool ok = true;
+    if (!check_duplicate_detection())
+    {
+        std::cerr << "MetricsWriter did not report duplicate samples" << std::endl;
+        ok = false;
+    }
+    if (!check_stream_metrics())
+    {
+        std::cerr << "stream metrics contain duplicate samples" << std::endl;
+        ok = false;
+    }
+    std::cout << (ok ? "metrics test passed" : "metrics test failed") << std::endl;
+    return ok ? 0 : 1;
+}